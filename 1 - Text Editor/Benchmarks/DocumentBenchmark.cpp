@@ -0,0 +1,479 @@
+/**
+* File:		DocumentBenchmark.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Benchmark suite comparing the Document operations across every backing container. Each operation is run on
+*			a fresh copy of the document, a few times to warm up and then a number of timed repetitions, for documents
+*			made of one or more copies of the input text. The minimum, median and 99th percentile times are reported along
+*			with the number of allocations and bytes allocated by one run, and the size of the input text over the median
+*			time as a throughput, as CSV or JSON so runs can be compared across commits. Before anything is timed, every
+*			tokenizer kernel the processor has must split the input into the same words as operator>>.
+*
+*			This is built separately from the editor, with optimization:
+*				make benchmark
+*				./benchmark_g++.exe --input "input - ISO_IEC 14882-2003(E).txt" --scales 1,2,4 --format json --output results.json
+*/
+
+#include "Library/Document.hpp"
+#include "Library/Rope.hpp"
+#include "Library/Token.hpp"
+#include "Library/Word.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <forward_list>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <list>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// every allocation in the program goes through these, so a run's allocations can be counted
+namespace {
+	std::atomic<std::size_t> allocationCount{ 0 };
+	std::atomic<std::size_t> allocatedBytes{ 0 };
+
+	void * countedAllocate(std::size_t size) {
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+		if (void * memory = std::malloc(size == 0 ? 1 : size)) {
+			return memory;
+		}
+		throw std::bad_alloc();
+	}
+}
+
+void * operator new  (std::size_t size) { return countedAllocate(size); }
+void * operator new[](std::size_t size) { return countedAllocate(size); }
+void operator delete  (void * memory) noexcept { std::free(memory); }
+void operator delete[](void * memory) noexcept { std::free(memory); }
+void operator delete  (void * memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void * memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	struct Options {
+		std::string					input = "input - ISO_IEC 14882-2003(E).txt";
+		std::vector<std::size_t>	scales = { 1, 2, 4 };
+		std::vector<std::string>	backends;			// empty for all of them
+		std::vector<std::string>	operations;			// empty for all of them
+		std::size_t					warmup = 2;
+		std::size_t					repetitions = 15;
+		std::string					format = "csv";
+		std::string					output;				// empty for stdout
+	};
+
+	// the measurements of one operation on one backend at one size
+	struct Result {
+		std::string	backend;
+		std::size_t	scale;
+		std::size_t	words;
+		std::string	operation;
+		std::size_t	repetitions;
+		double		minimum;			// nanoseconds
+		double		median;
+		double		p99;
+		std::size_t	allocations;		// during one run
+		std::size_t	bytes;
+		double		throughput;			// megabytes of input text per second, at the median
+	};
+
+	// the text the documents are made of, in memory and in a file, for one scale
+	struct Input {
+		std::size_t				scale;
+		std::size_t				words;
+		std::string				text;
+		std::filesystem::path	path;
+	};
+
+	// an operation to measure. setup prepares a fresh copy of the document and is not timed; run is
+	template<class D>
+	struct Operation {
+		const char *				name;
+		std::function<void(D &)>	setup;
+		std::function<void(D &)>	run;
+	};
+
+	// a terminology update: pairs of words sampled across the text, each replaced with the pair in upper case
+	std::map<std::string, std::string> terminology(const std::string & text, std::size_t count) {
+		std::vector<std::string> words;
+		std::istringstream stream(text);
+		for (std::string word; stream >> word; ) {
+			words.push_back(std::move(word));
+		}
+
+		std::map<std::string, std::string> terms;
+		for (std::size_t i = 0; words.size() > 1 && i < count; ++i) {
+			const std::size_t position = i * (words.size() - 1) / count;
+			std::string phrase = words[position] + ' ' + words[position + 1];
+			std::string replacement(phrase);
+			std::transform(replacement.begin(), replacement.end(), replacement.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+			terms.emplace(std::move(phrase), std::move(replacement));
+		}
+		return terms;
+	}
+
+	// run fn with a given tokenizer kernel, then go back to the fastest one
+	template<class Function>
+	void withKernel(Library::Tokenizer::Kernel kernel, Function fn) {
+		Library::Tokenizer::use(kernel);
+		fn();
+		Library::Tokenizer::use(Library::Tokenizer::best());
+	}
+
+	// the load from a stream before the tokenizer: operator>> a word at a time, into a container like the document's
+	template<class T, class Allocator>
+	void extractWords(std::forward_list<T, Allocator> & cont, std::istream & stream) {
+		auto itr = cont.before_begin();
+		for (std::string word; stream >> word; ) {
+			itr = cont.emplace_after(itr, Library::streamedWord<T>(word));
+		}
+	}
+
+	template<class ContainerType>
+	void extractWords(ContainerType & cont, std::istream & stream) {
+		for (std::string word; stream >> word; ) {
+			cont.emplace_back(Library::streamedWord<typename ContainerType::value_type>(word));
+		}
+	}
+
+	// the words operator>> reads from text
+	std::vector<std::string> extracted(const std::string & text) {
+		std::vector<std::string> words;
+		std::istringstream stream(text);
+		for (std::string word; stream >> word; ) {
+			words.push_back(std::move(word));
+		}
+		return words;
+	}
+
+	// every kernel the processor has must split the text, in memory and from a stream, exactly where operator>> does
+	void checkTokenizer(const std::string & text) {
+		const std::vector<std::string> expected = extracted(text);
+		for (auto kernel : { Library::Tokenizer::Kernel::Scalar, Library::Tokenizer::Kernel::Sse2, Library::Tokenizer::Kernel::Avx2 }) {
+			if (!Library::Tokenizer::supported(kernel)) {
+				continue;
+			}
+
+			std::vector<std::string> split, streamed;
+			withKernel(kernel, [&] {
+				Library::Tokenizer::split(std::string_view(text), [&](std::string_view word) { split.emplace_back(word); });
+				std::istringstream stream(text);
+				Library::Tokenizer::split(stream, [&](std::string_view word) { streamed.emplace_back(word); });
+			});
+			if (split != expected || streamed != expected) {
+				throw std::runtime_error(std::string("the ") + Library::Tokenizer::name(kernel) + " tokenizer splits the input differently from operator>>");
+			}
+		}
+	}
+
+	// the operations of the edit session in main.cpp, plus loading, copying and searching
+	template<class D>
+	std::vector<Operation<D>> operations(const Input & input, std::istringstream & stream) {
+		auto nothing = [](D &) {};
+		const std::filesystem::path saved = input.path.string() + ".saved";
+		const std::filesystem::path image = input.path.string() + ".image";
+		auto terms = std::make_shared<const std::map<std::string, std::string>>(terminology(input.text, 256));
+		auto dictionary = std::make_shared<const typename D::DictionaryType>(D::dictionary(*terms));
+
+		return {
+			{ "load_stream",		[&](D &) { stream.clear(); stream.str(input.text); },
+									[&](D & doc) { doc.load(stream); } },
+			{ "load_path",			nothing,
+									[&](D & doc) { doc.load(input.path); } },
+			// the stream load as it was before the tokenizer, for comparison
+			{ "load_stream_extract",	[&](D &) { stream.clear(); stream.str(input.text); },
+									[&](D &) { typename D::ContainerType words; extractWords(words, stream); } },
+			// the same loads with the portable and the SSE2 tokenizer, against the fastest one the processor has above
+			{ "load_stream_scalar",	[&](D &) { stream.clear(); stream.str(input.text); },
+									[&](D & doc) { withKernel(Library::Tokenizer::Kernel::Scalar, [&] { doc.load(stream); }); } },
+			{ "load_path_scalar",	nothing,
+									[&](D & doc) { withKernel(Library::Tokenizer::Kernel::Scalar, [&] { doc.load(input.path); }); } },
+			{ "load_path_sse2",		nothing,
+									[&](D & doc) { withKernel(Library::Tokenizer::Kernel::Sse2, [&] { doc.load(input.path); }); } },
+			{ "copy",				nothing,
+									[](D & doc) { D copy(doc); } },
+			{ "move",				nothing,
+									[](D & doc) { D moved(std::move(doc)); doc = std::move(moved); } },
+			{ "snap",				nothing,
+									[](D & doc) { doc.snap(); } },
+			{ "erase",				nothing,
+									[](D & doc) { doc.erase("a string"); } },
+			{ "undo",				[](D & doc) { doc.snap(); doc.erase("a string"); },
+									[](D & doc) { doc.undo(1); } },
+			{ "copy_range",			nothing,
+									[](D & doc) { doc.copy_range("is a directive", "argument less"); } },
+			{ "paste_after",		[](D & doc) { doc.copy_range("is a directive", "argument less"); },
+									[](D & doc) { doc.paste_after("whose remaining"); } },
+			{ "substitute",			nothing,
+									[](D & doc) { doc.substitute("effective length", "ineffective measurement"); } },
+			{ "substitute_common",	nothing,
+									[](D & doc) { doc.substitute("the", "THE"); } },
+			{ "erase_missing",		nothing,
+									[](D & doc) { doc.erase("there's no way this phrase is in there"); } },
+			{ "find_all",			nothing,
+									[](D & doc) { doc.find_all("of the"); } },
+			{ "write_operator",		nothing,
+									[saved](D & doc) { std::ofstream out(saved, std::ios::binary); out << doc; } },
+			{ "save_path",			nothing,
+									[saved](D & doc) { doc.save(saved); } },
+			{ "save_original",		nothing,
+									[saved](D & doc) { doc.save(saved, D::Layout::Original); } },
+			{ "save_image",			nothing,
+									[image](D & doc) { doc.save_image(image); } },
+			{ "load_image",			[image](D & doc) { doc.save_image(image); },
+									[image](D & doc) { doc.load_image(image); } },
+			{ "append_journal",		[image](D & doc) { doc.save_image(image); doc.snap(); doc.erase("a string"); },
+									[](D & doc) { doc.append_journal(); } },
+			{ "substitute_each",	nothing,
+									[terms](D & doc) { for (const auto & term : *terms) { doc.substitute(term.first, term.second); } } },
+			{ "substitute_all",		nothing,
+									[dictionary](D & doc) { doc.substitute_all(*dictionary); } },
+		};
+	}
+
+	bool selected(const std::vector<std::string> & names, const std::string & name) {
+		return names.empty() || std::find(names.cbegin(), names.cend(), name) != names.cend();
+	}
+
+	// nearest rank percentile of sorted samples
+	double percentile(const std::vector<double> & sorted, double fraction) {
+		const auto rank = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size()) + 0.999999);
+		return sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1];
+	}
+
+	template<class D>
+	Result measure(const std::string & backend, const Input & input, const D & base, const Operation<D> & operation, const Options & options) {
+		std::vector<double> samples;
+		std::size_t allocations = 0;
+		std::size_t bytes = 0;
+
+		for (std::size_t i = 0; i < options.warmup + options.repetitions; ++i) {
+			D doc(base);
+			operation.setup(doc);
+
+			const std::size_t allocationsBefore = allocationCount.load();
+			const std::size_t bytesBefore = allocatedBytes.load();
+			const auto start = Clock::now();
+
+			operation.run(doc);
+
+			const auto stop = Clock::now();
+			allocations = allocationCount.load() - allocationsBefore;
+			bytes = allocatedBytes.load() - bytesBefore;
+
+			if (i >= options.warmup) {
+				samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+			}
+		}
+
+		std::sort(samples.begin(), samples.end());
+		return Result{ backend, input.scale, input.words, operation.name, samples.size(),
+			samples.front(), percentile(samples, 0.5), percentile(samples, 0.99), allocations, bytes,
+			static_cast<double>(input.text.size()) * 1e3 / percentile(samples, 0.5) };
+	}
+
+	// measure every selected operation on one backend, at every scale
+	template<class D>
+	void benchmark(const std::string & backend, const std::vector<Input> & inputs, const Options & options, std::vector<Result> & results) {
+		if (!selected(options.backends, backend)) {
+			return;
+		}
+
+		for (const auto & input : inputs) {
+			std::istringstream stream;
+			D base;
+			if (!base.load(input.path)) {
+				throw std::runtime_error("can't read " + input.path.string());
+			}
+
+			for (const auto & operation : operations<D>(input, stream)) {
+				if (selected(options.operations, operation.name)) {
+					results.push_back(measure(backend, input, base, operation, options));
+					std::cerr << backend << " x" << input.scale << ' ' << operation.name << '\n';
+				}
+			}
+		}
+	}
+
+	// the input text repeated once per scale, kept in memory and written to a temporary file for the path loads
+	std::vector<Input> makeInputs(const Options & options) {
+		std::ifstream file(options.input, std::ios::binary);
+		if (!file) {
+			throw std::runtime_error("can't open " + options.input);
+		}
+		std::ostringstream contents;
+		contents << file.rdbuf();
+		std::string text = contents.str();
+		if (!text.empty() && text.back() != '\n') {
+			text += '\n';
+		}
+
+		std::size_t words = 0;
+		std::istringstream counter(text);
+		for (std::string word; counter >> word; ) {
+			++words;
+		}
+
+		std::vector<Input> inputs;
+		for (auto scale : options.scales) {
+			Input input{ scale, words * scale, std::string(), std::filesystem::temp_directory_path() / ("document_benchmark_x" + std::to_string(scale) + ".txt") };
+			input.text.reserve(text.size() * scale);
+			for (std::size_t i = 0; i < scale; ++i) {
+				input.text += text;
+			}
+			std::ofstream(input.path, std::ios::binary) << input.text;
+			inputs.push_back(std::move(input));
+		}
+		return inputs;
+	}
+
+	void writeCsv(std::ostream & out, const std::vector<Result> & results) {
+		out << std::fixed << std::setprecision(0);
+		out << "backend,scale,words,operation,repetitions,min_ns,median_ns,p99_ns,allocations,bytes,mb_per_s\n";
+		for (const auto & result : results) {
+			out << result.backend << ',' << result.scale << ',' << result.words << ',' << result.operation << ','
+				<< result.repetitions << ',' << result.minimum << ',' << result.median << ',' << result.p99 << ','
+				<< result.allocations << ',' << result.bytes << ',' << std::setprecision(1) << result.throughput << std::setprecision(0) << '\n';
+		}
+	}
+
+	void writeJson(std::ostream & out, const std::vector<Result> & results) {
+		out << std::fixed << std::setprecision(0);
+		out << "[\n";
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			const auto & result = results[i];
+			out << "  { \"backend\": \"" << result.backend << "\", \"scale\": " << result.scale << ", \"words\": " << result.words
+				<< ", \"operation\": \"" << result.operation << "\", \"repetitions\": " << result.repetitions
+				<< ", \"min_ns\": " << result.minimum << ", \"median_ns\": " << result.median << ", \"p99_ns\": " << result.p99
+				<< ", \"allocations\": " << result.allocations << ", \"bytes\": " << result.bytes
+				<< ", \"mb_per_s\": " << std::setprecision(1) << result.throughput << std::setprecision(0) << " }"
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "]\n";
+	}
+
+	std::vector<std::string> split(const std::string & list) {
+		std::vector<std::string> items;
+		std::istringstream stream(list);
+		for (std::string item; std::getline(stream, item, ','); ) {
+			if (!item.empty()) {
+				items.push_back(item);
+			}
+		}
+		return items;
+	}
+
+	Options parse(int argc, char * argv[]) {
+		Options options;
+		for (int i = 1; i < argc; ++i) {
+			const std::string option = argv[i];
+			if (i + 1 >= argc) {
+				throw std::invalid_argument("missing value for " + option);
+			}
+			const std::string value = argv[++i];
+
+			if (option == "--input") {
+				options.input = value;
+			}
+			else if (option == "--scales") {
+				options.scales.clear();
+				for (const auto & scale : split(value)) {
+					options.scales.push_back(std::stoul(scale));
+				}
+			}
+			else if (option == "--backends") {
+				options.backends = split(value);
+			}
+			else if (option == "--operations") {
+				options.operations = split(value);
+			}
+			else if (option == "--warmup") {
+				options.warmup = std::stoul(value);
+			}
+			else if (option == "--reps") {
+				options.repetitions = std::max<std::size_t>(std::stoul(value), 1);
+			}
+			else if (option == "--format") {
+				if (value != "csv" && value != "json") {
+					throw std::invalid_argument("format must be csv or json");
+				}
+				options.format = value;
+			}
+			else if (option == "--output") {
+				options.output = value;
+			}
+			else {
+				throw std::invalid_argument("unknown option " + option);
+			}
+		}
+		return options;
+	}
+}
+
+// main routine. Options, each followed by a value:
+//	--input path			text to build the documents from
+//	--scales 1,2,4			number of copies of the text in each document size measured
+//	--backends a,b			only these backends (vector, list, deque, forward_list, rope, vector_word, vector_token)
+//	--operations a,b		only these operations
+//	--warmup n				untimed runs of each operation first
+//	--reps n				timed runs of each operation
+//	--format csv|json
+//	--output path			write the results here instead of stdout
+int main(int argc, char * argv[]) {
+	using Library::Document;
+
+	try {
+		const Options options = parse(argc, argv);
+		const std::vector<Input> inputs = makeInputs(options);
+		if (!inputs.empty()) {
+			checkTokenizer(inputs.front().text);
+		}
+
+		std::vector<Result> results;
+		benchmark<Document<std::vector>>("vector", inputs, options, results);
+		benchmark<Document<std::list>>("list", inputs, options, results);
+		benchmark<Document<std::deque>>("deque", inputs, options, results);
+		benchmark<Document<std::forward_list>>("forward_list", inputs, options, results);
+		benchmark<Document<Library::Rope>>("rope", inputs, options, results);
+		benchmark<Document<std::vector, Library::Word>>("vector_word", inputs, options, results);
+		benchmark<Document<std::vector, Library::Token>>("vector_token", inputs, options, results);
+
+		for (const auto & input : inputs) {
+			std::error_code ignored;
+			std::filesystem::remove(input.path, ignored);
+			std::filesystem::remove(input.path.string() + ".saved", ignored);
+			std::filesystem::remove(input.path.string() + ".image", ignored);
+		}
+
+		std::ofstream file;
+		if (!options.output.empty()) {
+			file.open(options.output);
+		}
+		std::ostream & out = options.output.empty() ? std::cout : file;
+		if (options.format == "json") {
+			writeJson(out, results);
+		}
+		else {
+			writeCsv(out, results);
+		}
+	}
+	catch (const std::exception & error) {
+		std::cerr << error.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,157 @@
+/**
+* File:		BufferedWriter.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the output side of MappedFile: a writer used by Document::save that gathers text into one
+*			large buffer and hands it to a stream or a file descriptor a buffer at a time, instead of making a call (and,
+*			for a stream, a formatted insertion with its sentry and locale checks) for every word.
+*
+*			Usage:
+*				BufferedWriter out(std::filesystem::path("output.txt"));
+*				out.write("text");
+*				out.flush();
+*/
+
+#ifndef BUFFERED_WRITER_HPP
+#define BUFFERED_WRITER_HPP
+
+// includes
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <string_view>
+
+#ifdef _WIN32
+	#include <fcntl.h>
+	#include <io.h>
+	#include <sys/stat.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace Library {
+	class BufferedWriter {
+	public:
+		static constexpr std::size_t BufferSize = std::size_t(1) << 20;
+
+		// what opening a path does to a file that already exists
+		enum class Mode { Truncate, Append };
+
+		// write to a stream
+		explicit BufferedWriter(std::ostream & stream) : _stream(&stream) {}
+
+		// write to an open file descriptor, which is left open
+		explicit BufferedWriter(int descriptor) : _descriptor(descriptor), _good(descriptor >= 0) {}
+
+		// create a file, or truncate or append to an existing one, and write to it. If the file can't be opened, nothing is
+		// written and good() is false
+		explicit BufferedWriter(const std::filesystem::path & path, Mode mode = Mode::Truncate) {
+#ifdef _WIN32
+			const int existing = mode == Mode::Append ? _O_APPEND : _O_TRUNC;
+			_descriptor = _wopen(path.c_str(), _O_WRONLY | _O_CREAT | existing | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+			const int existing = mode == Mode::Append ? O_APPEND : O_TRUNC;
+			_descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | existing, 0644);
+#endif
+			_owned = _descriptor >= 0;
+			_good = _owned;
+		}
+
+		// whatever is still buffered is written out, but a failure can only be seen by calling flush() first
+		~BufferedWriter() noexcept {
+			flush();
+			if (_owned) {
+#ifdef _WIN32
+				_close(_descriptor);
+#else
+				::close(_descriptor);
+#endif
+			}
+		}
+
+		BufferedWriter(const BufferedWriter &) = delete;
+		BufferedWriter & operator=(const BufferedWriter &) = delete;
+
+		void write(std::string_view text) {
+			if (text.empty()) {
+				return;
+			}
+			if (text.size() > BufferSize - _used) {
+				flush();
+				// text that wouldn't fit in an empty buffer either goes straight out
+				if (text.size() >= BufferSize) {
+					send(text.data(), text.size());
+					return;
+				}
+			}
+			std::memcpy(_buffer.get() + _used, text.data(), text.size());
+			_used += text.size();
+		}
+
+		void put(char c) {
+			if (_used == BufferSize) {
+				flush();
+			}
+			_buffer[_used++] = c;
+		}
+
+		// hand the buffer to the stream or file, returning false if anything written so far failed
+		bool flush() {
+			if (_used > 0) {
+				send(_buffer.get(), _used);
+				_used = 0;
+			}
+			if (_stream != nullptr) {
+				_good = _good && static_cast<bool>(_stream->flush());
+			}
+			return _good;
+		}
+
+		bool good() const { return _good; }
+
+	private:
+		void send(const char * data, std::size_t size) {
+			if (!_good) {
+				return;
+			}
+
+			if (_stream != nullptr) {
+				_good = static_cast<bool>(_stream->write(data, static_cast<std::streamsize>(size)));
+				return;
+			}
+
+			// a descriptor may take less than it is given, so keep going until it has all of it
+			while (size > 0) {
+#ifdef _WIN32
+				const int chunk = static_cast<int>(std::min<std::size_t>(size, 1U << 30));
+				const int written = _write(_descriptor, data, static_cast<unsigned>(chunk));
+#else
+				const auto written = ::write(_descriptor, data, size);
+#endif
+				if (written < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					_good = false;
+					return;
+				}
+				data += written;
+				size -= static_cast<std::size_t>(written);
+			}
+		}
+
+		std::unique_ptr<char[]>	_buffer{ new char[BufferSize] };
+		std::size_t				_used = 0;
+		std::ostream *			_stream = nullptr;
+		int						_descriptor = -1;
+		bool					_owned = false;			// the descriptor was opened here, so it is closed here
+		bool					_good = true;
+	};
+}
+
+#endif
@@ -27,11 +27,29 @@
 #define DOCUMENT_HPP
 
 #include <cstddef>      // size_t
+#include <deque>
+#include <filesystem>
 #include <iostream>
-#include <stack>
+#include <limits>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "Library/BufferedWriter.hpp"
+#include "Library/DocumentImage.hpp"
+#include "Library/EditBatch.hpp"
+#include "Library/MappedFile.hpp"
+#include "Library/PhraseDictionary.hpp"
+#include "Library/PhraseSearch.hpp"
+#include "Library/Profiler.hpp"
+#include "Library/ThreadPool.hpp"
+#include "Library/Tokenizer.hpp"
+#include "Library/WordIndex.hpp"
+
 namespace Library
 {
   /****************************************************************
@@ -48,22 +66,46 @@ namespace Library
 
   // Allows using Document like this:
   //        Document<std::vector>, or Document<std::list>
+  //   or, storing each word as an ID in a shared dictionary (see Library/Word.hpp):
+  //        Document<std::vector, Library::Word>
+  //   or, backed by the chunked sequence built for editing (see Library/Rope.hpp):
+  //        Document<Library::Rope>
+  //   or, with an allocator for the words, such as one drawing on an arena that the document and its snapshots live in:
+  //        Document<std::vector, std::pmr::string, std::pmr::polymorphic_allocator<std::pmr::string>> doc(&arena);
   //   but sadly, not this:
   //        Document<std::array> 
-  template < template<class, class> class T1 = std::vector, class T2 = std::string >
+  template < template<class, class> class T1, class T2, class T3 >
+  class SharedDocument;
+
+  template < template<class, class> class T1 = std::vector, class T2 = std::string, class T3 = std::allocator<T2> >
 
   class Document
   {
-    template <template<class, class> class T, class U>
-    friend std::ostream & operator<< (std::ostream & s, const Document<T, U> & document);
+    template <template<class, class> class T, class U, class V>
+    friend std::ostream & operator<< (std::ostream & s, const Document<T, U, V> & document);
+
+    // publishes read-only versions of a document, copying only what readers need (see Library/SharedDocument.hpp)
+    template <template<class, class> class T, class U, class V>
+    friend class SharedDocument;
 
 
     public:
       using ValueType     = T2;
-      using ContainerType = T1< ValueType, std::allocator<ValueType> >;
-
-      // Constructors and destructor
+      using AllocatorType = T3;
+      using ContainerType = T1< ValueType, AllocatorType >;
+      using PhraseType    = std::string;     // phrases are always given as text, whatever ValueType the words are stored as
+      using SearcherType  = PhraseSearcher<ValueType>;
+      using IndexType     = WordIndex<ValueType>;
+      using DictionaryType = PhraseDictionary<ValueType>;
+
+      // How save lays the words out: one per line as operator<< does, or with the spacing they had in the file they were
+      // loaded from
+      enum class Layout { WordPerLine, Original };
+
+      // Constructors and destructor. The document, its copy buffer and its snapshots are allocated with the allocator given,
+      // or a default constructed one. Copies of a document get their allocator the way copies of its container would.
       Document();
+      explicit Document( const AllocatorType & allocator );
       Document( std::istream & in );
       Document( const std::string & phrase );
 
@@ -77,34 +119,129 @@ namespace Library
 
 
 
-      // Load this object with the contents of a stream
+      // Load this object with the contents of a stream. Both loads split the text where operator>> would, a block of bytes
+      // at a time (see Library/Tokenizer.hpp).
       void load(std::istream & stream = std::cin);
 
+      // Load this object with the contents of a file, tokenized in place through a memory mapping. Each word is constructed
+      // from a std::string_view of the mapped text; value types that keep the view (Library::Token) copy nothing at all, and
+      // the mapping is kept for as long as any version of the document, the history or the copy buffer views it. Returns
+      // false, leaving the document as it was, if the file can't be opened and mapped.
+      bool load(const std::filesystem::path & path);
+
+
+      // Write the document out through one large buffer, without copying any word. Original spacing is only known for words
+      // that still view the file they were loaded from (Library::Token loaded by path), and only between words that were next
+      // to each other there; everywhere else words are separated by a space. Returns false if anything failed to be written.
+      bool save(std::ostream & stream, Layout layout = Layout::WordPerLine) const;
+      bool save(const std::filesystem::path & path, Layout layout = Layout::WordPerLine) const;
+      bool save(int descriptor, Layout layout = Layout::WordPerLine) const;
+
 
-      // Snapshot a point in time the document can be restored to later
+      // Save the document, its undo and redo history and the copy buffer as a binary image (see Library/DocumentImage.hpp)
+      // that load_image reopens without tokenizing anything. After either, append_journal adds only the history made since to
+      // the end of the image instead of writing it all again, until what it has appended outgrows the image, when it writes
+      // the image whole again. Each returns false if the image couldn't be written or read; a failed load leaves the document
+      // as it was.
+      bool save_image     (const std::filesystem::path & path);
+      bool append_journal ();
+      bool load_image     (const std::filesystem::path & path);
+
+
+      // Snapshot a point in time the document can be restored to later. Snapshots are copies of the underlying container,
+      // so with a structure-sharing container such as Library::Rope a snapshot is O(1) and shares everything an edit leaves
+      // untouched. undo() moves directly to the requested snapshot, and redo() steps forward again until the next snap().
       void snap();
       void undo( std::size_t quantity = 1U);
+      void redo( std::size_t quantity = 1U);
+
+      // Cap the approximate memory held by the undo and redo history. The oldest snapshots are discarded first.
+      void history_budget( std::size_t bytes );
 
 
       // Copy a section of the document so it can be inserted later
-      void copy_range   (const ValueType & startingPhrase, const ValueType & endingPhrase); 
-      void paste_after  (const ValueType & pasteAfterPhrase);                              
+      void copy_range   (const PhraseType & startingPhrase, const PhraseType & endingPhrase); 
+      void paste_after  (const PhraseType & pasteAfterPhrase);                              
 
 
       // Remove all occurrences of a phrase. The assignment wants a delete function, but "delete" is a C++ reserved key word.  So,
       // following the STL's precedence, I used erase instead.
-      void erase        (const ValueType & phrase);
+      void erase        (const PhraseType & phrase);
 
 
       // Replace all occurrences of a phrase with another phrase
-      void substitute   (const ValueType & oldPhrase, const ValueType & newPhrase);
+      void substitute   (const PhraseType & oldPhrase, const PhraseType & newPhrase);
+
+
+      // Replace, or remove, every occurrence of any of a set of phrases in one pass over the document, however many phrases
+      // there are (see Library/PhraseDictionary.hpp). Where occurrences overlap, the one starting first wins, then the longest.
+      // As with substitute, a phrase mapped to an empty phrase is left alone. Returns the number of occurrences replaced.
+      std::size_t substitute_all (const std::map<PhraseType, PhraseType> & replacements);
+      std::size_t substitute_all (const DictionaryType & dictionary);
+      std::size_t erase_all      (const std::set<PhraseType> & phrases);
+
+      // Compile phrases for substitute_all once, to be used on any number of documents
+      static DictionaryType dictionary (const std::map<PhraseType, PhraseType> & replacements);
+      static DictionaryType dictionary (const std::set<PhraseType> & phrases);
+
+
+      // Apply a batch of edits (see Library/EditBatch.hpp) as if each were called in order, taking one snapshot first so the
+      // whole batch is undone at once. Runs of edits that can't affect each other are applied in one pass over the document.
+      // Returns the number of occurrences each edit replaced, or for paste_after whether it pasted.
+      std::vector<std::size_t> apply (const EditBatch & batch);
+
+
+      // Word positions of every occurrence of a phrase
+      std::vector<std::size_t> find_all (const PhraseType & phrase) const;
+
+
+      // Keep an index of where each word occurs (see Library/WordIndex.hpp). Phrase lookups then only look at the places a
+      // phrase could start, and give up right away when a word of the phrase isn't in the document. Edits update the index
+      // as they go; load, undo and redo have it rebuilt the next time it's needed.
+      void use_index( bool enable = true );
+
+
+      // Split erase, substitute and phrase searches over this many threads (0 for one per hardware thread, 1 to turn it
+      // off). Only containers with random access are split up, and only once the document is large enough to be worth it.
+      // The results are the same as with one thread.
+      void threads( std::size_t count );
 
 
 
     private:
+      // The words of a phrase given to an operation, parsed into a buffer on the stack for as long as the operation runs
+      using PhraseWords   = std::pmr::vector<ValueType>;
+
+      // Versions of the document kept for undo and redo, allocated the way the document is
+      using HistoryType   = std::deque<ContainerType, typename std::allocator_traits<AllocatorType>::template rebind_alloc<ContainerType>>;
+
+      void trimHistory();
+      void pruneSources();
+      bool write(BufferedWriter & out, Layout layout) const;
+      bool writeImage(ImageJournal & journal, bool create) const;
+      void copyRange(const PhraseType & startingPhrase, const PhraseType & endingPhrase, ContainerType & into) const;
+      std::size_t replacePhrase(const PhraseWords & phrase, const PhraseWords & replacement);
+      std::size_t pasteAfter(const PhraseWords & phrase);
+      std::vector<std::size_t> hitsOf(const PhraseWords & phrase) const;
+      IndexType * index() const;
+      bool parallel() const;
+      std::vector<std::size_t> locate(const PhraseWords & phrase, const SearcherType & find, std::size_t from, bool firstOnly) const;
+      std::vector<std::size_t> indexedMatches(const PhraseWords & phrase, std::size_t from, std::size_t limit) const;
+
       ContainerType               _document;
-      std::stack<ContainerType>   _snapshots;      // Undo buffer allowing multiple levels of undo
+      HistoryType                 _snapshots;      // Undo buffer allowing multiple levels of undo, oldest first
+      HistoryType                 _redo;           // Redo buffer holding undone versions, most recently undone last
       ContainerType               _copy_buffer;    // Copy buffer holding a copy of some portion of the document
+      std::size_t                 _history_budget = std::numeric_limits<std::size_t>::max();   // bytes of history to keep
+
+      std::vector<std::shared_ptr<const MappedFile>>  _sources;   // Mapped files words may still be viewing
+
+      mutable std::optional<IndexType>  _index;                 // Positions of each word, if enabled
+      mutable bool                      _index_stale = false;   // The index no longer describes the document
+
+      std::shared_ptr<ThreadPool>       _pool;                  // Threads to split work over, if more than one
+
+      std::shared_ptr<ImageJournal>     _journal;               // Image the history is appended to, if saved or loaded as one
 
   };  // class Document
 }  // namespace Library
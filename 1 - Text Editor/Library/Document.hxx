@@ -5,7 +5,7 @@
 * Purpose:	This file is the header extension containing the implementation of the interface described in Document.hpp.
 *			The functions provided are those of typical operations found in a word processing application.
 *			Supported operations are:
-*			-snapshot/undo
+*			-snapshot/undo/redo
 *			-search/replace
 *			-erase
 *			-copy/paste
@@ -17,17 +17,34 @@
 // includes
 #include <vector>
 #include <forward_list>
+#include <functional>
 #include <utility>
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Library {
 	// borrowed this mechanism of using nameless namespaces from the HW2 sample solution
 	namespace {
+		// containers whose iterators can jump straight to a position
+		template<class ContainerType>
+		struct IsRandomAccess : std::is_base_of<std::random_access_iterator_tag,
+			typename std::iterator_traits<typename ContainerType::iterator>::iterator_category> {};
+
+		// containers whose elements can be assigned through their iterators (Rope's can't, they may be shared)
+		template<class ContainerType>
+		struct IsWritable : std::is_assignable<decltype(*std::declval<ContainerType &>().begin()), typename ContainerType::value_type> {};
+
 		// forward list implmentation of size
-		template<class T>
-		inline auto size(const std::forward_list<T>& cont) {
+		template<class T, class Allocator>
+		inline auto size(const std::forward_list<T, Allocator>& cont) {
 			return std::distance(cont.cbegin(), cont.cend());
 		}
 
@@ -38,16 +55,18 @@ namespace Library {
 		}
 
 		// template function for insertion into fwd list
-		template<class Iterator, class T>
-		inline typename std::forward_list<T>::iterator insert(std::forward_list<T> & cont,
-			typename std::forward_list<T>::const_iterator insertPoint,
+		template<class Iterator, class T, class Allocator>
+		inline typename std::forward_list<T, Allocator>::iterator insert(std::forward_list<T, Allocator> & cont,
+			typename std::forward_list<T, Allocator>::const_iterator insertPoint,
 			const Iterator & insertBegin,
 			const Iterator & insertEnd) {
 
 			// advance to find the point just before the insertion point, then insert after that
 			auto insertBefore = std::next(cont.before_begin(), std::distance(cont.cbegin(), insertPoint));
-		
-			return cont.insert_after(insertBefore, insertBegin, insertEnd);
+			cont.insert_after(insertBefore, insertBegin, insertEnd);
+
+			// like the other containers, return the first element inserted (or the insertion point if nothing was)
+			return std::next(insertBefore);
 			
 		}
 
@@ -58,12 +77,17 @@ namespace Library {
 			const Iterator & insertBegin,
 			const Iterator & insertEnd) {
 
+			// nothing is inserted for an empty range: libstdc++'s deque moves the elements before the insertion point out of the
+			// way and back again in that case, leaving them moved from
+			if (insertBegin == insertEnd) {
+				return cont.erase(insertPoint, insertPoint);
+			}
 			return cont.insert(insertPoint, insertBegin, insertEnd);
 		}
 
 		// template function for erasing from a fwd list
-		template<class Iterator, class T>
-		inline typename std::forward_list<T>::iterator erase(std::forward_list<T> & cont,
+		template<class Iterator, class T, class Allocator>
+		inline typename std::forward_list<T, Allocator>::iterator erase(std::forward_list<T, Allocator> & cont,
 			const Iterator & eraseBegin,
 			const Iterator & eraseEnd) {
 
@@ -81,12 +105,519 @@ namespace Library {
 
 			return cont.erase(eraseBegin, eraseEnd);
 		}		
+
+		// replace every occurrence of a phrase in a fwd list. The node before the current position is carried along with it,
+		// so each hit costs only the words replaced rather than a walk from the head of the list
+		template<class T, class Allocator, class Searcher, class Iterator, class HitFunction>
+		inline std::size_t replaceAll(std::forward_list<T, Allocator> & cont, const Searcher & find,
+			const Iterator & replaceBegin, const Iterator & replaceEnd, HitFunction onHit) {
+
+			std::size_t hits = 0;
+			std::size_t position = 0;				// position in the original list of the node after before
+			auto before = cont.before_begin();
+			auto resume = cont.begin();
+
+			for (auto hit = find(resume, cont.end()); hit != cont.end(); hit = find(resume, cont.end())) {
+				// catch up to the node just before the hit; the search already walked this far
+				while (std::next(before) != hit) {
+					++before;
+					++position;
+				}
+				onHit(position);
+
+				// swap the phrase for the replacement, and continue after the replacement
+				resume = cont.erase_after(before, std::next(hit, find.size()));
+				before = cont.insert_after(before, replaceBegin, replaceEnd);
+				position += find.size();
+				++hits;
+			}
+
+			return hits;
+		}
+
+		// replace every occurrence of a phrase in a container that knows how to do it itself (Rope)
+		template<class ContainerType, class Searcher, class Iterator, class HitFunction>
+		inline auto replaceAll(ContainerType & cont, const Searcher & find,
+			const Iterator & replaceBegin, const Iterator & replaceEnd, HitFunction onHit, int)
+			-> decltype(cont.replace_all(find, replaceBegin, replaceEnd, onHit)) {
+			return cont.replace_all(find, replaceBegin, replaceEnd, onHit);
+		}
+
+		// replace every occurrence of a phrase, scanning the document once from left to right. Replacement text is never
+		// scanned again. onHit is given the position of each occurrence in the original document.
+		//	-random access containers with writable elements (vector, deque) are rewritten in a single pass, compacting in
+		//	 place when the replacement is no longer than the phrase, or growing once and filling from the back otherwise
+		//	-anything else (list) is edited in place at each hit, which is cheap for node based containers
+		template<class ContainerType, class Searcher, class Iterator, class HitFunction>
+		inline std::size_t replaceAll(ContainerType & cont, const Searcher & find,
+			const Iterator & replaceBegin, const Iterator & replaceEnd, HitFunction onHit, long) {
+
+			const auto phraseSize = static_cast<std::ptrdiff_t>(find.size());
+			const auto replaceSize = std::distance(replaceBegin, replaceEnd);
+			std::size_t hits = 0;
+
+			if constexpr (IsRandomAccess<ContainerType>::value && IsWritable<ContainerType>::value) {
+				if (replaceSize <= phraseSize) {
+					// everything between hits slides down over the space the shorter replacements leave behind
+					auto read = cont.begin();
+					auto write = cont.begin();
+					for (auto hit = find(read, cont.end()); hit != cont.end(); hit = find(read, cont.end())) {
+						onHit(static_cast<std::size_t>(hit - cont.begin()));
+						write = (write == read) ? hit : std::move(read, hit, write);
+						write = std::copy(replaceBegin, replaceEnd, write);
+						read = hit + phraseSize;
+						++hits;
+					}
+
+					if (write != read) {
+						write = std::move(read, cont.end(), write);
+						cont.erase(write, cont.end());
+					}
+				}
+				else {
+					// find every hit first so the container only grows once, then slide the text up from the back. The list of
+					// hits is kept between calls on each thread, so once it has grown a substitute allocates only its result
+					thread_local std::vector<std::size_t> positions;
+					positions.clear();
+					for (auto hit = find(cont.begin(), cont.end()); hit != cont.end(); hit = find(hit + phraseSize, cont.end())) {
+						positions.push_back(static_cast<std::size_t>(hit - cont.begin()));
+					}
+
+					hits = positions.size();
+					if (hits > 0) {
+						const auto oldSize = static_cast<std::ptrdiff_t>(cont.size());
+						cont.resize(cont.size() + hits * static_cast<std::size_t>(replaceSize - phraseSize));
+
+						auto read = cont.begin() + oldSize;
+						auto write = cont.end();
+						for (auto position = positions.crbegin(); position != positions.crend(); ++position) {
+							const auto hit = cont.begin() + static_cast<std::ptrdiff_t>(*position);
+							write = std::move_backward(hit + phraseSize, read, write);
+							write = std::copy_backward(replaceBegin, replaceEnd, write);
+							read = hit;
+						}
+
+						for (auto position : positions) {
+							onHit(position);
+						}
+					}
+				}
+			}
+			else {
+				std::size_t position = 0;			// position in the original document of resume
+				auto resume = cont.cbegin();
+				for (auto hit = find(resume, cont.cend()); hit != cont.cend(); hit = find(resume, cont.cend())) {
+					position += static_cast<std::size_t>(std::distance(resume, hit));
+					onHit(position);
+
+					auto pos = Library::erase(cont, hit, std::next(hit, phraseSize));
+					pos = Library::insert(cont, pos, replaceBegin, replaceEnd);
+					resume = std::next(pos, replaceSize);
+					position += static_cast<std::size_t>(phraseSize);
+					++hits;
+				}
+			}
+
+			return hits;
+		}
+
+		template<class ContainerType, class Searcher, class Iterator, class HitFunction>
+		inline std::size_t replaceAll(ContainerType & cont, const Searcher & find,
+			const Iterator & replaceBegin, const Iterator & replaceEnd, HitFunction onHit) {
+			return replaceAll(cont, find, replaceBegin, replaceEnd, onHit, 0);
+		}
+
+		// one range of a document replaced with a range of words
+		template<class Iterator>
+		struct Splice {
+			std::size_t	position;
+			std::size_t	removed;
+			Iterator	first;
+			Iterator	last;
+		};
+
+		// replace ranges of a fwd list, sorted and not overlapping, in one walk down the list
+		template<class T, class Allocator, class Iterator>
+		inline void spliceAll(std::forward_list<T, Allocator> & cont, const std::vector<Splice<Iterator>> & splices) {
+			std::size_t position = 0;				// position in the original list of the node after before
+			auto before = cont.before_begin();
+			for (const auto & splice : splices) {
+				for (; position < splice.position; ++position) {
+					++before;
+				}
+				cont.erase_after(before, std::next(before, static_cast<std::ptrdiff_t>(splice.removed + 1)));
+				before = cont.insert_after(before, splice.first, splice.last);
+				position += splice.removed;
+			}
+		}
+
+		// replace ranges of a container that knows how to do it itself (Rope)
+		template<class ContainerType, class Iterator>
+		inline auto spliceAll(ContainerType & cont, const std::vector<Splice<Iterator>> & splices, int)
+			-> decltype(cont.replace_ranges(splices.cbegin(), splices.cend())) {
+			return cont.replace_ranges(splices.cbegin(), splices.cend());
+		}
+
+		// replace ranges of a container, sorted and not overlapping, in one pass. Random access containers with writable
+		// elements are rewritten in place when every range shrinks (or keeps its size) or every range grows, the same way
+		// replaceAll does, and rebuilt with each element moved once otherwise. Anything else (list) is edited in place at
+		// each range
+		template<class ContainerType, class Iterator>
+		inline void spliceAll(ContainerType & cont, const std::vector<Splice<Iterator>> & splices, long) {
+			if constexpr (IsRandomAccess<ContainerType>::value && IsWritable<ContainerType>::value) {
+				std::size_t total = cont.size();
+				bool shrinks = true;
+				bool grows = true;
+				for (const auto & splice : splices) {
+					const auto added = static_cast<std::size_t>(std::distance(splice.first, splice.last));
+					total = total - splice.removed + added;
+					shrinks = shrinks && added <= splice.removed;
+					grows = grows && added >= splice.removed;
+				}
+
+				if (shrinks) {
+					// everything between ranges slides down over the space the shorter replacements leave behind
+					auto write = cont.begin();
+					auto read = cont.begin();
+					for (const auto & splice : splices) {
+						const auto hit = cont.begin() + static_cast<std::ptrdiff_t>(splice.position);
+						write = (write == read) ? hit : std::move(read, hit, write);
+						write = std::copy(splice.first, splice.last, write);
+						read = hit + static_cast<std::ptrdiff_t>(splice.removed);
+					}
+					if (write != read) {
+						write = std::move(read, cont.end(), write);
+						cont.erase(write, cont.end());
+					}
+				}
+				else if (grows) {
+					// grow once, then slide the text up from the back
+					const auto oldSize = static_cast<std::ptrdiff_t>(cont.size());
+					cont.resize(total);
+					auto read = cont.begin() + oldSize;
+					auto write = cont.end();
+					for (auto splice = splices.crbegin(); splice != splices.crend(); ++splice) {
+						// ranges that keep their size leave the text in place until one grows
+						const auto hit = cont.begin() + static_cast<std::ptrdiff_t>(splice->position);
+						const auto after = hit + static_cast<std::ptrdiff_t>(splice->removed);
+						write = (write == read) ? after : std::move_backward(after, read, write);
+						write = std::copy_backward(splice->first, splice->last, write);
+						read = hit;
+					}
+				}
+				else {
+					ContainerType result(total, cont.get_allocator());
+					auto in = cont.begin();
+					auto out = result.begin();
+					std::size_t position = 0;
+					for (const auto & splice : splices) {
+						out = std::move(in, in + static_cast<std::ptrdiff_t>(splice.position - position), out);
+						out = std::copy(splice.first, splice.last, out);
+						in += static_cast<std::ptrdiff_t>(splice.position + splice.removed - position);
+						position = splice.position + splice.removed;
+					}
+					std::move(in, cont.end(), out);
+
+					cont = std::move(result);
+				}
+			}
+			else {
+				std::size_t position = 0;
+				auto itr = cont.begin();
+				for (const auto & splice : splices) {
+					std::advance(itr, static_cast<std::ptrdiff_t>(splice.position - position));
+					itr = Library::erase(cont, itr, std::next(itr, static_cast<std::ptrdiff_t>(splice.removed)));
+					itr = std::next(Library::insert(cont, itr, splice.first, splice.last), std::distance(splice.first, splice.last));
+					position = splice.position + splice.removed;
+				}
+			}
+		}
+
+		template<class ContainerType, class Iterator>
+		inline void spliceAll(ContainerType & cont, const std::vector<Splice<Iterator>> & splices) {
+			spliceAll(cont, splices, 0);
+		}
+
+		// a searcher that hands out hits found beforehand, one per call, instead of comparing words. It relies on replaceAll
+		// starting at the front of the document and resuming each search right after the previous hit, which tells it where
+		// first is without having to ask
+		class PlannedSearcher {
+		public:
+			PlannedSearcher(const std::vector<std::size_t> & hits, std::size_t size) : _hits(hits), _size(size) {}
+
+			std::size_t size() const { return _size; }
+
+			template<class ForwardIt>
+			ForwardIt operator()(ForwardIt first, ForwardIt last) const {
+				if (_next == _hits.size()) {
+					return last;
+				}
+
+				const std::size_t from = (_next == 0) ? 0 : _hits[_next - 1] + _size;
+				return std::next(first, static_cast<std::ptrdiff_t>(_hits[_next++] - from));
+			}
+
+		private:
+			const std::vector<std::size_t> &	_hits;
+			std::size_t							_size;
+			mutable std::size_t					_next = 0;
+		};
+
+		// keep the leftmost of any overlapping matches, the ones a left to right replacement would find
+		inline std::vector<std::size_t> nonOverlapping(std::vector<std::size_t> matches, std::size_t length) {
+			auto write = matches.begin();
+			for (auto match : matches) {
+				if (write == matches.begin() || match >= *(write - 1) + length) {
+					*write++ = match;
+				}
+			}
+			matches.erase(write, matches.end());
+			return matches;
+		}
+
+		// split a document into pieces for the thread pool: a few per thread so a slow piece doesn't hold the rest up, but
+		// never so small that handing them out costs more than the work
+		inline std::size_t pieceCount(std::size_t elements, const ThreadPool & pool) {
+			constexpr std::size_t minimumPiece = 1 << 14;
+			return std::max<std::size_t>(1, std::min(pool.size() * 4, elements / minimumPiece));
+		}
+
+		// find the positions, at or after from, of every occurrence of a phrase, or only of the first one, searching pieces of
+		// the document in parallel. Each piece is searched a little past its end, so occurrences spanning two pieces are
+		// found by the piece they start in. Occurrences may overlap
+		template<class ContainerType, class Searcher>
+		inline std::vector<std::size_t> parallelMatches(const ContainerType & cont, const Searcher & find, ThreadPool & pool,
+			std::size_t from, bool firstOnly) {
+
+			const std::size_t total = cont.size();
+			const std::size_t length = find.size();
+			if (length == 0 || from >= total) {
+				return std::vector<std::size_t>();
+			}
+
+			const std::size_t pieces = pieceCount(total - from, pool);
+			const std::size_t span = (total - from + pieces - 1) / pieces;
+			std::vector<std::vector<std::size_t>> found(pieces);
+			std::atomic<std::size_t> firstFound(pieces);	// lowest piece with an occurrence, when only the first is wanted
+
+			pool.parallel_for(pieces, [&](std::size_t piece) {
+				// pieces after one that already has an occurrence can't have the first
+				if (firstOnly && piece > firstFound) {
+					return;
+				}
+
+				const std::size_t begin = from + piece * span;
+				const std::size_t end = std::min(total, begin + span);
+				if (begin >= end) {
+					return;
+				}
+
+				const auto first = cont.cbegin();
+				const auto last = first + static_cast<std::ptrdiff_t>(std::min(total, end + length - 1));
+				for (auto hit = find(first + static_cast<std::ptrdiff_t>(begin), last); hit != last; hit = find(std::next(hit), last)) {
+					found[piece].push_back(static_cast<std::size_t>(hit - first));
+					if (firstOnly) {
+						for (auto lowest = firstFound.load(); piece < lowest && !firstFound.compare_exchange_weak(lowest, piece);) {}
+						break;
+					}
+				}
+			});
+
+			std::vector<std::size_t> matches;
+			for (const auto & positions : found) {
+				matches.insert(matches.end(), positions.cbegin(), positions.cend());
+				if (firstOnly && !matches.empty()) {
+					break;
+				}
+			}
+			return matches;
+		}
+
+		// replace the phrase of the given length at each of the (sorted, non-overlapping) hits, rewriting pieces of the
+		// document in parallel. A replacement as long as the phrase is written over it in place; otherwise every element
+		// is moved once into a new container, each piece knowing where its elements land from the hits before it
+		template<class ContainerType, class Iterator>
+		inline void parallelReplace(ContainerType & cont, const std::vector<std::size_t> & hits, std::size_t length,
+			const Iterator & replaceBegin, const Iterator & replaceEnd, ThreadPool & pool) {
+
+			const auto added = static_cast<std::size_t>(std::distance(replaceBegin, replaceEnd));
+
+			if (added == length) {
+				const std::size_t pieces = std::max<std::size_t>(1, std::min(pool.size() * 4, hits.size()));
+				pool.parallel_for(pieces, [&](std::size_t piece) {
+					for (std::size_t i = piece * hits.size() / pieces; i < (piece + 1) * hits.size() / pieces; ++i) {
+						std::copy(replaceBegin, replaceEnd, cont.begin() + static_cast<std::ptrdiff_t>(hits[i]));
+					}
+				});
+				return;
+			}
+
+			const std::size_t total = cont.size();
+			ContainerType result(total - hits.size() * length + hits.size() * added, cont.get_allocator());
+
+			const std::size_t pieces = pieceCount(total, pool);
+			pool.parallel_for(pieces, [&](std::size_t piece) {
+				const std::size_t begin = piece * total / pieces;
+				const std::size_t end = (piece + 1) * total / pieces;
+
+				// the first hit that doesn't end before this piece
+				std::size_t hit = static_cast<std::size_t>(std::partition_point(hits.cbegin(), hits.cend(),
+					[&](std::size_t start) { return start + length <= begin; }) - hits.cbegin());
+
+				for (std::size_t position = begin; position < end;) {
+					if (hit < hits.size() && hits[hit] <= position) {
+						// the piece a hit starts in writes its replacement; the phrase itself is skipped
+						if (hits[hit] == position) {
+							std::copy(replaceBegin, replaceEnd, result.begin() + static_cast<std::ptrdiff_t>(position - hit * length + hit * added));
+						}
+						position = hits[hit++] + length;
+						continue;
+					}
+
+					// elements up to the next hit all move by the same amount
+					const std::size_t stop = std::min(end, hit < hits.size() ? hits[hit] : total);
+					std::move(cont.begin() + static_cast<std::ptrdiff_t>(position), cont.begin() + static_cast<std::ptrdiff_t>(stop),
+						result.begin() + static_cast<std::ptrdiff_t>(position - hit * length + hit * added));
+					position = stop;
+				}
+			});
+
+			cont = std::move(result);
+		}
+
+		// approximate bytes held by a container that can measure its own, possibly shared, storage
+		template<class ContainerType>
+		inline auto footprint(const ContainerType & cont, int) -> decltype(cont.footprint()) {
+			return cont.footprint();
+		}
+
+		// approximate bytes held by a container, counting its elements
+		template<class ContainerType>
+		inline std::size_t footprint(const ContainerType & cont, long) {
+			return static_cast<std::size_t>(Library::size(cont)) * sizeof(typename ContainerType::value_type);
+		}
+
+		// a word read from a stream is only in the read buffer for a moment, so value types that keep a view of their text
+		// (Library::Token) are given a copy to own instead, as operator>> would
+		template<class T>
+		inline T streamedWord(std::string_view word) {
+			if constexpr (ViewsMapping<T>::value) {
+				return T(std::string(word));
+			}
+			else {
+				return T(word);
+			}
+		}
+
+		// a buffer on the stack that an operation parses its phrases into and builds its searchers from, so a phrase of a few
+		// dozen words never touches the heap. Anything that doesn't fit spills over to the heap
+		class PhraseArena {
+		public:
+			static constexpr std::size_t BufferSize = 4096;
+
+			PhraseArena() = default;
+			PhraseArena(const PhraseArena &) = delete;
+			PhraseArena & operator=(const PhraseArena &) = delete;
+
+			std::pmr::memory_resource * resource() { return &_resource; }
+
+		private:
+			alignas(std::max_align_t) unsigned char	_buffer[BufferSize];
+			std::pmr::monotonic_buffer_resource		_resource{ _buffer, BufferSize };
+		};
+
+		// split a phrase into words allocated from a resource. Words only searched for may view the phrase; words that end
+		// up in the document (a replacement) are given their own copy, as streamed words are
+		template<class T>
+		inline std::pmr::vector<T> phraseWords(std::string_view phrase, std::pmr::memory_resource * resource, bool kept) {
+			std::pmr::vector<T> words(resource);
+			Tokenizer::split(phrase, [&](std::string_view word) {
+				words.emplace_back(kept ? streamedWord<T>(word) : T(word));
+			});
+			return words;
+		}
+
+		// template function for reading words from a stream into a fwd list, which uses a different mechanism for adding data to the list
+		template<class T, class Allocator>
+		inline void loadWords(std::forward_list<T, Allocator> & cont, std::istream & stream) {
+			// iterator pointing to before the beginning of the list
+			auto itr = cont.before_begin();
+			Tokenizer::split(stream, [&](std::string_view word) {
+				// emplace item after current position, and return the new position
+				itr = cont.emplace_after(itr, streamedWord<T>(word));
+			});
+		}
+
+		// template function for reading words from a stream into a container
+		template<class ContainerType>
+		inline void loadWords(ContainerType & cont, std::istream & stream) {
+			Tokenizer::split(stream, [&](std::string_view word) {
+				cont.emplace_back(streamedWord<typename ContainerType::value_type>(word));
+			});
+		}
+
+		// template function for splitting text into a fwd list
+		template<class T, class Allocator>
+		inline void loadWords(std::forward_list<T, Allocator> & cont, std::string_view text) {
+			auto itr = cont.before_begin();
+			Tokenizer::split(text, [&](std::string_view word) {
+				itr = cont.emplace_after(itr, word);
+			});
+		}
+
+		// template function for splitting text into a container
+		template<class ContainerType>
+		inline void loadWords(ContainerType & cont, std::string_view text) {
+			Tokenizer::split(text, [&](std::string_view word) {
+				cont.emplace_back(word);
+			});
+		}
+
+		// template function for rebuilding a fwd list from the word IDs of an image
+		template<class T, class Allocator, class Sequence>
+		inline void loadWords(std::forward_list<T, Allocator> & cont, const Sequence & ids, const std::vector<T> & words) {
+			auto itr = cont.before_begin();
+			for (std::size_t i = 0; i < ids.size(); ++i) {
+				itr = cont.insert_after(itr, words[ids[i]]);
+			}
+		}
+
+		// template function for rebuilding a container from the word IDs of an image
+		template<class ContainerType, class Sequence>
+		inline void loadWords(ContainerType & cont, const Sequence & ids, const std::vector<typename ContainerType::value_type> & words) {
+			for (std::size_t i = 0; i < ids.size(); ++i) {
+				cont.emplace_back(words[ids[i]]);
+			}
+		}
+
+		// the text of a word, without copying it
+		template<class Traits, class Allocator>
+		inline std::string_view textOf(const std::basic_string<char, Traits, Allocator> & word) {
+			return word;
+		}
+
+		// words that view their text (Token)
+		template<class T>
+		inline auto textOf(const T & word, int) -> decltype(std::string_view(word.view())) {
+			return word.view();
+		}
+
+		// words that keep their text somewhere it stays put (Word)
+		template<class T>
+		inline auto textOf(const T & word, long) -> std::enable_if_t<std::is_lvalue_reference<decltype(word.str())>::value, std::string_view> {
+			return word.str();
+		}
+
+		template<class T>
+		inline std::string_view textOf(const T & word) {
+			return textOf(word, 0);
+		}
 	}
 
 	// stream operator overload
-	template <template<class, class> class T, class U>
-	inline std::ostream & operator<< (std::ostream & s, const Document<T, U> & document) {
-		for (auto word : document._document) {
+	template <template<class, class> class T, class U, class V>
+	inline std::ostream & operator<< (std::ostream & s, const Document<T, U, V> & document) {
+		for (const auto & word : document._document) {
 			s << word << '\n';
 		}
 
@@ -95,36 +626,48 @@ namespace Library {
 
 
 	// default constructor
-	template < template<class, class> class T1, class T2 >
-	Document<T1, T2>::Document() = default;
+	template < template<class, class> class T1, class T2, class T3 >
+	Document<T1, T2, T3>::Document() = default;
+
+	// constructor allocating with the given allocator
+	template < template<class, class> class T1, class T2, class T3 >
+	Document<T1, T2, T3>::Document(const AllocatorType & allocator) :
+		_document(allocator), _snapshots(typename HistoryType::allocator_type(allocator)), _redo(typename HistoryType::allocator_type(allocator)),
+		_copy_buffer(allocator) {}
 	
 	// constructor initializing with input stream
-	template < template<class, class> class T1, class T2 >
-	Document<T1, T2>::Document(std::istream & in) {
+	template < template<class, class> class T1, class T2, class T3 >
+	Document<T1, T2, T3>::Document(std::istream & in) {
 		load(in);
 	}
 
 	// constructor initializing with string
-	template < template<class, class> class T1, class T2 >
-	Document<T1,T2>::Document(const std::string & phrase) {
+	template < template<class, class> class T1, class T2, class T3 >
+	Document<T1, T2, T3>::Document(const std::string & phrase) {
 		// construct an input stringstream and load with that
 		std::istringstream iss(phrase);
 		load(iss);
 	}
 
 	// copy constructor
-	template < template<class, class> class T1, class T2 >
-	Document<T1, T2>::Document(const Document & other) : 
-		_document(other._document), _snapshots(other._snapshots), _copy_buffer(other._copy_buffer) {}
+	template < template<class, class> class T1, class T2, class T3 >
+	Document<T1, T2, T3>::Document(const Document & other) : 
+		_document(other._document), _snapshots(other._snapshots), _redo(other._redo), _copy_buffer(other._copy_buffer),
+		_history_budget(other._history_budget), _sources(other._sources), _index(other._index), _index_stale(other._index_stale),
+		_pool(other._pool) {}
 
-	// rvalue reference copy constructor
-	template < template<class, class> class T1, class T2 >
-	Document<T1, T2>::Document(Document && other) : 
-		_document(other._document), _snapshots(other._snapshots), _copy_buffer(other._copy_buffer) {}
+	// rvalue reference constructor, taking everything the other document holds without copying any of it. The image journal,
+	// if any, goes with the document: two documents must never append to the same image
+	template < template<class, class> class T1, class T2, class T3 >
+	Document<T1, T2, T3>::Document(Document && other) : 
+		_document(std::move(other._document)), _snapshots(std::move(other._snapshots)), _redo(std::move(other._redo)),
+		_copy_buffer(std::move(other._copy_buffer)), _history_budget(other._history_budget), _sources(std::move(other._sources)),
+		_index(std::move(other._index)), _index_stale(other._index_stale), _pool(std::move(other._pool)),
+		_journal(std::move(other._journal)) {}
 
 	// destructor
-	template < template<class, class> class T1, class T2 >
-	Document<T1, T2>::~Document() noexcept
+	template < template<class, class> class T1, class T2, class T3 >
+	Document<T1, T2, T3>::~Document() noexcept
 	{
 
 	}
@@ -132,165 +675,912 @@ namespace Library {
 	// operator overloads ------------------------------------------------
 	// operator = overload for lvalue reference
 	// use the copy-and-swap idiom, to guarantee that no exception will be thrown during construction
-	template < template<class, class> class T1, class T2 >
-	Document<T1,T2> & Document<T1, T2>::operator=(const Document &  rhs) {
-		Document<T1, T2> copy(rhs);  // copy
+	template < template<class, class> class T1, class T2, class T3 >
+	Document<T1, T2, T3> & Document<T1, T2, T3>::operator=(const Document &  rhs) {
+		Document<T1, T2, T3> copy(rhs);  // copy
 		// swap
 		std::swap(_copy_buffer, copy._copy_buffer);
 		std::swap(_snapshots, copy._snapshots);
+		std::swap(_redo, copy._redo);
 		std::swap(_document, copy._document);
+		std::swap(_history_budget, copy._history_budget);
+		std::swap(_sources, copy._sources);
+		std::swap(_index, copy._index);
+		std::swap(_index_stale, copy._index_stale);
+		std::swap(_pool, copy._pool);
+		// the history is another document's now, so it no longer goes to this one's image
+		_journal.reset();
 		// return
 		return *this;
 	}
 
 	// operator = overload for rvalue reference
-	template < template<class, class> class T1, class T2 >
-	Document<T1, T2> & Document<T1, T2>::operator=(Document &&  rhs) {
+	template < template<class, class> class T1, class T2, class T3 >
+	Document<T1, T2, T3> & Document<T1, T2, T3>::operator=(Document &&  rhs) {
 		std::swap(rhs._copy_buffer, this->_copy_buffer);
 		std::swap(rhs._document, this->_document);
 		std::swap(rhs._snapshots, this->_snapshots);		
+		std::swap(rhs._redo, this->_redo);
+		std::swap(rhs._history_budget, this->_history_budget);
+		std::swap(rhs._sources, this->_sources);
+		std::swap(rhs._index, this->_index);
+		std::swap(rhs._index_stale, this->_index_stale);
+		std::swap(rhs._pool, this->_pool);
+		std::swap(rhs._journal, this->_journal);
 
 		return *this;
 	}
 	
-	// push a snapshot of the document onto the stack
-	template < template<class, class> class T1, class T2 >
-	inline void Document<T1,T2>::snap() {
-		_snapshots.push(_document);
+	// push a snapshot of the document onto the stack. Taking a new snapshot starts a new line of history, so anything that
+	// could have been redone is dropped
+	template < template<class, class> class T1, class T2, class T3 >
+	inline void Document<T1, T2, T3>::snap() {
+		PROFILE_SCOPE("snap");
+		_snapshots.push_back(_document);
+		_redo.clear();
+
+		trimHistory();
 	}
 	
-	// undo the specified quantity of operations
-	template < template<class, class> class T1, class T2 >
-	inline void Document<T1, T2>::undo(std::size_t quantity) {
-		// do nothing if no quantity or greater or equal to the stack size
-		if (quantity > 0 && quantity < _snapshots.size() ) {
-			for (unsigned int i = 0; i < quantity; i++) {
-				_document = _snapshots.top(); // pop off the documents until the desired count is reached
-				_snapshots.pop();
+	// undo the specified quantity of operations, moving straight to the target snapshot. The current document and every
+	// snapshot passed over are kept on the redo buffer
+	template < template<class, class> class T1, class T2, class T3 >
+	inline void Document<T1, T2, T3>::undo(std::size_t quantity) {
+		// do nothing if no quantity or greater than the stack size
+		PROFILE_SCOPE("undo");
+		if (quantity > 0 && quantity <= _snapshots.size() ) {
+			_redo.push_back(std::move(_document));
+			for (std::size_t i = 1; i < quantity; i++) {
+				_redo.push_back(std::move(_snapshots.back()));
+				_snapshots.pop_back();
+			}
+
+			_document = std::move(_snapshots.back());
+			_snapshots.pop_back();
+			_index_stale = true;
+
+			if (_journal) {
+				_journal->popped(_snapshots.size());
 			}
 		}
 	}
 
-	// function specialization for forward_list, which uses a different mechanism for adding data to the list
-	template<>
-	inline void Document<std::forward_list>::load(std::istream & stream) {
-		_document.clear(); // clear the document
+	// redo the specified quantity of undone operations
+	template < template<class, class> class T1, class T2, class T3 >
+	inline void Document<T1, T2, T3>::redo(std::size_t quantity) {
+		// do nothing if no quantity or greater than the redo buffer size
+		PROFILE_SCOPE("redo");
+		if (quantity > 0 && quantity <= _redo.size()) {
+			_snapshots.push_back(std::move(_document));
+			for (std::size_t i = 1; i < quantity; i++) {
+				_snapshots.push_back(std::move(_redo.back()));
+				_redo.pop_back();
+			}
 
-		ValueType val;
-		// iterator pointing to before the beginning of the list
-		auto itr = _document.before_begin();
+			_document = std::move(_redo.back());
+			_redo.pop_back();
+			_index_stale = true;
+		}
+	}
 
-		// while stream data remains
-		while (stream >> val) {
-			// emplace item after current position, and return the new position
-			itr = _document.emplace_after(itr, std::move(val));
+	// set the history budget, discarding history right away if it is already over
+	template < template<class, class> class T1, class T2, class T3 >
+	inline void Document<T1, T2, T3>::history_budget(std::size_t bytes) {
+		_history_budget = bytes;
+
+		trimHistory();
+	}
+
+	// discard the oldest snapshots, then the furthest redo versions, until the history fits in its budget
+	template < template<class, class> class T1, class T2, class T3 >
+	void Document<T1, T2, T3>::trimHistory() {
+		// measuring can walk every snapshot, so only do it when a budget has been set
+		if (_history_budget == std::numeric_limits<std::size_t>::max()) {
+			return;
+		}
+
+		std::size_t total = 0;
+		for (const auto & version : _snapshots) {
+			total += Library::footprint(version, 0);
+		}
+		for (const auto & version : _redo) {
+			total += Library::footprint(version, 0);
+		}
+
+		while (total > _history_budget && !_snapshots.empty()) {
+			total -= Library::footprint(_snapshots.front(), 0);
+			_snapshots.pop_front();
+			if (_journal) {
+				_journal->trimmed();
+			}
+		}
+		while (total > _history_budget && !_redo.empty()) {
+			total -= Library::footprint(_redo.front(), 0);
+			_redo.pop_front();
 		}
 	}
 
-	// default template version for load, which loads data from the stream into the document
-	template < template<class, class> class T1, class T2 >
-	inline void Document<T1, T2>::load(std::istream & stream ) {
+	// write the document to a stream
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::save(std::ostream & stream, Layout layout) const {
+		BufferedWriter out(stream);
+		return write(out, layout);
+	}
+
+	// write the document to a file, replacing it if it already exists. The text is written next to the file and then moved over
+	// it, so words still viewing the file they were loaded from (Library::Token) can be saved back to it. MappedFile opens files
+	// shared for delete, which is what lets the move go through on Windows
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::save(const std::filesystem::path & path, Layout layout) const {
+		const std::filesystem::path partial(path.string() + ".partial");
+		bool saved;
+		{
+			BufferedWriter out(partial);
+			saved = write(out, layout);
+		}
+
+		std::error_code error;
+		if (saved) {
+			std::filesystem::rename(partial, path, error);
+		}
+		if (!saved || error) {
+			std::filesystem::remove(partial, error);
+			return false;
+		}
+		return true;
+	}
+
+	// write the document to an open file descriptor
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::save(int descriptor, Layout layout) const {
+		BufferedWriter out(descriptor);
+		return write(out, layout);
+	}
+
+	// write each word, and what separates it from the one before, into the buffer
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::write(BufferedWriter & out, Layout layout) const {
+		PROFILE_SCOPE("save");
+		if (!out.good()) {
+			return false;
+		}
+
+		if (layout == Layout::WordPerLine) {
+			for (const auto & word : _document) {
+				out.write(Library::textOf(word));
+				out.put('\n');
+			}
+			return out.flush();
+		}
+
+		// pointers into different objects are only ordered through std::less
+		const std::less<const char *> before;
+		auto contains = [&](std::string_view text, const char * pos) {
+			return !before(pos, text.data()) && !before(text.data() + text.size(), pos);
+		};
+		auto isSpace = [](char c) {
+			return c == ' ' || (c >= '\t' && c <= '\r');
+		};
+
+		std::string_view source;			// mapped text the previous word views, if any
+		const char * previousEnd = nullptr;
+		bool first = true;
+		for (const auto & word : _document) {
+			const std::string_view text = Library::textOf(word);
+
+			if (!first) {
+				// the text between two words that view the same file in order is what separated them there, as long as nothing
+				// but whitespace was between them
+				std::string_view gap;
+				if (previousEnd != nullptr && contains(source, text.data()) && !before(text.data(), previousEnd)) {
+					gap = std::string_view(previousEnd, static_cast<std::size_t>(text.data() - previousEnd));
+				}
+				if (!gap.empty() && std::all_of(gap.cbegin(), gap.cend(), isSpace)) {
+					out.write(gap);
+				}
+				else {
+					out.put(' ');
+				}
+			}
+			first = false;
+			out.write(text);
+
+			if constexpr (ViewsMapping<ValueType>::value) {
+				if (!contains(source, text.data())) {
+					source = std::string_view();
+					for (const auto & mapped : _sources) {
+						if (contains(mapped->view(), text.data())) {
+							source = mapped->view();
+							break;
+						}
+					}
+				}
+				previousEnd = source.empty() ? nullptr : text.data() + text.size();
+			}
+		}
+		if (!first) {
+			out.put('\n');
+		}
+		return out.flush();
+	}
+
+	// save the document and its history as a new image, which later calls to append_journal add to
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::save_image(const std::filesystem::path & path) {
+		auto journal = std::make_shared<ImageJournal>(path);
+		const bool saved = writeImage(*journal, true);
+		_journal = saved ? std::move(journal) : nullptr;
+		return saved;
+	}
+
+	// append the history made since the image was saved, loaded or last appended to, or write the image whole again once what
+	// was appended outgrows it
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::append_journal() {
+		if (!_journal || !_journal->good()) {
+			return false;
+		}
+		if (_journal->oversized()) {
+			const std::filesystem::path path = _journal->path();
+			return save_image(path);
+		}
+		return writeImage(*_journal, false);
+	}
+
+	// gather the snapshots the image doesn't have yet, then the document, the copy buffer and the redo versions, and write them
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::writeImage(ImageJournal & journal, bool create) const {
+		PROFILE_SCOPE("save_image");
+		auto gather = [&journal](const ContainerType & words) {
+			journal.sequence();
+			for (const auto & word : words) {
+				journal.push(Library::textOf(word));
+			}
+		};
+
+		const std::size_t kept = journal.kept();
+		for (auto snapshot = std::next(_snapshots.cbegin(), static_cast<std::ptrdiff_t>(kept)); snapshot != _snapshots.cend(); ++snapshot) {
+			gather(*snapshot);
+		}
+		gather(_document);
+		gather(_copy_buffer);
+		for (const auto & version : _redo) {
+			gather(version);
+		}
+		return journal.write(_snapshots.size() - kept, _redo.size(), _snapshots.size(), create);
+	}
+
+	// replace the document and its history with an image's. Each distinct word is made once; value types that keep a view
+	// (Library::Token) view the mapped image and copy nothing
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::load_image(const std::filesystem::path & path) {
+		PROFILE_SCOPE("load_image");
+		auto source = std::make_shared<const MappedFile>(path);
+		const ImageReader image(source->view());
+		if (!image.good()) {
+			return false;
+		}
+
+		std::vector<ValueType> words;
+		words.reserve(image.words().size());
+		for (auto word : image.words()) {
+			words.emplace_back(word);
+		}
+		auto rebuild = [this, &words](const ImageReader::Sequence & ids) {
+			ContainerType cont(_document.get_allocator());
+			Library::loadWords(cont, ids, words);
+			return cont;
+		};
+
+		_document = rebuild(image.document());
+		_copy_buffer = rebuild(image.copy_buffer());
+		_snapshots.clear();
+		for (const auto & snapshot : image.snapshots()) {
+			_snapshots.push_back(rebuild(snapshot));
+		}
+		_redo.clear();
+		for (const auto & version : image.redo()) {
+			_redo.push_back(rebuild(version));
+		}
+		_index_stale = true;
+
+		// nothing from before refers to an older mapping any more
+		_sources.clear();
+		if (ViewsMapping<ValueType>::value) {
+			_sources.push_back(std::move(source));
+		}
+
+		// keep appending to the image. The IDs given out must be the image's, so an image that repeats a word isn't appended to
+		auto journal = std::make_shared<ImageJournal>(path);
+		for (auto word : image.words()) {
+			journal->id(word);
+		}
+		journal->opened(_snapshots.size(), source->view().size());
+		_journal = journal->size() == image.words().size() ? std::move(journal) : nullptr;
+
+		trimHistory();
+		return true;
+	}
+
+	// load data from the stream into the document
+	template < template<class, class> class T1, class T2, class T3 >
+	inline void Document<T1, T2, T3>::load(std::istream & stream ) {
+		PROFILE_SCOPE("load");
+		_document.clear(); // clear the document
+
+		Library::loadWords(_document, stream);
+		_index_stale = true;
+	}
+
+	// load data from a memory mapped file into the document
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::load(const std::filesystem::path & path) {
+		PROFILE_SCOPE("load_mapped");
+		auto source = std::make_shared<const MappedFile>(path);
+		if (!source->is_open()) {
+			return false;
+		}
+
 		_document.clear(); // clear the document
+		Library::loadWords(_document, source->view());
+		_index_stale = true;
 
-		ValueType val;
-		while (stream >> val) {
-			_document.emplace_back(val);
+		// words that view the mapping need it for as long as they, or copies of them in the history, exist. Files the
+		// document replaced may not be needed any more
+		if constexpr (ViewsMapping<ValueType>::value) {
+			pruneSources();
+			if (!_document.empty()) {
+				_sources.push_back(std::move(source));
+			}
 		}
+		return true;
+	}
+
+	// drop the mapped files that no version of the document, the history or the copy buffer views any more. Each is looked for
+	// until a word viewing it turns up, so a file still in use is usually found within a few words
+	template < template<class, class> class T1, class T2, class T3 >
+	void Document<T1, T2, T3>::pruneSources() {
+		// pointers into different objects are only ordered through std::less
+		const std::less<const char *> before;
+		auto views = [&before](const ContainerType & words, std::string_view mapped) {
+			return std::any_of(words.cbegin(), words.cend(), [&](const ValueType & word) {
+				const char * text = Library::textOf(word).data();
+				return !before(text, mapped.data()) && before(text, mapped.data() + mapped.size());
+			});
+		};
+		auto viewed = [&](const std::shared_ptr<const MappedFile> & source) {
+			const std::string_view mapped = source->view();
+			return views(_document, mapped) || views(_copy_buffer, mapped)
+				|| std::any_of(_snapshots.cbegin(), _snapshots.cend(), [&](const ContainerType & version) { return views(version, mapped); })
+				|| std::any_of(_redo.cbegin(), _redo.cend(), [&](const ContainerType & version) { return views(version, mapped); });
+		};
+		_sources.erase(std::remove_if(_sources.begin(), _sources.end(), [&](const auto & source) { return !viewed(source); }), _sources.end());
 	}
 
 	// copy a range of text between start phrase and end phrase
-	template < template<class, class> class T1, class T2 >
-	void Document<T1,T2>::copy_range(const ValueType & startingPhrase, const ValueType & endingPhrase) {
+	template < template<class, class> class T1, class T2, class T3 >
+	void Document<T1, T2, T3>::copy_range(const PhraseType & startingPhrase, const PhraseType & endingPhrase) {
+		PROFILE_SCOPE("copy_range");
+		copyRange(startingPhrase, endingPhrase, _copy_buffer);
+	}
+
+	// copy the words from the first occurrence of a phrase through the next occurrence of another into a container, leaving
+	// it alone if either isn't found
+	template < template<class, class> class T1, class T2, class T3 >
+	void Document<T1, T2, T3>::copyRange(const PhraseType & startingPhrase, const PhraseType & endingPhrase, ContainerType & into) const {
 		// determine if the phrases are valid
 		if ( !(startingPhrase.empty() || endingPhrase.empty()) ) {
-			// turn these phrases into documents and use the underlying containers
-			const ContainerType startDoc(Document(startingPhrase)._document);
-			const ContainerType endDoc(Document(endingPhrase)._document);
+			// split these phrases into words and build searchers from them
+			PhraseArena arena;
+			const auto startDoc = phraseWords<ValueType>(startingPhrase, arena.resource(), false);
+			const auto endDoc = phraseWords<ValueType>(endingPhrase, arena.resource(), false);
+			const SearcherType findStart(startDoc.cbegin(), startDoc.cend(), arena.resource());
+			const SearcherType findEnd(endDoc.cbegin(), endDoc.cend(), arena.resource());
+
+			if (index() || parallel()) {
+				// look the phrases up, or search for them in parallel
+				const auto startPos = locate(startDoc, findStart, 0, true);
+				if (!startPos.empty()) {
+					const auto endPos = locate(endDoc, findEnd, startPos.front() + findStart.size(), true);
+					if (!endPos.empty()) {
+						const auto first = std::next(_document.cbegin(), startPos.front());
+						into.assign(first, std::next(first, endPos.front() + findEnd.size() - startPos.front()));
+					}
+				}
+				return;
+			}
 
 			// search for the position of the starting phrase
-			auto startPos = std::search(_document.cbegin(), _document.cend(),
-				startDoc.cbegin(), startDoc.cend());
+			auto startPos = findStart(_document.cbegin(), _document.cend());
 
 			// if the position was found before the end, we can locate the ending phrase next
 			if (startPos != _document.cend()) {
-				auto endPos = std::search(std::next(startPos, Library::size(startDoc)), _document.cend(),
-					endDoc.cbegin(), endDoc.cend());
+				auto endPos = findEnd(std::next(startPos, findStart.size()), _document.cend());
 
-				// if the end position was found before the document end, we can assign this range to the copy buffer
+				// if the end position was found before the document end, we can copy this range
 				if (endPos != _document.cend()) {
-					_copy_buffer.assign(startPos, std::next(endPos, Library::size(endDoc)));
+					into.assign(startPos, std::next(endPos, findEnd.size()));
 				}
 			}
 		}
 	}
 
 	// paste the contents of copy_buffer after the occurence of phrase
-	template < template<class, class> class T1, class T2 >
-	void Document<T1, T2>::paste_after(const ValueType & pasteAfterPhrase) {
+	template < template<class, class> class T1, class T2, class T3 >
+	void Document<T1, T2, T3>::paste_after(const PhraseType & pasteAfterPhrase) {
+		PROFILE_SCOPE("paste_after");
 		// check if the phrase is empty
 		if (!pasteAfterPhrase.empty()) {
-			const ContainerType pasteDoc(Document(pasteAfterPhrase)._document);
+			PhraseArena arena;
+			pasteAfter(phraseWords<ValueType>(pasteAfterPhrase, arena.resource(), false));
+		}
+	}
+
+	// paste the copy buffer after the first occurrence of a phrase, returning 1 if it was pasted and 0 if not
+	template < template<class, class> class T1, class T2, class T3 >
+	std::size_t Document<T1, T2, T3>::pasteAfter(const PhraseWords & phrase) {
+		const SearcherType find(phrase.cbegin(), phrase.cend(), phrase.get_allocator().resource());
 
-			// search for the position
-			auto pos = std::search(_document.cbegin(), _document.cend(),
-				pasteDoc.cbegin(), pasteDoc.cend());
+		if (index() || parallel()) {
+			const auto pos = locate(phrase, find, 0, true);
+			if (pos.empty()) {
+				return 0;
+			}
 
-			// if the position is found before the end of the document, we can paste
-			if (pos != _document.cend()) {
-				// library function to insert to generic container				
-				Library::insert(_document, std::next(pos, Library::size(pasteDoc)), _copy_buffer.cbegin(), _copy_buffer.cend());
+			const std::size_t position = pos.front() + find.size();
+			Library::insert(_document, std::next(_document.cbegin(), position), _copy_buffer.cbegin(), _copy_buffer.cend());
+			if (_index) {
+				_index->inserted(position, _copy_buffer.cbegin(), _copy_buffer.cend());
 			}
+			return 1;
 		}
+
+		// search for the position
+		auto pos = find(_document.cbegin(), _document.cend());
+
+		// if the position is found before the end of the document, we can paste
+		if (pos == _document.cend()) {
+			return 0;
+		}
+
+		// library function to insert to generic container
+		Library::insert(_document, std::next(pos, find.size()), _copy_buffer.cbegin(), _copy_buffer.cend());
+		return 1;
 	}
 
 	// erase all instances of phrase
-	template < template<class, class> class T1, class T2 >
-	void Document<T1, T2>::erase(const ValueType & phrase) {
+	template < template<class, class> class T1, class T2, class T3 >
+	void Document<T1, T2, T3>::erase(const PhraseType & phrase) {
+		PROFILE_SCOPE("erase");
 		// check to make sure phrase is valid
 		if (!phrase.empty()) {
-			// turn the phrase into a document to use the underlying container
-			const ContainerType phraseDoc(Document(phrase)._document);
-
-			// find the position of the first occurence of phrase in the document
-			auto pos = std::search(_document.cbegin(), _document.cend(),
-				phraseDoc.cbegin(), phraseDoc.cend());
-
-			while (pos != _document.end()) {
-				// erase the range from pos to the next element after the phrase, and return the next element from that
-				pos = Library::erase(_document, pos, std::next(pos, Library::size(phraseDoc)));
-				// search starting from the returned position
-				pos = std::search(pos, _document.cend(),
-					phraseDoc.cbegin(), phraseDoc.cend());
-			}
+			// erasing is replacing with nothing
+			PhraseArena arena;
+			replacePhrase(phraseWords<ValueType>(phrase, arena.resource(), false), PhraseWords(arena.resource()));
 		}
 	}
 
 	// substitute all instances of a phrase with another phrase
-	template < template<class, class> class T1, class T2 >
-	void Document<T1, T2>::substitute(const ValueType & oldPhrase, const ValueType & newPhrase) {
+	template < template<class, class> class T1, class T2, class T3 >
+	void Document<T1, T2, T3>::substitute(const PhraseType & oldPhrase, const PhraseType & newPhrase) {
+		PROFILE_SCOPE("substitute");
 		// check validity
 		if (!(oldPhrase.empty() || newPhrase.empty())) {
-			// turn the phrases into documents and get underlying containers
-			const ContainerType oldPhraseDoc(Document(oldPhrase)._document);
-			const ContainerType newPhraseDoc(Document(newPhrase)._document);
+			// split the phrases into words, kept on the stack
+			PhraseArena arena;
+			replacePhrase(phraseWords<ValueType>(oldPhrase, arena.resource(), false), phraseWords<ValueType>(newPhrase, arena.resource(), true));
+		}
+
+	}
+
+	// replace every occurrence of a phrase in one pass over the document, returning the number replaced
+	template < template<class, class> class T1, class T2, class T3 >
+	std::size_t Document<T1, T2, T3>::replacePhrase(const PhraseWords & phrase, const PhraseWords & replacement) {
+		// preprocess the phrase once for the whole pass, in the same buffer as the phrase
+		const SearcherType find(phrase.cbegin(), phrase.cend(), phrase.get_allocator().resource());
+
+		if (index() || parallel()) {
+			// every hit is known up front, so nothing is compared during the pass, and nothing is done without a hit
+			std::vector<std::size_t> hits;
+			{
+				PROFILE_SCOPE("search");
+				hits = nonOverlapping(locate(phrase, find, 0, false), find.size());
+			}
+			if (hits.empty()) {
+				return 0;
+			}
+
+			{
+				PROFILE_SCOPE("replace");
+				if constexpr (IsRandomAccess<ContainerType>::value && IsWritable<ContainerType>::value) {
+					if (parallel()) {
+						parallelReplace(_document, hits, find.size(), replacement.cbegin(), replacement.cend(), *_pool);
+					}
+					else {
+						Library::replaceAll(_document, PlannedSearcher(hits, find.size()), replacement.cbegin(), replacement.cend(), [](std::size_t) {});
+					}
+				}
+				else {
+					Library::replaceAll(_document, PlannedSearcher(hits, find.size()), replacement.cbegin(), replacement.cend(), [](std::size_t) {});
+				}
+			}
+
+			if (_index) {
+				PROFILE_SCOPE("index_update");
+				_index->replaced(hits, find.size(), replacement.cbegin(), replacement.cend());
+			}
+			return hits.size();
+		}
+
+		// searching and rewriting are interleaved in one pass, so they are timed together
+		PROFILE_SCOPE("search_and_replace");
+		return Library::replaceAll(_document, find, replacement.cbegin(), replacement.cend(), [](std::size_t) {});
+	}
+
+	// replace every occurrence of the phrases of a map with the phrases they map to
+	template < template<class, class> class T1, class T2, class T3 >
+	std::size_t Document<T1, T2, T3>::substitute_all(const std::map<PhraseType, PhraseType> & replacements) {
+		return substitute_all(dictionary(replacements));
+	}
+
+	// erase every occurrence of the phrases of a set
+	template < template<class, class> class T1, class T2, class T3 >
+	std::size_t Document<T1, T2, T3>::erase_all(const std::set<PhraseType> & phrases) {
+		return substitute_all(dictionary(phrases));
+	}
+
+	// replace every occurrence of the phrases of a dictionary in one pass to find them and one to rewrite the document,
+	// returning the number replaced
+	template < template<class, class> class T1, class T2, class T3 >
+	std::size_t Document<T1, T2, T3>::substitute_all(const DictionaryType & dictionary) {
+		PROFILE_SCOPE("substitute_all");
+		std::vector<typename DictionaryType::Match> matches;
+		{
+			PROFILE_SCOPE("search");
+			matches = dictionary.matches(_document.cbegin(), _document.cend());
+		}
+		if (matches.empty()) {
+			return 0;
+		}
+
+		std::vector<Splice<typename DictionaryType::Phrase::const_iterator>> splices;
+		splices.reserve(matches.size());
+		for (const auto & match : matches) {
+			const auto & replacement = dictionary.replacement(match.phrase);
+			splices.push_back({ match.position, dictionary.phrase(match.phrase).size(), replacement.cbegin(), replacement.cend() });
+		}
+
+		{
+			PROFILE_SCOPE("replace");
+			Library::spliceAll(_document, splices);
+		}
+
+		// the occurrences are spread over the whole document and move each other, so the index is rebuilt instead
+		_index_stale = true;
+		return matches.size();
+	}
+
+	// compile phrases and their replacements, skipping phrases replaced with nothing as substitute does
+	template < template<class, class> class T1, class T2, class T3 >
+	typename Document<T1, T2, T3>::DictionaryType Document<T1, T2, T3>::dictionary(const std::map<PhraseType, PhraseType> & replacements) {
+		std::vector<std::pair<ContainerType, ContainerType>> phrases;
+		for (const auto & replacement : replacements) {
+			if (!replacement.second.empty()) {
+				phrases.emplace_back(Document(replacement.first)._document, Document(replacement.second)._document);
+			}
+		}
+		return DictionaryType(phrases.cbegin(), phrases.cend());
+	}
+
+	// compile phrases to be erased
+	template < template<class, class> class T1, class T2, class T3 >
+	typename Document<T1, T2, T3>::DictionaryType Document<T1, T2, T3>::dictionary(const std::set<PhraseType> & phrases) {
+		std::vector<std::pair<ContainerType, ContainerType>> erased;
+		for (const auto & phrase : phrases) {
+			erased.emplace_back(Document(phrase)._document, ContainerType());
+		}
+		return DictionaryType(erased.cbegin(), erased.cend());
+	}
+
+	// apply a batch of edits in order, as one undoable step. A run of erase and substitute edits is applied with one rewrite
+	// of the document when none of them can change what another finds: no edit's phrase shares a word with an earlier
+	// edit's phrase or replacement, and nothing follows an erase but single word phrases (erasing can bring words together
+	// into a new occurrence). Otherwise, and for paste_after, edits are applied one at a time
+	template < template<class, class> class T1, class T2, class T3 >
+	std::vector<std::size_t> Document<T1, T2, T3>::apply(const EditBatch & batch) {
+		PROFILE_SCOPE("apply");
+		std::vector<std::size_t> hits(batch.size(), 0);
+		if (batch.empty()) {
+			return hits;
+		}
+
+		snap();
+
+		// turn every phrase into words once
+		struct Parsed {
+			PhraseWords		phrase;
+			PhraseWords		replacement;
+			std::size_t		length;
+		};
+		std::vector<Parsed> parsed;
+		parsed.reserve(batch.size());
+		for (const auto & edit : batch) {
+			auto phrase = phraseWords<ValueType>(edit.phrase, std::pmr::get_default_resource(), false);
+			auto replacement = phraseWords<ValueType>(edit.replacement, std::pmr::get_default_resource(), true);
+			const auto length = static_cast<std::size_t>(Library::size(phrase));
+			parsed.push_back(Parsed{ std::move(phrase), std::move(replacement), length });
+		}
+
+		// edits that do nothing on their own do nothing here either
+		auto isReplace = [&](std::size_t i) {
+			return batch[i].operation != EditBatch::Operation::PasteAfter;
+		};
+		auto isNoOp = [&](std::size_t i) {
+			return parsed[i].length == 0 || (batch[i].operation == EditBatch::Operation::Substitute && batch[i].replacement.empty());
+		};
+
+		for (std::size_t i = 0; i < batch.size();) {
+			if (isNoOp(i)) {
+				++i;
+				continue;
+			}
+			if (!isReplace(i)) {
+				hits[i] = pasteAfter(parsed[i].phrase);
+				++i;
+				continue;
+			}
+
+			// gather the run of edits that can go in the same pass as this one
+			std::vector<std::size_t> group(1, i);
+			std::unordered_set<ValueType> phraseWords(parsed[i].phrase.cbegin(), parsed[i].phrase.cend());
+			std::unordered_set<ValueType> replacementWords(parsed[i].replacement.cbegin(), parsed[i].replacement.cend());
+			bool erased = parsed[i].replacement.empty();
+
+			std::size_t next = i + 1;
+			for (; next < batch.size() && isReplace(next); ++next) {
+				if (isNoOp(next)) {
+					continue;
+				}
+
+				const Parsed & edit = parsed[next];
+				const bool independent = (!erased || edit.length == 1) &&
+					std::none_of(edit.phrase.cbegin(), edit.phrase.cend(), [&](const ValueType & word) {
+						return phraseWords.count(word) > 0 || replacementWords.count(word) > 0;
+					});
+				if (!independent) {
+					break;
+				}
+
+				group.push_back(next);
+				phraseWords.insert(edit.phrase.cbegin(), edit.phrase.cend());
+				replacementWords.insert(edit.replacement.cbegin(), edit.replacement.cend());
+				erased = erased || edit.replacement.empty();
+			}
+
+			if (group.size() == 1) {
+				hits[i] = replacePhrase(parsed[i].phrase, parsed[i].replacement);
+			}
+			else {
+				// find every hit before changing anything; independent edits don't change what the others find, so every hit
+				// can be made in one rewrite afterwards
+				std::vector<std::vector<std::size_t>> groupHits(group.size());
+				{
+					PROFILE_SCOPE("search");
+
+					// a scan per phrase is a few comparisons per word, and looking each word up in a table of first words costs
+					// about as much as eight of them, so only long runs are found in one scan
+					constexpr std::size_t scanPerPhraseLimit = 8;
+					if (group.size() <= scanPerPhraseLimit || index() || parallel()) {
+						for (std::size_t g = 0; g < group.size(); ++g) {
+							groupHits[g] = hitsOf(parsed[group[g]].phrase);
+						}
+					}
+					else {
+						// the phrases share no words, so at most one of them starts with any given word
+						std::unordered_map<ValueType, std::size_t> starts;
+						for (std::size_t g = 0; g < group.size(); ++g) {
+							starts.emplace(*parsed[group[g]].phrase.cbegin(), g);
+						}
+
+						const auto total = static_cast<std::size_t>(Library::size(_document));
+						std::size_t position = 0;
+						for (auto itr = _document.cbegin(); position < total;) {
+							auto found = starts.find(*itr);
+							if (found != starts.end()) {
+								const Parsed & edit = parsed[group[found->second]];
+								if (edit.length <= total - position && std::equal(edit.phrase.cbegin(), edit.phrase.cend(), itr)) {
+									groupHits[found->second].push_back(position);
+									std::advance(itr, static_cast<std::ptrdiff_t>(edit.length));
+									position += edit.length;
+									continue;
+								}
+							}
+							++itr;
+							++position;
+						}
+					}
+				}
+
+				std::vector<Splice<typename PhraseWords::const_iterator>> splices;
+				for (std::size_t g = 0; g < group.size(); ++g) {
+					const Parsed & edit = parsed[group[g]];
+					hits[group[g]] = groupHits[g].size();
+					for (auto position : groupHits[g]) {
+						splices.push_back({ position, edit.length, edit.replacement.cbegin(), edit.replacement.cend() });
+					}
+				}
+				std::sort(splices.begin(), splices.end(), [](const auto & lhs, const auto & rhs) { return lhs.position < rhs.position; });
+
+				if (!splices.empty()) {
+					{
+						PROFILE_SCOPE("replace");
+						Library::spliceAll(_document, splices);
+					}
+
+					if (_index) {
+						PROFILE_SCOPE("index_update");
+						// the index takes the edits one at a time, so each edit's hits are moved by the edits before it
+						for (std::size_t g = 0; g < group.size(); ++g) {
+							std::vector<std::size_t> moved(groupHits[g]);
+							for (std::size_t earlier = 0; earlier < g; ++earlier) {
+								const Parsed & edit = parsed[group[earlier]];
+								const auto & before = groupHits[earlier];
+								for (std::size_t h = 0; h < moved.size(); ++h) {
+									// hits are counted in the original document
+									const auto count = static_cast<std::size_t>(std::lower_bound(before.cbegin(), before.cend(), groupHits[g][h]) - before.cbegin());
+									moved[h] = moved[h] - count * edit.length + count * static_cast<std::size_t>(Library::size(edit.replacement));
+								}
+							}
+							_index->replaced(moved, parsed[group[g]].length, parsed[group[g]].replacement.cbegin(), parsed[group[g]].replacement.cend());
+						}
+					}
+				}
+			}
+
+			i = next;
+		}
+
+		return hits;
+	}
+
+	// positions of the occurrences of a phrase a left to right replacement would replace
+	template < template<class, class> class T1, class T2, class T3 >
+	std::vector<std::size_t> Document<T1, T2, T3>::hitsOf(const PhraseWords & phrase) const {
+		const SearcherType find(phrase.cbegin(), phrase.cend(), phrase.get_allocator().resource());
+		if (index() || parallel()) {
+			return nonOverlapping(locate(phrase, find, 0, false), find.size());
+		}
+
+		// keep a running position so containers without random access are only walked once
+		std::vector<std::size_t> positions;
+		std::size_t position = 0;
+		auto last = _document.cbegin();
+		for (auto pos = find(_document.cbegin(), _document.cend()); pos != _document.cend(); pos = find(last, _document.cend())) {
+			position += static_cast<std::size_t>(std::distance(last, pos));
+			positions.push_back(position);
+			last = std::next(pos, static_cast<std::ptrdiff_t>(find.size()));
+			position += find.size();
+		}
+		return positions;
+	}
+
+	// find the position of every occurrence of a phrase, counted in words from the start of the document. Occurrences may
+	// overlap
+	template < template<class, class> class T1, class T2, class T3 >
+	std::vector<std::size_t> Document<T1, T2, T3>::find_all(const PhraseType & phrase) const {
+		PROFILE_SCOPE("find_all");
+		PhraseArena arena;
+		const auto phraseDoc = phraseWords<ValueType>(phrase, arena.resource(), false);
+		const SearcherType find(phraseDoc.cbegin(), phraseDoc.cend(), arena.resource());
+		if (index() || parallel()) {
+			return locate(phraseDoc, find, 0, false);
+		}
+
+		std::vector<std::size_t> positions;
+
+		// keep a running position so containers without random access are only walked once
+		std::size_t position = 0;
+		auto last = _document.cbegin();
+		for (auto pos = find(_document.cbegin(), _document.cend()); pos != _document.cend(); pos = find(std::next(pos), _document.cend())) {
+			position += static_cast<std::size_t>(std::distance(last, pos));
+			positions.push_back(position);
+			last = pos;
+		}
+
+		return positions;
+	}
+
+	// turn the word index on or off
+	template < template<class, class> class T1, class T2, class T3 >
+	void Document<T1, T2, T3>::use_index(bool enable) {
+		if (!enable) {
+			_index.reset();
+		}
+		else if (!_index) {
+			_index.emplace();
+			_index_stale = true;
+		}
+	}
+
+	// set the number of threads to split work over
+	template < template<class, class> class T1, class T2, class T3 >
+	void Document<T1, T2, T3>::threads(std::size_t count) {
+		if (count == 1) {
+			_pool.reset();
+		}
+		else {
+			_pool = std::make_shared<ThreadPool>(count);
+		}
+	}
+
+	// true if work on the document should be split over the thread pool
+	template < template<class, class> class T1, class T2, class T3 >
+	bool Document<T1, T2, T3>::parallel() const {
+		// below this many words, starting the threads costs about as much as the work saved
+		constexpr std::size_t parallelMinimum = 1 << 15;
+
+		if constexpr (IsRandomAccess<ContainerType>::value) {
+			return _pool && _pool->size() > 1 && _document.size() >= parallelMinimum;
+		}
+		else {
+			return false;
+		}
+	}
+
+	// positions, at or after from, of every occurrence of a phrase or only the first, looked up in the word index if there is
+	// one, otherwise searched for in parallel. Occurrences may overlap
+	template < template<class, class> class T1, class T2, class T3 >
+	std::vector<std::size_t> Document<T1, T2, T3>::locate(const PhraseWords & phrase, const SearcherType & find, std::size_t from, bool firstOnly) const {
+		if (index()) {
+			return indexedMatches(phrase, from, firstOnly ? 1 : std::numeric_limits<std::size_t>::max());
+		}
+
+		if constexpr (IsRandomAccess<ContainerType>::value) {
+			return parallelMatches(_document, find, *_pool, from, firstOnly);
+		}
+		else {
+			return std::vector<std::size_t>();
+		}
+	}
+
+	// the word index, brought up to date with the document, or null if it isn't enabled
+	template < template<class, class> class T1, class T2, class T3 >
+	typename Document<T1, T2, T3>::IndexType * Document<T1, T2, T3>::index() const {
+		if (!_index) {
+			return nullptr;
+		}
+
+		if (_index_stale) {
+			PROFILE_SCOPE("index_build");
+			_index->build(_document.cbegin(), _document.cend());
+			_index_stale = false;
+		}
+		return &*_index;
+	}
+
+	// positions, at or after from, of up to limit occurrences of a phrase, found by comparing only the candidates the index
+	// gives. Occurrences may overlap
+	template < template<class, class> class T1, class T2, class T3 >
+	std::vector<std::size_t> Document<T1, T2, T3>::indexedMatches(const PhraseWords & phrase, std::size_t from, std::size_t limit) const {
+		std::vector<std::size_t> matches;
+		const auto candidates = index()->candidates(phrase.cbegin(), phrase.cend());
 
-			// find the position of oldPhrase
-			auto pos = std::search(_document.cbegin(), _document.cend(),
-				oldPhraseDoc.cbegin(), oldPhraseDoc.cend());
+		// walk forward from candidate to candidate, so containers without random access are walked at most once
+		std::size_t position = 0;
+		auto itr = _document.cbegin();
+		for (auto candidate = std::lower_bound(candidates.cbegin(), candidates.cend(), from);
+			candidate != candidates.cend() && matches.size() < limit; ++candidate) {
 
-			// if we're not at the end of the document
-			while (pos != _document.end()) {
-				// erase the old phrase
-				pos = Library::erase(_document, pos, std::next(pos, Library::size(oldPhraseDoc)));
-				// insert the new one at the position returned from last operation
-				pos = Library::insert(_document, pos, newPhraseDoc.cbegin(), newPhraseDoc.cend());
+			std::advance(itr, static_cast<std::ptrdiff_t>(*candidate - position));
+			position = *candidate;
 
-				// keep searching for the phrase
-				pos = std::search(pos, _document.cend(),
-					oldPhraseDoc.cbegin(), oldPhraseDoc.cend());
+			// every candidate leaves room for the whole phrase before the end of the document
+			if (std::equal(phrase.cbegin(), phrase.cend(), itr)) {
+				matches.push_back(position);
 			}
 		}
 
+		return matches;
 	}
 }
 
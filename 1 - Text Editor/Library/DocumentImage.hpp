@@ -0,0 +1,390 @@
+/**
+* File:		DocumentImage.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the binary image a Document is saved to by Document::save_image, so it can be reopened
+*			without tokenizing the text again and with its undo history and copy buffer intact. An image is a dictionary
+*			of the distinct words, and every version of the document as a sequence of word IDs. It is read straight out
+*			of a memory mapping: the words are views of the mapped text (which Library::Token keeps), and the IDs are read
+*			in place.
+*
+*			The file is a header followed by records, and records are only ever appended. A words record adds words to
+*			the dictionary. A state record describes the history relative to the state before it: how many snapshots were
+*			dropped from the front (trimmed to fit the history budget) and kept at the back (the rest were undone), the
+*			snapshots taken since, and then in full the document, the copy buffer and the redo versions. Saving history is
+*			therefore an append of what changed, not a rewrite. A record cut short by a crash is ignored, and the file
+*			reads as it was before that append.
+*
+*			Each state record repeats the whole document, so appends add up. Once the records appended since the image
+*			was last written whole take more room than it did, the next append writes it whole again instead, which
+*			keeps the file, and what opening it reads and checks, within about twice the size of a fresh image.
+*
+*				header:	magic "TXTIMAGE", u32 version, u32 byte order mark, u64 reserved
+*				record:	u32 type, u32 reserved, u64 payload size, payload padded to a multiple of 8 bytes
+*				words:	u64 count, u64 offsets[count + 1] into the text that follows, text
+*				state:	u64 dropped, u64 kept, u64 new snapshots, u64 redo versions, then each sequence (new snapshots,
+*						document, copy buffer, redo versions) as u64 length, u32 IDs[length], padded to 8 bytes
+*
+*			Numbers are stored in the byte order of the machine that wrote them; a file written with the other order is
+*			refused.
+*/
+
+#ifndef DOCUMENT_IMAGE_HPP
+#define DOCUMENT_IMAGE_HPP
+
+// includes
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Library/BufferedWriter.hpp"
+
+namespace Library {
+	namespace ImageFormat {
+		constexpr char			Magic[8] = { 'T', 'X', 'T', 'I', 'M', 'A', 'G', 'E' };
+		constexpr std::uint32_t	Version = 1;
+		constexpr std::uint32_t	ByteOrder = 0x01020304;
+		constexpr std::size_t	HeaderSize = 24;
+		constexpr std::size_t	RecordHeaderSize = 16;
+
+		enum RecordType : std::uint32_t { WordsRecord = 1, StateRecord = 2 };
+
+		inline std::size_t padded(std::size_t size) {
+			return (size + 7) & ~std::size_t(7);
+		}
+
+		// numbers are read with memcpy, which is what an unaligned load compiles to
+		template<class Number>
+		inline Number read(const char * data) {
+			Number number;
+			std::memcpy(&number, data, sizeof(number));
+			return number;
+		}
+
+		template<class Number>
+		inline void write(std::string & out, Number number) {
+			out.append(reinterpret_cast<const char *>(&number), sizeof(number));
+		}
+	}
+
+	// the writing side of an image: the dictionary the file holds so far, and how much of the history it already has
+	class ImageJournal {
+	public:
+		explicit ImageJournal(std::filesystem::path path) : _path(std::move(path)) {}
+
+		ImageJournal(const ImageJournal &) = delete;
+		ImageJournal & operator=(const ImageJournal &) = delete;
+
+		const std::filesystem::path & path() const { return _path; }
+
+		// false once an append has failed part way, after which only a new image can be written
+		bool good() const { return _good; }
+
+		// the ID of a word, giving it the next one if the file doesn't have it yet
+		std::uint32_t id(std::string_view word) {
+			auto found = _ids.find(word);
+			if (found != _ids.end()) {
+				return found->second;
+			}
+
+			// deque elements never move, so the map can key on views of the stored text
+			const auto id = static_cast<std::uint32_t>(_words.size());
+			_words.emplace_back(word);
+			_ids.emplace(_words.back(), id);
+			return id;
+		}
+
+		// number of words in the dictionary
+		std::size_t size() const { return _words.size(); }
+
+		// when a file is reopened, every word given an ID so far and every snapshot are already in it, and it is all the base
+		// later appends are measured against
+		void opened(std::size_t snapshots, std::size_t bytes) {
+			_written = _words.size();
+			_kept = snapshots;
+			_base = bytes;
+		}
+
+		// true once the records appended since the image was written whole take more room than it did
+		bool oversized() const { return _appended > _base; }
+
+		// history bookkeeping, kept up to date by the document between records: snapshots were popped off the back, leaving
+		// this many, or the oldest snapshot was dropped from the front
+		void popped(std::size_t snapshots) {
+			_kept = std::min(_kept, snapshots);
+		}
+
+		void trimmed() {
+			// a snapshot the file doesn't have yet is simply never written
+			if (_kept > 0) {
+				--_kept;
+				++_dropped;
+			}
+		}
+
+		std::size_t kept() const { return _kept; }
+
+		// start the next sequence of the state being gathered, then add its words one at a time
+		void sequence() {
+			_lengths.push_back(0);
+		}
+
+		void push(std::string_view word) {
+			_sequence.push_back(id(word));
+			++_lengths.back();
+		}
+
+		// write the gathered state, and the words it introduced, as records. A new image is written next to the file and then
+		// moved over it, so a document still viewing the old file keeps reading it. Afterwards the file holds all the history
+		// there is
+		bool write(std::size_t newSnapshots, std::size_t redo, std::size_t snapshots, bool create) {
+			std::string out;
+			if (create) {
+				out.append(ImageFormat::Magic, sizeof(ImageFormat::Magic));
+				ImageFormat::write(out, ImageFormat::Version);
+				ImageFormat::write(out, ImageFormat::ByteOrder);
+				ImageFormat::write(out, std::uint64_t(0));
+			}
+
+			if (_written < _words.size() || create) {
+				std::size_t textSize = 0;
+				for (std::size_t i = _written; i < _words.size(); ++i) {
+					textSize += _words[i].size();
+				}
+				const std::size_t count = _words.size() - _written;
+				record(out, ImageFormat::WordsRecord, 8 + 8 * (count + 1) + textSize);
+				ImageFormat::write(out, std::uint64_t(count));
+				std::uint64_t offset = 0;
+				ImageFormat::write(out, offset);
+				for (std::size_t i = _written; i < _words.size(); ++i) {
+					offset += _words[i].size();
+					ImageFormat::write(out, offset);
+				}
+				for (std::size_t i = _written; i < _words.size(); ++i) {
+					out += _words[i];
+				}
+				out.resize(ImageFormat::padded(out.size()), '\0');
+			}
+
+			std::size_t stateSize = 32;
+			for (auto length : _lengths) {
+				stateSize += ImageFormat::padded(8 + 4 * length);
+			}
+			record(out, ImageFormat::StateRecord, stateSize);
+			ImageFormat::write(out, std::uint64_t(_dropped));
+			ImageFormat::write(out, std::uint64_t(_kept));
+			ImageFormat::write(out, std::uint64_t(newSnapshots));
+			ImageFormat::write(out, std::uint64_t(redo));
+
+			// the header and the dictionary go out first, then the IDs straight from where they were gathered
+			const std::filesystem::path target = create ? std::filesystem::path(_path.string() + ".partial") : _path;
+			bool good;
+			std::size_t bytes = out.size();
+			{
+				BufferedWriter file(target, create ? BufferedWriter::Mode::Truncate : BufferedWriter::Mode::Append);
+				file.write(out);
+
+				const char * ids = reinterpret_cast<const char *>(_sequence.data());
+				for (auto length : _lengths) {
+					bytes += ImageFormat::padded(8 + 4 * length);
+					std::string prefix;
+					ImageFormat::write(prefix, std::uint64_t(length));
+					file.write(prefix);
+					file.write(std::string_view(ids, 4 * length));
+					ids += 4 * length;
+					if (length % 2 != 0) {
+						file.write(std::string_view("\0\0\0\0", 4));
+					}
+				}
+				good = file.flush();
+			}
+
+			// a document loaded from the image may still have it mapped; MappedFile shares it for delete, so it can be replaced
+			if (create && good) {
+				std::error_code error;
+				std::filesystem::rename(target, _path, error);
+				good = !error;
+			}
+
+			_sequence.clear();
+			_lengths.clear();
+			if (!good) {
+				_good = false;
+				return false;
+			}
+			_written = _words.size();
+			_kept = snapshots;
+			_dropped = 0;
+			if (create) {
+				_base = bytes;
+				_appended = 0;
+			}
+			else {
+				_appended += bytes;
+			}
+			return true;
+		}
+
+	private:
+		static void record(std::string & out, std::uint32_t type, std::size_t size) {
+			ImageFormat::write(out, type);
+			ImageFormat::write(out, std::uint32_t(0));
+			ImageFormat::write(out, std::uint64_t(size));
+		}
+
+		std::filesystem::path								_path;
+		std::deque<std::string>								_words;			// ID to word text
+		std::unordered_map<std::string_view, std::uint32_t>	_ids;			// word text, viewing _words, to ID
+		std::size_t											_written = 0;	// words the file already has
+		std::size_t											_kept = 0;		// leading snapshots the file already has
+		std::size_t											_dropped = 0;	// snapshots trimmed from the front since the last record
+		std::size_t											_base = 0;		// bytes of the image when it was last written whole
+		std::size_t											_appended = 0;	// bytes appended to it since
+		std::vector<std::uint32_t>							_sequence;		// IDs of the state being gathered
+		std::vector<std::size_t>							_lengths;		// and the length of each of its sequences
+		bool												_good = true;
+	};
+
+	// the reading side of an image: the dictionary, and the history as it stands after the last complete state record
+	class ImageReader {
+	public:
+		// a sequence of word IDs, read in place
+		class Sequence {
+		public:
+			Sequence() = default;
+			Sequence(const char * data, std::size_t size) : _data(data), _size(size) {}
+
+			std::size_t size() const { return _size; }
+			std::uint32_t operator[] (std::size_t i) const { return ImageFormat::read<std::uint32_t>(_data + 4 * i); }
+
+		private:
+			const char *	_data = nullptr;
+			std::size_t		_size = 0;
+		};
+
+		explicit ImageReader(std::string_view file) {
+			if (file.size() < ImageFormat::HeaderSize || std::memcmp(file.data(), ImageFormat::Magic, sizeof(ImageFormat::Magic)) != 0 ||
+				ImageFormat::read<std::uint32_t>(file.data() + 8) != ImageFormat::Version ||
+				ImageFormat::read<std::uint32_t>(file.data() + 12) != ImageFormat::ByteOrder) {
+				return;
+			}
+
+			// stop at the first record that is cut short or doesn't make sense
+			std::size_t position = ImageFormat::HeaderSize;
+			while (file.size() - position >= ImageFormat::RecordHeaderSize) {
+				const auto type = ImageFormat::read<std::uint32_t>(file.data() + position);
+				const auto size = ImageFormat::read<std::uint64_t>(file.data() + position + 8);
+				const std::size_t available = file.size() - position - ImageFormat::RecordHeaderSize;
+				if (size > available || ImageFormat::padded(static_cast<std::size_t>(size)) > available) {
+					break;
+				}
+
+				const std::string_view payload(file.data() + position + ImageFormat::RecordHeaderSize, static_cast<std::size_t>(size));
+				const bool read = type == ImageFormat::WordsRecord ? readWords(payload) :
+					type == ImageFormat::StateRecord ? readState(payload) : false;
+				if (!read) {
+					break;
+				}
+				position += ImageFormat::RecordHeaderSize + ImageFormat::padded(static_cast<std::size_t>(size));
+			}
+		}
+
+		// true if the file is an image with at least one complete state
+		bool good() const { return _good; }
+
+		const std::vector<std::string_view> &	words()			const { return _words; }
+		const std::deque<Sequence> &			snapshots()		const { return _snapshots; }
+		const Sequence &						document()		const { return _document; }
+		const Sequence &						copy_buffer()	const { return _copyBuffer; }
+		const std::vector<Sequence> &			redo()			const { return _redo; }
+
+	private:
+		bool readWords(std::string_view payload) {
+			if (payload.size() < 16) {
+				return false;
+			}
+			const auto count = ImageFormat::read<std::uint64_t>(payload.data());
+			if (count >= (payload.size() - 8) / 8) {
+				return false;
+			}
+
+			const char * offsets = payload.data() + 8;
+			const std::string_view text = payload.substr(8 + 8 * (static_cast<std::size_t>(count) + 1));
+			std::vector<std::string_view> words;
+			words.reserve(static_cast<std::size_t>(count));
+			for (std::size_t i = 0; i < count; ++i) {
+				const auto first = ImageFormat::read<std::uint64_t>(offsets + 8 * i);
+				const auto last = ImageFormat::read<std::uint64_t>(offsets + 8 * (i + 1));
+				if (first > last || last > text.size()) {
+					return false;
+				}
+				words.push_back(text.substr(static_cast<std::size_t>(first), static_cast<std::size_t>(last - first)));
+			}
+			_words.insert(_words.end(), words.cbegin(), words.cend());
+			return true;
+		}
+
+		bool readState(std::string_view payload) {
+			if (payload.size() < 32) {
+				return false;
+			}
+			const auto dropped = ImageFormat::read<std::uint64_t>(payload.data());
+			const auto kept = ImageFormat::read<std::uint64_t>(payload.data() + 8);
+			const auto added = ImageFormat::read<std::uint64_t>(payload.data() + 16);
+			const auto redo = ImageFormat::read<std::uint64_t>(payload.data() + 24);
+			if (dropped > _snapshots.size() || kept > _snapshots.size() - dropped) {
+				return false;
+			}
+
+			std::vector<Sequence> sequences;
+			std::size_t position = 32;
+			while (position < payload.size()) {
+				if (payload.size() - position < 8) {
+					return false;
+				}
+				const auto length = ImageFormat::read<std::uint64_t>(payload.data() + position);
+				if (length > (payload.size() - position - 8) / 4) {
+					return false;
+				}
+				const Sequence sequence(payload.data() + position + 8, static_cast<std::size_t>(length));
+				for (std::size_t i = 0; i < sequence.size(); ++i) {
+					if (sequence[i] >= _words.size()) {
+						return false;
+					}
+				}
+				sequences.push_back(sequence);
+				position += ImageFormat::padded(8 + 4 * static_cast<std::size_t>(length));
+			}
+			if (sequences.size() != added + 2 + redo) {
+				return false;
+			}
+
+			_snapshots.erase(_snapshots.begin(), _snapshots.begin() + static_cast<std::ptrdiff_t>(dropped));
+			_snapshots.resize(static_cast<std::size_t>(kept));
+			_snapshots.insert(_snapshots.end(), sequences.cbegin(), sequences.cbegin() + static_cast<std::ptrdiff_t>(added));
+			_document = sequences[static_cast<std::size_t>(added)];
+			_copyBuffer = sequences[static_cast<std::size_t>(added) + 1];
+			_redo.assign(sequences.cbegin() + static_cast<std::ptrdiff_t>(added) + 2, sequences.cend());
+			_good = true;
+			return true;
+		}
+
+		std::vector<std::string_view>	_words;
+		std::deque<Sequence>			_snapshots;
+		Sequence						_document;
+		Sequence						_copyBuffer;
+		std::vector<Sequence>			_redo;
+		bool							_good = false;
+	};
+}
+
+#endif
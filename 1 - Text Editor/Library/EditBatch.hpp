@@ -0,0 +1,66 @@
+/**
+* File:		EditBatch.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a list of edits to be applied to a Document all at once by Document::apply. The edits
+*			are recorded in order and take effect as if each had been called on the document in that order, but runs of
+*			edits that can't affect one another are carried out together in one pass over the document.
+*
+*			Usage:
+*				EditBatch batch;
+*				batch.substitute("effective length", "ineffective measurement").erase("a string");
+*				auto hits = doc.apply(batch);
+*/
+
+#ifndef EDIT_BATCH_HPP
+#define EDIT_BATCH_HPP
+
+// includes
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Library {
+	class EditBatch {
+	public:
+		enum class Operation { Erase, Substitute, PasteAfter };
+
+		struct Edit {
+			Operation	operation;
+			std::string	phrase;
+			std::string	replacement;		// only used by Substitute
+		};
+
+		using const_iterator = std::vector<Edit>::const_iterator;
+
+		// add an edit to the end of the batch; each returns the batch so edits can be chained
+		EditBatch & erase(std::string phrase) {
+			_edits.push_back(Edit{ Operation::Erase, std::move(phrase), std::string() });
+			return *this;
+		}
+
+		EditBatch & substitute(std::string oldPhrase, std::string newPhrase) {
+			_edits.push_back(Edit{ Operation::Substitute, std::move(oldPhrase), std::move(newPhrase) });
+			return *this;
+		}
+
+		EditBatch & paste_after(std::string phrase) {
+			_edits.push_back(Edit{ Operation::PasteAfter, std::move(phrase), std::string() });
+			return *this;
+		}
+
+		const_iterator	begin()	const { return _edits.cbegin(); }
+		const_iterator	end()	const { return _edits.cend(); }
+		std::size_t		size()	const { return _edits.size(); }
+		bool			empty()	const { return _edits.empty(); }
+		void			clear()		  { _edits.clear(); }
+
+		const Edit & operator[] (std::size_t i) const { return _edits[i]; }
+
+	private:
+		std::vector<Edit> _edits;
+	};
+}
+
+#endif
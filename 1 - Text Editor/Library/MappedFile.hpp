@@ -0,0 +1,124 @@
+/**
+* File:		MappedFile.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a read-only memory mapping of a whole file, used by Document::load(path) to tokenize a
+*			file in place instead of extracting each word through an istream. Value types that keep pointing into the
+*			mapping after the load (see Library/Token.hpp) declare so through ViewsMapping, and the Document then
+*			keeps the mapping alive for as long as it might be referenced.
+*/
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+// includes
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace Library {
+	// trait for Document value types that refer to the mapped text instead of copying it
+	template<class T>
+	struct ViewsMapping : std::false_type {};
+
+	class MappedFile {
+	public:
+		// map the whole file. If the file can't be opened, the mapping is closed and its view is empty
+		explicit MappedFile(const std::filesystem::path & path) {
+#ifdef _WIN32
+			// shared for delete too, so a save can rename a new file over this one while words still view it
+			HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return;
+			}
+
+			LARGE_INTEGER size;
+			if (GetFileSizeEx(file, &size)) {
+				_open = true;
+				_size = static_cast<std::size_t>(size.QuadPart);
+				if (_size > 0) {
+					_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+					if (_mapping != nullptr) {
+						_data = static_cast<const char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+					}
+					_open = _data != nullptr;
+				}
+			}
+			CloseHandle(file);
+#else
+			const int file = ::open(path.c_str(), O_RDONLY);
+			if (file < 0) {
+				return;
+			}
+
+			struct stat info;
+			if (::fstat(file, &info) == 0) {
+				_open = true;
+				_size = static_cast<std::size_t>(info.st_size);
+				if (_size > 0) {
+					void * address = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+					if (address != MAP_FAILED) {
+						// the whole file is read front to back while loading
+						::madvise(address, _size, MADV_SEQUENTIAL);
+						_data = static_cast<const char *>(address);
+					}
+					_open = _data != nullptr;
+				}
+			}
+			// the mapping stays valid after the descriptor is closed
+			::close(file);
+#endif
+			if (!_open) {
+				_size = 0;
+			}
+		}
+
+		~MappedFile() noexcept {
+#ifdef _WIN32
+			if (_data != nullptr) {
+				UnmapViewOfFile(_data);
+			}
+			if (_mapping != nullptr) {
+				CloseHandle(_mapping);
+			}
+#else
+			if (_data != nullptr) {
+				::munmap(const_cast<char *>(_data), _size);
+			}
+#endif
+		}
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile & operator=(const MappedFile &) = delete;
+
+		bool				is_open()	const { return _open; }
+		std::size_t			size()		const { return _size; }
+		std::string_view	view()		const { return std::string_view(_data, _size); }
+
+	private:
+		const char *	_data = nullptr;
+		std::size_t		_size = 0;
+		bool			_open = false;
+#ifdef _WIN32
+		HANDLE			_mapping = nullptr;
+#endif
+	};
+}
+
+#endif
@@ -0,0 +1,624 @@
+/**
+* File:		PagedDocument.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a document for files larger than memory. The words are kept in pages of about a fixed
+*			number of bytes of text, and only a working set of pages is resident at a time. A page that isn't resident
+*			is read back and tokenized when it is needed: from its range of the source file if it hasn't changed, or
+*			from a spill file the page was written to when it was edited and then evicted. The least recently used page
+*			is evicted first.
+*
+*			Edits go through the pages in order, holding at most a page and the few words after it that a phrase could
+*			run into. A page an edit doesn't change is kept as it is, so it stays backed by the source file and costs
+*			nothing to evict. Pages are never changed once made, an edit makes new ones, so a snapshot is a copy of the
+*			page table rather than of the words, and pages are shared by every snapshot that has them.
+*
+*			The source file must not change while the document is in use. Spilled pages are appended to the spill file,
+*			which is removed with the document. A page that can't be read back throws std::ios_base::failure.
+*
+*			Usage:
+*				PagedDocument doc(64);							// at most 64 pages resident
+*				doc.load("corpus.txt");
+*				doc.substitute("effective length", "ineffective measurement");
+*				doc.save("edited.txt");
+*/
+
+#ifndef PAGED_DOCUMENT_HPP
+#define PAGED_DOCUMENT_HPP
+
+// includes
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <list>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Library/BufferedWriter.hpp"
+#include "Library/PhraseSearch.hpp"
+#include "Library/Profiler.hpp"
+#include "Library/ReadOnlyFile.hpp"
+#include "Library/Tokenizer.hpp"
+
+namespace Library {
+	class PagedDocument {
+	public:
+		using Words = std::vector<std::string>;
+		using PhraseType = std::string;
+
+		static constexpr std::size_t DefaultResidentPages = 64;
+		static constexpr std::size_t DefaultPageBytes = std::size_t(1) << 20;
+
+		// keep at most residentPages pages in memory (besides the few an operation is holding), cutting the source file
+		// into pages of about pageBytes bytes
+		explicit PagedDocument(std::size_t residentPages = DefaultResidentPages, std::size_t pageBytes = DefaultPageBytes) :
+			_store(std::make_unique<Store>(std::max<std::size_t>(residentPages, 1))),
+			_pageBytes(std::max<std::size_t>(pageBytes, 1)),
+			_pageWords(std::max<std::size_t>(pageBytes / 8, 1)) {}
+
+		PagedDocument(PagedDocument &&) = default;
+		PagedDocument & operator=(PagedDocument &&) = default;
+
+		// open a file and cut it into pages, reading it once to count the words in each. Nothing is kept resident. Returns
+		// false, leaving the document empty, if the file can't be read
+		bool load(const std::filesystem::path & path) {
+			PROFILE_SCOPE("paged_load");
+			_pages.clear();
+			_snapshots.clear();
+			_redo.clear();
+			_copy_buffer.clear();
+			_size = 0;
+			_store->clear();
+
+			if (!_store->source.open(path)) {
+				return false;
+			}
+
+			std::string buffer(_pageBytes, '\0');
+			std::size_t kept = 0;				// bytes of a word cut off by the end of the last read
+			std::uint64_t offset = 0;			// of the start of the buffer in the file
+			while (true) {
+				// a word longer than the buffer grows it
+				if (kept == buffer.size()) {
+					buffer.resize(buffer.size() * 2);
+				}
+				const std::size_t wanted = buffer.size() - kept;
+				const std::size_t read = _store->source.read(offset + kept, &buffer[kept], wanted);
+				const std::size_t size = kept + read;
+				const bool last = read < wanted;
+
+				// pages end at whitespace, so no word is split between two of them
+				std::size_t cut = size;
+				if (!last) {
+					while (cut > 0 && !Tokenizing::isSpace(buffer[cut - 1])) {
+						--cut;
+					}
+				}
+
+				std::size_t words = 0;
+				Tokenizer::split(std::string_view(buffer.data(), cut), [&](std::string_view) { ++words; });
+				if (words > 0) {
+					auto page = std::make_shared<Page>();
+					page->words = words;
+					page->backing = Backing::Source;
+					page->offset = offset;
+					page->length = cut;
+					_pages.push_back(std::move(page));
+					_size += words;
+				}
+
+				if (last) {
+					break;
+				}
+				offset += cut;
+				kept = size - cut;
+				std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(cut), buffer.begin() + static_cast<std::ptrdiff_t>(size), buffer.begin());
+			}
+			return true;
+		}
+
+		// number of words, pages, and pages resident right now
+		std::size_t size()		const { return _size; }
+		std::size_t pages()		const { return _pages.size(); }
+		std::size_t resident()	const { return _store->lru.size(); }
+
+		// pages read back from the source or spill file, and pages written to the spill file, so far
+		std::size_t faults()	const { return _store->faults; }
+		std::size_t spills()	const { return _store->spills; }
+
+
+		// Snapshot the document so it can be restored later. Only the page table is copied.
+		void snap() {
+			_snapshots.push_back(_pages);
+			_redo.clear();
+		}
+
+		void undo(std::size_t quantity = 1U) {
+			for (; quantity > 0 && !_snapshots.empty(); --quantity) {
+				_redo.push_back(std::move(_pages));
+				_pages = std::move(_snapshots.back());
+				_snapshots.pop_back();
+			}
+			_size = count(_pages);
+		}
+
+		void redo(std::size_t quantity = 1U) {
+			for (; quantity > 0 && !_redo.empty(); --quantity) {
+				_snapshots.push_back(std::move(_pages));
+				_pages = std::move(_redo.back());
+				_redo.pop_back();
+			}
+			_size = count(_pages);
+		}
+
+
+		// Copy the words from the first occurrence of one phrase through the next occurrence of another, to be pasted later.
+		// The copy is held in memory.
+		void copy_range(const PhraseType & startingPhrase, const PhraseType & endingPhrase) {
+			PROFILE_SCOPE("paged_copy_range");
+			const Words start = wordsOf(startingPhrase);
+			const Words end = wordsOf(endingPhrase);
+			if (start.empty() || end.empty()) {
+				return;
+			}
+
+			const std::size_t first = find(start, 0);
+			if (first == _size) {
+				return;
+			}
+			const std::size_t last = find(end, first + start.size());
+			if (last == _size) {
+				return;
+			}
+			_copy_buffer = range(first, last + end.size());
+		}
+
+		// insert the copied words after the first occurrence of a phrase
+		void paste_after(const PhraseType & pasteAfterPhrase) {
+			PROFILE_SCOPE("paged_paste_after");
+			const Words phrase = wordsOf(pasteAfterPhrase);
+			if (phrase.empty() || _copy_buffer.empty()) {
+				return;
+			}
+
+			const std::size_t position = find(phrase, 0);
+			if (position != _size) {
+				insert(position + phrase.size(), _copy_buffer);
+			}
+		}
+
+		// remove every occurrence of a phrase
+		void erase(const PhraseType & phrase) {
+			PROFILE_SCOPE("paged_erase");
+			const Words erased = wordsOf(phrase);
+			if (!erased.empty()) {
+				replace(erased, Words());
+			}
+		}
+
+		// replace every occurrence of a phrase with another. As with Document, nothing is replaced with an empty phrase
+		void substitute(const PhraseType & oldPhrase, const PhraseType & newPhrase) {
+			PROFILE_SCOPE("paged_substitute");
+			const Words phrase = wordsOf(oldPhrase);
+			const Words replacement = wordsOf(newPhrase);
+			if (!(phrase.empty() || replacement.empty())) {
+				replace(phrase, replacement);
+			}
+		}
+
+		// word positions of every occurrence of a phrase, overlapping ones included
+		std::vector<std::size_t> find_all(const PhraseType & phrase) const {
+			PROFILE_SCOPE("paged_find_all");
+			std::vector<std::size_t> found;
+			const Words searched = wordsOf(phrase);
+			if (!searched.empty()) {
+				scan(searched, 0, [&](std::size_t position) {
+					found.push_back(position);
+					return true;
+				});
+			}
+			return found;
+		}
+
+
+		// write the words out one per line, as Document does, a page at a time. Returns false if anything failed
+		bool save(std::ostream & stream) const {
+			BufferedWriter out(stream);
+			return write(out);
+		}
+
+		bool save(const std::filesystem::path & path) const {
+			PROFILE_SCOPE("paged_save");
+			// the source file may be the one being written, so the new text goes next to it and replaces it at the end.
+			// ReadOnlyFile lets the source be renamed over, and its pages are still read from the file that was loaded
+			std::filesystem::path partial(path);
+			partial += ".partial";
+			bool good;
+			{
+				BufferedWriter out(partial);
+				good = write(out);
+			}
+			std::error_code error;
+			if (good) {
+				std::filesystem::rename(partial, path, error);
+			}
+			else {
+				std::filesystem::remove(partial, error);
+			}
+			return good && !error;
+		}
+
+		friend std::ostream & operator<< (std::ostream & s, const PagedDocument & document) {
+			document.save(s);
+			return s;
+		}
+
+	private:
+		enum class Backing { None, Source, Spill };
+
+		// a run of words. The words never change; where they can be read back from, and whether they are resident, can
+		struct Page {
+			std::size_t							words = 0;
+			Backing								backing = Backing::None;
+			std::uint64_t						offset = 0;			// of the text in the source or spill file
+			std::uint64_t						length = 0;
+			std::shared_ptr<const Words>		resident;
+			std::list<std::shared_ptr<Page>>::iterator	lru;		// position in the resident list, if resident
+		};
+
+		using PageTable = std::vector<std::shared_ptr<Page>>;
+
+		// the files pages are read from and spilled to, and the resident pages, most recently used first
+		struct Store {
+			explicit Store(std::size_t capacity) : capacity(capacity) {}
+
+			~Store() {
+				clear();
+			}
+
+			void clear() {
+				for (auto & page : lru) {
+					page->resident.reset();
+				}
+				lru.clear();
+				source.close();
+				if (spill.is_open()) {
+					spill.close();
+					std::error_code error;
+					std::filesystem::remove(spillPath, error);
+				}
+				spill.clear();
+				spillEnd = 0;
+			}
+
+			ReadOnlyFile						source;
+			std::fstream						spill;
+			std::filesystem::path				spillPath;
+			std::uint64_t						spillEnd = 0;
+			std::list<std::shared_ptr<Page>>	lru;
+			std::size_t							capacity;
+			std::size_t							faults = 0;
+			std::size_t							spills = 0;
+		};
+
+		// split a phrase into words
+		static Words wordsOf(const PhraseType & phrase) {
+			Words result;
+			Tokenizer::split(phrase, [&](std::string_view word) { result.emplace_back(word); });
+			return result;
+		}
+
+		static std::size_t count(const PageTable & pages) {
+			std::size_t total = 0;
+			for (const auto & page : pages) {
+				total += page->words;
+			}
+			return total;
+		}
+
+		// the words of a page, read back if it isn't resident. Holding on to them keeps them in memory even if the page is
+		// evicted meanwhile
+		std::shared_ptr<const Words> fault(const std::shared_ptr<Page> & page) const {
+			Store & store = *_store;
+			if (page->resident) {
+				store.lru.splice(store.lru.begin(), store.lru, page->lru);
+				return page->resident;
+			}
+
+			PROFILE_SCOPE("paged_fault");
+			std::string text(static_cast<std::size_t>(page->length), '\0');
+			bool read = false;
+			if (page->backing == Backing::Source) {
+				read = store.source.read(page->offset, &text[0], text.size()) == text.size();
+			}
+			else if (page->backing == Backing::Spill) {
+				store.spill.clear();
+				store.spill.seekg(static_cast<std::streamoff>(page->offset));
+				read = static_cast<bool>(store.spill.read(&text[0], static_cast<std::streamsize>(text.size())));
+			}
+			if (!read) {
+				throw std::ios_base::failure("PagedDocument: a page couldn't be read back");
+			}
+
+			auto loaded = std::make_shared<Words>();
+			loaded->reserve(page->words);
+			Tokenizer::split(text, [&](std::string_view word) { loaded->emplace_back(word); });
+			++store.faults;
+			return admit(page, std::move(loaded));
+		}
+
+		// make words the resident words of a page, evicting the least recently used pages if there are too many
+		std::shared_ptr<const Words> admit(const std::shared_ptr<Page> & page, std::shared_ptr<const Words> words) const {
+			Store & store = *_store;
+			page->resident = std::move(words);
+			store.lru.push_front(page);
+			page->lru = store.lru.begin();
+
+			while (store.lru.size() > store.capacity) {
+				std::shared_ptr<Page> victim = std::move(store.lru.back());
+				store.lru.pop_back();
+				// a page no table holds any more is simply dropped
+				if (victim.use_count() > 1 && victim->backing == Backing::None) {
+					spill(*victim);
+				}
+				victim->resident.reset();
+			}
+			return page->resident;
+		}
+
+		// append an evicted page that has nowhere else to be read back from to the spill file
+		void spill(Page & page) const {
+			PROFILE_SCOPE("paged_spill");
+			Store & store = *_store;
+			if (!store.spill.is_open()) {
+				std::random_device random;
+				store.spillPath = std::filesystem::temp_directory_path() / ("paged-" + std::to_string(random()) + "-" + std::to_string(random()) + ".spill");
+				store.spill.open(store.spillPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+			}
+
+			store.spill.clear();
+			store.spill.seekp(static_cast<std::streamoff>(store.spillEnd));
+			std::uint64_t length = 0;
+			{
+				BufferedWriter out(store.spill);
+				for (const auto & word : *page.resident) {
+					out.write(word);
+					out.put('\n');
+					length += word.size() + 1;
+				}
+				if (!out.flush()) {
+					throw std::ios_base::failure("PagedDocument: a page couldn't be spilled");
+				}
+			}
+
+			page.backing = Backing::Spill;
+			page.offset = store.spillEnd;
+			page.length = length;
+			store.spillEnd += length;
+			++store.spills;
+		}
+
+		// a new page holding words, resident to begin with
+		std::shared_ptr<Page> makePage(Words words) const {
+			auto page = std::make_shared<Page>();
+			page->words = words.size();
+			admit(page, std::make_shared<const Words>(std::move(words)));
+			return page;
+		}
+
+		// add words to a page table as pages of at most _pageWords words
+		void appendPages(PageTable & pages, Words & words) const {
+			for (std::size_t first = 0; first < words.size(); first += _pageWords) {
+				const std::size_t last = std::min(words.size(), first + _pageWords);
+				if (first == 0 && last == words.size()) {
+					pages.push_back(makePage(std::move(words)));
+				}
+				else {
+					pages.push_back(makePage(Words(std::make_move_iterator(words.begin() + static_cast<std::ptrdiff_t>(first)), std::make_move_iterator(words.begin() + static_cast<std::ptrdiff_t>(last)))));
+				}
+			}
+			words.clear();
+		}
+
+		// up to count words following page i, which a phrase starting near the end of page i could run into
+		Words lookahead(std::size_t i, std::size_t count) const {
+			Words following;
+			for (++i; following.size() < count && i < _pages.size(); ++i) {
+				const auto words = fault(_pages[i]);
+				const std::size_t take = std::min(count - following.size(), words->size());
+				following.insert(following.end(), words->begin(), words->begin() + static_cast<std::ptrdiff_t>(take));
+			}
+			return following;
+		}
+
+		// call found with the position of each occurrence of a phrase starting at or after from, in order and overlapping
+		// ones included, until it returns false
+		template<class Function>
+		void scan(const Words & phrase, std::size_t from, Function found) const {
+			const PhraseSearcher<std::string> find(phrase.cbegin(), phrase.cend());
+			std::size_t base = 0;
+			for (std::size_t i = 0; i < _pages.size(); base += _pages[i]->words, ++i) {
+				if (base + _pages[i]->words <= from) {
+					continue;
+				}
+				const auto words = fault(_pages[i]);
+				const std::size_t begin = from > base ? from - base : 0;
+
+				// occurrences within the page
+				for (auto pos = find(words->cbegin() + static_cast<std::ptrdiff_t>(begin), words->cend()); pos != words->cend(); pos = find(std::next(pos), words->cend())) {
+					if (!found(base + static_cast<std::size_t>(pos - words->cbegin()))) {
+						return;
+					}
+				}
+
+				// occurrences starting in the last few words of the page and running into the next ones
+				const std::size_t tail = std::max(begin, words->size() - std::min(words->size(), phrase.size() - 1));
+				if (tail < words->size()) {
+					Words edge(words->begin() + static_cast<std::ptrdiff_t>(tail), words->end());
+					const Words following = lookahead(i, phrase.size() - 1);
+					const std::size_t inPage = edge.size();
+					edge.insert(edge.end(), following.begin(), following.end());
+					for (auto pos = find(edge.cbegin(), edge.cend()); pos != edge.cend() && static_cast<std::size_t>(pos - edge.cbegin()) < inPage; pos = find(std::next(pos), edge.cend())) {
+						if (!found(base + tail + static_cast<std::size_t>(pos - edge.cbegin()))) {
+							return;
+						}
+					}
+				}
+			}
+		}
+
+		// position of the first occurrence of a phrase at or after from, or size() if there is none
+		std::size_t find(const Words & phrase, std::size_t from) const {
+			std::size_t position = _size;
+			scan(phrase, from, [&](std::size_t found) {
+				position = found;
+				return false;
+			});
+			return position;
+		}
+
+		// the words in [first, last)
+		Words range(std::size_t first, std::size_t last) const {
+			Words result;
+			std::size_t base = 0;
+			for (std::size_t i = 0; i < _pages.size() && base < last; base += _pages[i]->words, ++i) {
+				if (base + _pages[i]->words <= first) {
+					continue;
+				}
+				const auto words = fault(_pages[i]);
+				const std::size_t begin = first > base ? first - base : 0;
+				const std::size_t end = std::min(words->size(), last - base);
+				result.insert(result.end(), words->begin() + static_cast<std::ptrdiff_t>(begin), words->begin() + static_cast<std::ptrdiff_t>(end));
+			}
+			return result;
+		}
+
+		// insert words before a position, remaking only the page it falls in
+		void insert(std::size_t position, const Words & inserted) {
+			PageTable pages;
+			pages.reserve(_pages.size() + 1);
+			std::size_t base = 0;
+			bool done = false;
+			for (std::size_t i = 0; i < _pages.size(); base += _pages[i]->words, ++i) {
+				// the position falls in this page, or right after the last one
+				if (!done && (position < base + _pages[i]->words || i + 1 == _pages.size())) {
+					const auto words = fault(_pages[i]);
+					const auto at = words->begin() + static_cast<std::ptrdiff_t>(position - base);
+					Words remade(words->begin(), at);
+					remade.insert(remade.end(), inserted.begin(), inserted.end());
+					remade.insert(remade.end(), at, words->end());
+					appendPages(pages, remade);
+					done = true;
+				}
+				else {
+					pages.push_back(_pages[i]);
+				}
+			}
+			if (!done) {
+				Words remade(inserted);
+				appendPages(pages, remade);
+			}
+			_pages = std::move(pages);
+			_size += inserted.size();
+		}
+
+		// replace every occurrence of a phrase, left to right and not overlapping, page by page. Pages no occurrence touches
+		// are kept as they are
+		void replace(const Words & phrase, const Words & replacement) {
+			const PhraseSearcher<std::string> find(phrase.cbegin(), phrase.cend());
+			PageTable pages;
+			pages.reserve(_pages.size());
+			std::size_t skip = 0;			// words at the start of this page that an occurrence in an earlier page covers
+			std::size_t replaced = 0;
+
+			for (std::size_t i = 0; i < _pages.size(); ++i) {
+				const auto words = fault(_pages[i]);
+				const auto begin = words->cbegin() + static_cast<std::ptrdiff_t>(std::min(skip, words->size()));
+				const std::size_t covered = skip > words->size() ? skip - words->size() : 0;
+
+				// occurrences within the page
+				std::vector<std::size_t> hits;
+				auto from = begin;
+				for (auto pos = find(from, words->cend()); pos != words->cend(); pos = find(from, words->cend())) {
+					hits.push_back(static_cast<std::size_t>(pos - words->cbegin()));
+					from = std::next(pos, static_cast<std::ptrdiff_t>(phrase.size()));
+				}
+
+				// and the first one running into the following pages
+				std::size_t edgeHit = words->size();
+				const auto tail = std::max(from, words->cend() - static_cast<std::ptrdiff_t>(std::min(words->size(), phrase.size() - 1)));
+				if (tail != words->cend()) {
+					Words edge(tail, words->cend());
+					const Words following = lookahead(i, phrase.size() - 1);
+					const std::size_t inPage = edge.size();
+					edge.insert(edge.end(), following.begin(), following.end());
+					const auto pos = find(edge.cbegin(), edge.cend());
+					if (pos != edge.cend() && static_cast<std::size_t>(pos - edge.cbegin()) < inPage) {
+						edgeHit = static_cast<std::size_t>(tail - words->cbegin()) + static_cast<std::size_t>(pos - edge.cbegin());
+					}
+				}
+
+				if (hits.empty() && edgeHit == words->size() && skip == 0) {
+					pages.push_back(_pages[i]);
+					continue;
+				}
+
+				// remake the page with the occurrences replaced
+				Words remade;
+				remade.reserve(words->size());
+				auto copied = begin;
+				for (auto hit : hits) {
+					const auto at = words->cbegin() + static_cast<std::ptrdiff_t>(hit);
+					remade.insert(remade.end(), copied, at);
+					remade.insert(remade.end(), replacement.begin(), replacement.end());
+					copied = at + static_cast<std::ptrdiff_t>(phrase.size());
+				}
+				const auto edgeAt = words->cbegin() + static_cast<std::ptrdiff_t>(edgeHit);
+				remade.insert(remade.end(), copied, edgeAt);
+				replaced += hits.size();
+				skip = covered;
+				if (edgeHit != words->size()) {
+					remade.insert(remade.end(), replacement.begin(), replacement.end());
+					skip = edgeHit + phrase.size() - words->size();
+					++replaced;
+				}
+				appendPages(pages, remade);
+			}
+
+			if (replaced > 0) {
+				_pages = std::move(pages);
+				_size = count(_pages);
+			}
+		}
+
+		bool write(BufferedWriter & out) const {
+			for (const auto & page : _pages) {
+				const auto words = fault(page);
+				for (const auto & word : *words) {
+					out.write(word);
+					out.put('\n');
+				}
+			}
+			return out.flush();
+		}
+
+		std::unique_ptr<Store>		_store;
+		std::size_t					_pageBytes;
+		std::size_t					_pageWords;			// most words a page made by an edit is given
+		PageTable					_pages;
+		std::deque<PageTable>		_snapshots;			// undo buffer, oldest first
+		std::deque<PageTable>		_redo;				// redo buffer, most recently undone last
+		Words						_copy_buffer;
+		std::size_t					_size = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,191 @@
+/**
+* File:		PhraseDictionary.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a set of phrases, each with the phrase that replaces it, compiled into an Aho-Corasick
+*			automaton over words so Document can find every one of them in a single pass. Each word of the text moves
+*			the automaton along one transition (or a few failure links), however many phrases there are, where looking for
+*			the phrases one at a time would take a pass over the text for each.
+*
+*			Where occurrences overlap, the one that starts first wins, and of those starting at the same word the longest
+*			wins. A dictionary is never changed once built, so one can be shared by any number of documents and threads.
+*
+*			Usage:
+*				std::map<std::string, std::string> terms{ { "effective length", "ineffective measurement" }, ... };
+*				auto dictionary = Document<>::dictionary(terms);
+*				doc.substitute_all(dictionary);
+*				otherDoc.substitute_all(dictionary);
+*/
+
+#ifndef PHRASE_DICTIONARY_HPP
+#define PHRASE_DICTIONARY_HPP
+
+// includes
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Library {
+	template<class T, class Hash = std::hash<T>>
+	class PhraseDictionary {
+	public:
+		using Phrase = std::vector<T>;
+
+		// an occurrence of phrase number phrase starting at a word position
+		struct Match {
+			std::size_t	position;
+			std::size_t	phrase;
+		};
+
+		PhraseDictionary() : _nodes(1) {}
+
+		// compile a range of (phrase, replacement) pairs. Empty phrases are skipped, and a phrase given twice keeps its first
+		// replacement
+		template<class InputIt>
+		PhraseDictionary(InputIt first, InputIt last) : _nodes(1) {
+			for (; first != last; ++first) {
+				add(first->first, first->second);
+			}
+			link();
+		}
+
+		// number of phrases
+		std::size_t size() const { return _phrases.size(); }
+		bool empty() const { return _phrases.empty(); }
+
+		const Phrase & phrase(std::size_t i)		const { return _phrases[i].first; }
+		const Phrase & replacement(std::size_t i)	const { return _phrases[i].second; }
+
+		// leftmost-longest occurrences in [first, last), in order and not overlapping, found in one pass. No match can
+		// start before the one ahead of it is decided, so a match is decided once the text has moved past the longest
+		// phrase's length beyond its start, and only that many candidates are kept at a time
+		template<class ForwardIt>
+		std::vector<Match> matches(ForwardIt first, ForwardIt last) const {
+			std::vector<Match> found;
+			if (_phrases.empty()) {
+				return found;
+			}
+
+			// the longest match starting at each of the last _longest positions, by position modulo _longest
+			struct Candidate {
+				std::size_t	position = none;
+				std::size_t	length = 0;
+				std::size_t	phrase = 0;
+			};
+			std::vector<Candidate> window(_longest);
+			std::size_t free = 0;			// first position not covered by a match already taken
+
+			auto decide = [&](std::size_t position) {
+				Candidate & candidate = window[position % _longest];
+				if (candidate.position == position && position >= free) {
+					found.push_back(Match{ position, candidate.phrase });
+					free = position + candidate.length;
+				}
+				candidate.position = none;
+			};
+
+			std::size_t node = 0;
+			std::size_t position = 0;
+			for (; first != last; ++first, ++position) {
+				node = step(node, *first);
+
+				// every phrase ending here, longest first
+				for (std::size_t output = _nodes[node].phrase != none ? node : _nodes[node].output; output != none; output = _nodes[output].output) {
+					const std::size_t length = _nodes[output].depth;
+					const std::size_t start = position + 1 - length;
+					Candidate & candidate = window[start % _longest];
+					if (candidate.position != start || candidate.length < length) {
+						candidate = Candidate{ start, length, _nodes[output].phrase };
+					}
+				}
+
+				if (position + 1 >= _longest) {
+					decide(position + 1 - _longest);
+				}
+			}
+
+			// positions the text ended too soon after to have been decided
+			for (std::size_t start = position + 1 >= _longest ? position + 1 - _longest : 0; start < position; ++start) {
+				decide(start);
+			}
+			return found;
+		}
+
+	private:
+		static constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+		struct Node {
+			std::unordered_map<T, std::size_t, Hash>	next;
+			std::size_t									failure = 0;		// node of the longest proper suffix that is a prefix of some phrase
+			std::size_t									output = none;		// nearest node along the failure links that ends a phrase
+			std::size_t									phrase = none;		// phrase ending at this node
+			std::size_t									depth = 0;
+		};
+
+		template<class Container>
+		void add(const Container & phrase, const Container & replacement) {
+			if (phrase.begin() == phrase.end()) {
+				return;
+			}
+
+			std::size_t node = 0;
+			for (const auto & word : phrase) {
+				const std::size_t child = _nodes[node].next.emplace(word, _nodes.size()).first->second;
+				if (child == _nodes.size()) {
+					_nodes.emplace_back();
+					_nodes.back().depth = _nodes[node].depth + 1;
+				}
+				node = child;
+			}
+
+			if (_nodes[node].phrase == none) {
+				_nodes[node].phrase = _phrases.size();
+				_phrases.emplace_back(Phrase(phrase.begin(), phrase.end()), Phrase(replacement.begin(), replacement.end()));
+				_longest = std::max(_longest, _nodes[node].depth);
+			}
+		}
+
+		// fill in the failure and output links, breadth first so a node's failure link is always done before its children's
+		void link() {
+			std::vector<std::size_t> queue;
+			for (const auto & child : _nodes[0].next) {
+				queue.push_back(child.second);
+			}
+
+			for (std::size_t i = 0; i < queue.size(); ++i) {
+				const std::size_t node = queue[i];
+				for (const auto & child : _nodes[node].next) {
+					const std::size_t failure = step(_nodes[node].failure, child.first);
+					_nodes[child.second].failure = failure;
+					_nodes[child.second].output = _nodes[failure].phrase != none ? failure : _nodes[failure].output;
+					queue.push_back(child.second);
+				}
+			}
+		}
+
+		// the node reached from node on word, following failure links until a transition on word exists or the root is reached
+		std::size_t step(std::size_t node, const T & word) const {
+			while (true) {
+				const auto & next = _nodes[node].next;
+				auto found = next.find(word);
+				if (found != next.end()) {
+					return found->second;
+				}
+				if (node == 0) {
+					return 0;
+				}
+				node = _nodes[node].failure;
+			}
+		}
+
+		std::vector<Node>						_nodes;			// node 0 is the root
+		std::vector<std::pair<Phrase, Phrase>>	_phrases;		// each phrase and its replacement
+		std::size_t								_longest = 0;	// words in the longest phrase
+	};
+}
+
+#endif
@@ -0,0 +1,105 @@
+/**
+* File:		PhraseSearch.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the phrase search engine used by Document. A PhraseSearcher preprocesses a phrase once
+*			and can then be run any number of times over any range of words, which is how Document finds every
+*			occurrence of a phrase within one operation without starting over from scratch after each hit.
+*
+*			The search is Knuth-Morris-Pratt over words: after a partial match fails, it falls back to the longest
+*			prefix of the phrase that is still matched instead of backing up in the text, so every search is linear
+*			and works with forward iterators. While nothing is matched it jumps to the next occurrence of the first
+*			word with std::find, which is as fast as a plain scan gets. (Skipping ahead Boyer-Moore-Horspool style was
+*			measured and lost: comparing two words is about as cheap as looking one up in a skip table.)
+*/
+
+#ifndef PHRASE_SEARCH_HPP
+#define PHRASE_SEARCH_HPP
+
+// includes
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+namespace Library {
+	template<class T>
+	class PhraseSearcher {
+	public:
+		// preprocess the phrase held in a range of words, keeping the copy of it and its table in memory from a resource
+		template<class InputIt>
+		PhraseSearcher(InputIt first, InputIt last, std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+			: _phrase(first, last, resource), _failure(resource) {
+			buildFailureTable();
+		}
+
+		// number of words in the phrase
+		std::size_t size() const { return _phrase.size(); }
+
+		// find the first occurrence of the phrase in [first, last), returning last if there is none. An empty phrase is
+		// never found
+		template<class ForwardIt>
+		ForwardIt operator()(ForwardIt first, ForwardIt last) const {
+			if (_phrase.empty()) {
+				return last;
+			}
+
+			// start is where the partial match began, and trails current by matched words. It only ever moves forward
+			ForwardIt start = first;
+			ForwardIt current = first;
+			std::size_t matched = 0;
+
+			while (true) {
+				if (matched == 0) {
+					// nothing matched yet, so jump straight to the next candidate
+					current = std::find(current, last, _phrase.front());
+					if (current == last) {
+						return last;
+					}
+					start = current;
+					matched = 1;
+				}
+				else if (current == last) {
+					return last;
+				}
+				else if (*current == _phrase[matched]) {
+					++matched;
+				}
+				else {
+					// fall back to the longest prefix of the phrase that the text still matches and compare again
+					const std::size_t fallback = _failure[matched - 1];
+					std::advance(start, matched - fallback);
+					matched = fallback;
+					continue;
+				}
+
+				++current;
+				if (matched == _phrase.size()) {
+					return start;
+				}
+			}
+		}
+
+	private:
+		// _failure[i] is the length of the longest proper prefix of the phrase that is also a suffix of its first i + 1 words
+		void buildFailureTable() {
+			_failure.assign(_phrase.size(), 0);
+			std::size_t length = 0;
+			for (std::size_t i = 1; i < _phrase.size(); ++i) {
+				while (length > 0 && !(_phrase[i] == _phrase[length])) {
+					length = _failure[length - 1];
+				}
+				if (_phrase[i] == _phrase[length]) {
+					++length;
+				}
+				_failure[i] = length;
+			}
+		}
+
+		std::pmr::vector<T>				_phrase;
+		std::pmr::vector<std::size_t>	_failure;
+	};
+}
+
+#endif
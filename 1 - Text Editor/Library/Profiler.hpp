@@ -0,0 +1,479 @@
+/**
+* File:		Profiler.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains instrumentation cheap enough to leave compiled into a release build. Code is marked with
+*			named probes; while profiling is switched off a probe costs one relaxed load and a branch, and while it is on
+*			it costs two reads of the time stamp counter and a few increments of counters owned by the calling thread.
+*			Nothing is written anywhere until a report is asked for.
+*
+*			Probes nest: a probe entered while another is running is timed as a child of it, so the time spent in
+*			Document::substitute is broken down into its search and its rewrite. Each thread keeps its own latency
+*			histogram per probe, so threads never contend; a report merges them. Defining LIBRARY_NO_PROFILING removes the
+*			probes from the build entirely.
+*
+*			Usage:
+*				void work() {
+*					PROFILE_SCOPE("work");
+*					...
+*				}
+*
+*				Library::Profiler::enable();
+*				work();
+*				Library::Profiler::write(std::cout);
+*/
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+// includes
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
+#ifdef LIBRARY_NO_PROFILING
+	#define PROFILE_SCOPE(name) ((void)0)
+#else
+	#define PROFILE_CONCAT_(a, b) a##b
+	#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+	// time the rest of the enclosing block under the given name, which must be a string literal
+	#define PROFILE_SCOPE(name) \
+		static const ::Library::ProbeSite PROFILE_CONCAT(probeSite_, __LINE__)(name); \
+		const ::Library::ProbeScope PROFILE_CONCAT(probeScope_, __LINE__)(PROFILE_CONCAT(probeSite_, __LINE__))
+#endif
+
+namespace Library {
+	// one line of a report: a probe reached through a particular chain of enclosing probes
+	struct ProfileEntry {
+		std::string		path;			// names of the enclosing probes and this one, separated by '/'
+		std::string		name;
+		std::size_t		depth;			// 0 for probes entered outside any other
+		std::uint64_t	count;
+		double			total_ns;
+		double			self_ns;		// total less the time spent in child probes
+		double			min_ns;
+		double			median_ns;		// percentiles are read from the histogram, so they are within 1/8 of the real value
+		double			p99_ns;
+		double			max_ns;
+	};
+
+	namespace Profiling {
+		// time stamp counter where there is one, the steady clock in nanoseconds otherwise
+		inline std::uint64_t ticks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+			return __rdtsc();
+#else
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+		}
+
+		inline unsigned highestBit(std::uint64_t value) {
+#if defined(_MSC_VER)
+			unsigned long bit;
+			_BitScanReverse64(&bit, value);
+			return static_cast<unsigned>(bit);
+#else
+			return 63U - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+		}
+
+		// latencies are bucketed by their highest bit and the two bits below it, so each power of two is split in four
+		constexpr std::size_t Buckets = 256;
+
+		inline std::size_t bucketOf(std::uint64_t ticks) {
+			if (ticks < 4) {
+				return static_cast<std::size_t>(ticks);
+			}
+			const unsigned bit = highestBit(ticks);
+			return 4 * (bit - 1) + static_cast<std::size_t>((ticks >> (bit - 2)) & 3);
+		}
+
+		// middle of the range of latencies a bucket holds
+		inline double bucketValue(std::size_t bucket) {
+			if (bucket < 4) {
+				return static_cast<double>(bucket);
+			}
+			const unsigned bit = static_cast<unsigned>(bucket / 4 + 1);
+			const double width = static_cast<double>(std::uint64_t(1) << (bit - 2));
+			return static_cast<double>(4 + bucket % 4) * width + (width - 1) / 2;
+		}
+
+		// the latencies of one probe on one thread. Only the owning thread writes, so the counters are updated with
+		// plain loads and stores; they are atomic only so a report can read them while the thread runs
+		struct Histogram {
+			std::atomic<std::uint64_t>	count{ 0 };
+			std::atomic<std::uint64_t>	total{ 0 };
+			std::atomic<std::uint64_t>	min{ UINT64_MAX };
+			std::atomic<std::uint64_t>	max{ 0 };
+			std::array<std::atomic<std::uint64_t>, Buckets>	buckets = {};
+
+			void record(std::uint64_t ticks) {
+				add(count, 1);
+				add(total, ticks);
+				add(buckets[bucketOf(ticks)], 1);
+				if (ticks < min.load(std::memory_order_relaxed)) {
+					min.store(ticks, std::memory_order_relaxed);
+				}
+				if (ticks > max.load(std::memory_order_relaxed)) {
+					max.store(ticks, std::memory_order_relaxed);
+				}
+			}
+
+			void reset() {
+				count.store(0, std::memory_order_relaxed);
+				total.store(0, std::memory_order_relaxed);
+				min.store(UINT64_MAX, std::memory_order_relaxed);
+				max.store(0, std::memory_order_relaxed);
+				for (auto & bucket : buckets) {
+					bucket.store(0, std::memory_order_relaxed);
+				}
+			}
+
+		private:
+			static void add(std::atomic<std::uint64_t> & counter, std::uint64_t amount) {
+				counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+			}
+		};
+
+		// latencies of one probe merged from every thread
+		struct Summary {
+			std::uint64_t							count = 0;
+			std::uint64_t							total = 0;
+			std::uint64_t							min = UINT64_MAX;
+			std::uint64_t							max = 0;
+			std::array<std::uint64_t, Buckets>		buckets = {};
+
+			void add(const Histogram & histogram) {
+				count += histogram.count.load(std::memory_order_relaxed);
+				total += histogram.total.load(std::memory_order_relaxed);
+				min = std::min(min, histogram.min.load(std::memory_order_relaxed));
+				max = std::max(max, histogram.max.load(std::memory_order_relaxed));
+				for (std::size_t i = 0; i < Buckets; ++i) {
+					buckets[i] += histogram.buckets[i].load(std::memory_order_relaxed);
+				}
+			}
+
+			void add(const Summary & other) {
+				count += other.count;
+				total += other.total;
+				min = std::min(min, other.min);
+				max = std::max(max, other.max);
+				for (std::size_t i = 0; i < Buckets; ++i) {
+					buckets[i] += other.buckets[i];
+				}
+			}
+
+			// latency below which the given fraction of the samples fall
+			double percentile(double fraction) const {
+				const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(fraction * static_cast<double>(count) + 0.5));
+				std::uint64_t seen = 0;
+				for (std::size_t i = 0; i < Buckets; ++i) {
+					seen += buckets[i];
+					if (seen >= rank) {
+						return std::clamp(bucketValue(i), static_cast<double>(min), static_cast<double>(max));
+					}
+				}
+				return static_cast<double>(max);
+			}
+		};
+
+		class ThreadProfile;
+
+		// a namespace scope flag rather than a member of the registry, so checking it needs no initialization guard
+		inline std::atomic<bool> enabled{ false };
+
+		// the probes and the tree of the ways they nest, shared by every thread. Node 0 is the root, outside any probe
+		struct Registry {
+			struct Node {
+				std::size_t	site;
+				std::size_t	parent;
+			};
+
+			std::mutex										mutex;
+			std::vector<const char *>						sites;
+			std::vector<Node>								nodes{ Node{ 0, 0 } };
+			std::map<std::pair<std::size_t, std::size_t>, std::size_t>	children;	// (parent, site) to node
+			std::vector<ThreadProfile *>					threads;
+			std::vector<Summary>							retired;	// merged histograms of threads that have exited
+
+			// point the time stamp counter is calibrated against
+			const std::uint64_t								startTicks = ticks();
+			const std::chrono::steady_clock::time_point		startTime = std::chrono::steady_clock::now();
+
+			static Registry & instance() {
+				static Registry registry;
+				return registry;
+			}
+
+			std::size_t node(std::size_t parent, std::size_t site) {
+				std::lock_guard<std::mutex> lock(mutex);
+				auto found = children.try_emplace(std::make_pair(parent, site), nodes.size());
+				if (found.second) {
+					nodes.push_back(Node{ site, parent });
+				}
+				return found.first->second;
+			}
+		};
+
+		// the probes running on one thread and the latencies it has recorded
+		class ThreadProfile {
+		public:
+			ThreadProfile() {
+				Registry & registry = Registry::instance();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.threads.push_back(this);
+			}
+
+			// keep the thread's latencies for later reports
+			~ThreadProfile() {
+				Registry & registry = Registry::instance();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+				if (registry.retired.size() < _histograms.size()) {
+					registry.retired.resize(_histograms.size());
+				}
+				for (std::size_t i = 0; i < _histograms.size(); ++i) {
+					registry.retired[i].add(_histograms[i]);
+				}
+			}
+
+			ThreadProfile(const ThreadProfile &) = delete;
+			ThreadProfile & operator=(const ThreadProfile &) = delete;
+
+			static ThreadProfile & local() {
+				thread_local ThreadProfile profile;
+				return profile;
+			}
+
+			// make the probe at site the running one, returning the one it interrupts
+			std::size_t enter(std::size_t site) {
+				const std::size_t parent = _current;
+				if (_children.size() <= parent) {
+					_children.resize(parent + 1);
+				}
+
+				auto & known = _children[parent];
+				auto found = std::find_if(known.begin(), known.end(), [site](const std::pair<std::size_t, std::size_t> & child) { return child.first == site; });
+				if (found == known.end()) {
+					known.emplace_back(site, Registry::instance().node(parent, site));
+					found = known.end() - 1;
+				}
+				_current = found->second;
+				return parent;
+			}
+
+			// record the running probe's latency and go back to the one it interrupted
+			void leave(std::size_t parent, std::uint64_t elapsed) {
+				if (_histograms.size() <= _current) {
+					// a report may be reading the histograms, and growing the deque changes its bookkeeping
+					std::lock_guard<std::mutex> lock(_growing);
+					while (_histograms.size() <= _current) {
+						_histograms.emplace_back();
+					}
+				}
+				_histograms[_current].record(elapsed);
+				_current = parent;
+			}
+
+			// add this thread's latencies to summaries indexed by node. Called with the registry locked
+			void collect(std::vector<Summary> & summaries) {
+				std::lock_guard<std::mutex> lock(_growing);
+				if (summaries.size() < _histograms.size()) {
+					summaries.resize(_histograms.size());
+				}
+				for (std::size_t i = 0; i < _histograms.size(); ++i) {
+					summaries[i].add(_histograms[i]);
+				}
+			}
+
+			void reset() {
+				std::lock_guard<std::mutex> lock(_growing);
+				for (auto & histogram : _histograms) {
+					histogram.reset();
+				}
+			}
+
+		private:
+			std::size_t													_current = 0;	// node of the running probe
+			std::vector<std::vector<std::pair<std::size_t, std::size_t>>>	_children;		// per node, the (site, node) pairs seen
+			std::deque<Histogram>										_histograms;	// per node; a deque never moves its elements
+			std::mutex													_growing;
+		};
+	}
+
+	// a named place in the code that is timed. Declared static by PROFILE_SCOPE, so it is registered only once
+	class ProbeSite {
+	public:
+		explicit ProbeSite(const char * name) {
+			Profiling::Registry & registry = Profiling::Registry::instance();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			_id = registry.sites.size();
+			registry.sites.push_back(name);
+		}
+
+		std::size_t id() const { return _id; }
+
+	private:
+		std::size_t _id;
+	};
+
+	// times the probe at a site from construction to destruction, if profiling was on when it started
+	class ProbeScope {
+	public:
+		explicit ProbeScope(const ProbeSite & site) {
+			if (Profiling::enabled.load(std::memory_order_relaxed)) {
+				_thread = &Profiling::ThreadProfile::local();
+				_parent = _thread->enter(site.id());
+				_start = Profiling::ticks();
+			}
+		}
+
+		~ProbeScope() {
+			if (_thread != nullptr) {
+				const std::uint64_t stop = Profiling::ticks();
+				_thread->leave(_parent, stop - _start);
+			}
+		}
+
+		ProbeScope(const ProbeScope &) = delete;
+		ProbeScope & operator=(const ProbeScope &) = delete;
+
+	private:
+		Profiling::ThreadProfile *	_thread = nullptr;
+		std::size_t					_parent = 0;
+		std::uint64_t				_start = 0;
+	};
+
+	class Profiler {
+	public:
+		// switch recording on or off for every thread. Probes already running when it is switched on aren't recorded
+		static void enable(bool enabled = true) { Profiling::enabled.store(enabled, std::memory_order_relaxed); }
+		static bool enabled() { return Profiling::enabled.load(std::memory_order_relaxed); }
+
+		// forget everything recorded so far
+		static void reset() {
+			Profiling::Registry & registry = Profiling::Registry::instance();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			for (auto thread : registry.threads) {
+				thread->reset();
+			}
+			registry.retired.clear();
+		}
+
+		// everything recorded so far by every thread, with each probe followed by the probes nested in it
+		static std::vector<ProfileEntry> report() {
+			Profiling::Registry & registry = Profiling::Registry::instance();
+			const double nanosecondsPerTick = calibrate(registry);
+
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			std::vector<Profiling::Summary> summaries(registry.retired);
+			for (auto thread : registry.threads) {
+				thread->collect(summaries);
+			}
+			summaries.resize(registry.nodes.size());
+
+			// children of each node, in the order they were first reached
+			std::vector<std::vector<std::size_t>> children(registry.nodes.size());
+			for (std::size_t node = 1; node < registry.nodes.size(); ++node) {
+				children[registry.nodes[node].parent].push_back(node);
+			}
+
+			std::vector<ProfileEntry> entries;
+			std::vector<std::pair<std::size_t, std::string>> pending;		// (node, path of its parent), depth first
+			for (auto child = children[0].rbegin(); child != children[0].rend(); ++child) {
+				pending.emplace_back(*child, std::string());
+			}
+			while (!pending.empty()) {
+				const auto node = pending.back().first;
+				const std::string parentPath = std::move(pending.back().second);
+				pending.pop_back();
+
+				const auto & summary = summaries[node];
+				const std::string name = registry.sites[registry.nodes[node].site];
+				const std::string path = parentPath.empty() ? name : parentPath + '/' + name;
+
+				std::uint64_t childTotal = 0;
+				for (auto child : children[node]) {
+					childTotal += summaries[child].total;
+				}
+
+				if (summary.count > 0) {
+					entries.push_back(ProfileEntry{ path, name, static_cast<std::size_t>(std::count(path.begin(), path.end(), '/')), summary.count,
+						static_cast<double>(summary.total) * nanosecondsPerTick,
+						static_cast<double>(summary.total - std::min(summary.total, childTotal)) * nanosecondsPerTick,
+						static_cast<double>(summary.min) * nanosecondsPerTick,
+						summary.percentile(0.5) * nanosecondsPerTick,
+						summary.percentile(0.99) * nanosecondsPerTick,
+						static_cast<double>(summary.max) * nanosecondsPerTick });
+				}
+
+				for (auto child = children[node].rbegin(); child != children[node].rend(); ++child) {
+					pending.emplace_back(*child, path);
+				}
+			}
+			return entries;
+		}
+
+		// the report as an indented table, times in microseconds
+		static void write(std::ostream & stream) {
+			const auto entries = report();
+
+			std::size_t width = 5;
+			for (const auto & entry : entries) {
+				width = std::max(width, 2 * entry.depth + entry.name.size());
+			}
+
+			const auto flags = stream.flags();
+			const auto precision = stream.precision();
+			stream << std::left << std::setw(static_cast<int>(width)) << "probe" << std::right
+				<< std::setw(10) << "count" << std::setw(14) << "total us" << std::setw(14) << "self us"
+				<< std::setw(12) << "min us" << std::setw(12) << "median us" << std::setw(12) << "p99 us" << std::setw(12) << "max us" << '\n';
+			stream << std::fixed << std::setprecision(1);
+			for (const auto & entry : entries) {
+				stream << std::left << std::setw(static_cast<int>(width)) << (std::string(2 * entry.depth, ' ') + entry.name) << std::right
+					<< std::setw(10) << entry.count << std::setw(14) << entry.total_ns / 1000 << std::setw(14) << entry.self_ns / 1000
+					<< std::setw(12) << entry.min_ns / 1000 << std::setw(12) << entry.median_ns / 1000
+					<< std::setw(12) << entry.p99_ns / 1000 << std::setw(12) << entry.max_ns / 1000 << '\n';
+			}
+			stream.flags(flags);
+			stream.precision(precision);
+		}
+
+	private:
+		// nanoseconds per tick, measured over the time since the first probe site was registered
+		static double calibrate(const Profiling::Registry & registry) {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+			auto elapsed = std::chrono::steady_clock::now() - registry.startTime;
+			if (elapsed < std::chrono::milliseconds(10)) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+			}
+			const std::uint64_t ticks = Profiling::ticks() - registry.startTicks;
+			elapsed = std::chrono::steady_clock::now() - registry.startTime;
+			return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(std::max<std::uint64_t>(ticks, 1));
+#else
+			static_cast<void>(registry);
+			return 1.0;
+#endif
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,122 @@
+/**
+* File:		ReadOnlyFile.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a file kept open for reading ranges of it by offset, used by PagedDocument to read pages
+*			back from its source file. Like MappedFile, it lets the file be renamed over while it is open, so a document
+*			can be saved back to the file it was loaded from; the ranges read are still those of the file that was opened.
+*
+*			Usage:
+*				ReadOnlyFile file(std::filesystem::path("corpus.txt"));
+*				std::string text(4096, '\0');
+*				text.resize(file.read(0, &text[0], text.size()));
+*/
+
+#ifndef READ_ONLY_FILE_HPP
+#define READ_ONLY_FILE_HPP
+
+// includes
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace Library {
+	class ReadOnlyFile {
+	public:
+		ReadOnlyFile() = default;
+
+		// open the file. If it can't be opened, is_open() is false and nothing can be read
+		explicit ReadOnlyFile(const std::filesystem::path & path) {
+			open(path);
+		}
+
+		~ReadOnlyFile() noexcept {
+			close();
+		}
+
+		ReadOnlyFile(const ReadOnlyFile &) = delete;
+		ReadOnlyFile & operator=(const ReadOnlyFile &) = delete;
+
+		bool open(const std::filesystem::path & path) {
+			close();
+#ifdef _WIN32
+			// shared for delete too, which is what lets another file be renamed over this one
+			_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+			_file = ::open(path.c_str(), O_RDONLY);
+#endif
+			return is_open();
+		}
+
+		void close() noexcept {
+			if (!is_open()) {
+				return;
+			}
+#ifdef _WIN32
+			CloseHandle(_file);
+			_file = INVALID_HANDLE_VALUE;
+#else
+			::close(_file);
+			_file = -1;
+#endif
+		}
+
+#ifdef _WIN32
+		bool is_open() const { return _file != INVALID_HANDLE_VALUE; }
+#else
+		bool is_open() const { return _file >= 0; }
+#endif
+
+		// read up to size bytes from offset into out. Returns the number read, which is less than size only at the end of
+		// the file or if reading failed
+		std::size_t read(std::uint64_t offset, char * out, std::size_t size) const {
+			std::size_t total = 0;
+			while (is_open() && total < size) {
+#ifdef _WIN32
+				OVERLAPPED at = {};
+				at.Offset = static_cast<DWORD>(offset + total);
+				at.OffsetHigh = static_cast<DWORD>((offset + total) >> 32);
+				DWORD got = 0;
+				const DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(size - total, 1U << 30));
+				if (!ReadFile(_file, out + total, chunk, &got, &at) || got == 0) {
+					break;
+				}
+#else
+				const auto got = ::pread(_file, out + total, size - total, static_cast<off_t>(offset + total));
+				if (got < 0 && errno == EINTR) {
+					continue;
+				}
+				if (got <= 0) {
+					break;
+				}
+#endif
+				total += static_cast<std::size_t>(got);
+			}
+			return total;
+		}
+
+	private:
+#ifdef _WIN32
+		HANDLE	_file = INVALID_HANDLE_VALUE;
+#else
+		int		_file = -1;
+#endif
+	};
+}
+
+#endif
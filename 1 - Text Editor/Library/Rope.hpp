@@ -0,0 +1,618 @@
+/**
+* File:		Rope.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a sequence container built for the editing operations of Document. Elements live in
+*			contiguous chunks of bounded size, so inserting or erasing in the middle only shifts the elements of the
+*			chunks involved instead of the whole tail, while sequential scans (std::search) still walk through
+*			contiguous memory. A table of chunk starting positions gives logarithmic random access.
+*
+*			Chunks, and the table of chunks, are shared between copies and only cloned when a copy that shares them
+*			is modified (copy-on-write). Copying a Rope is therefore O(1), and a copy taken before an edit keeps
+*			sharing every chunk the edit did not touch. Only ropes whose allocators compare equal share; a copy with
+*			an unequal allocator, such as a polymorphic allocator on another arena, copies the elements instead.
+*			Because chunks may be shared, elements cannot be modified through iterators; use insert and erase, as with
+*			the keys of std::set.
+*
+*			Cost summary, with B the chunk capacity:
+*			-copy: O(1) with an equal allocator, O(n) otherwise
+*			-insert/erase of k elements: O(B + k + n/B)
+*			-replace_all/replace_ranges: O(n/B + B per chunk with a replacement + the replacements)
+*			-iterator increment: O(1), iterator advance by n: O(1) within a chunk, O(log(n/B)) otherwise
+*
+*			It has the same shape as the STL sequence containers, so it plugs straight into Document:
+*				Document<Library::Rope>
+*/
+
+#ifndef ROPE_HPP
+#define ROPE_HPP
+
+// includes
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Library {
+	template<class T, class Allocator = std::allocator<T>>
+	class Rope {
+	public:
+		using value_type		= T;
+		using allocator_type	= Allocator;
+		using size_type			= std::size_t;
+		using difference_type	= std::ptrdiff_t;
+		using reference			= const T &;
+		using const_reference	= const T &;
+
+		class Iterator;
+		using iterator			= Iterator;
+		using const_iterator	= Iterator;
+
+	private:
+		using AllocatorTraits	= std::allocator_traits<Allocator>;
+		using ChunkType			= std::vector<T, Allocator>;
+		using ChunkPointer		= std::shared_ptr<ChunkType>;
+		using ChunkList			= std::vector<ChunkPointer, typename std::allocator_traits<Allocator>::template rebind_alloc<ChunkPointer>>;
+		using StartList			= std::vector<size_type, typename std::allocator_traits<Allocator>::template rebind_alloc<size_type>>;
+
+		// the chunks, in order, and the position of the first element of each chunk followed by the size
+		struct Table {
+			explicit Table(const Allocator & allocator) : chunks(allocator), starts(1, 0, allocator) {}
+			Table(const Table & other, const Allocator & allocator) : chunks(other.chunks, allocator), starts(other.starts, allocator) {}
+
+			ChunkList	chunks;		// never holds an empty chunk
+			StartList	starts;
+		};
+
+		// aim for chunks of a few kilobytes, but never let them get so small that the chunk table dominates
+		static constexpr size_type chunkCapacity() {
+			return sizeof(T) * 64 > 8192 ? 64 : 8192 / sizeof(T);
+		}
+
+	public:
+		// random access iterator over the chunks. It caches the bounds of the current chunk so stepping through a
+		// chunk is a pointer increment
+		class Iterator {
+			friend class Rope;
+
+		public:
+			using iterator_category	= std::random_access_iterator_tag;
+			using value_type		= T;
+			using difference_type	= std::ptrdiff_t;
+			using pointer			= const T *;
+			using reference			= const T &;
+
+			Iterator() = default;
+
+			reference operator*  () const { return *_current; }
+			pointer   operator-> () const { return _current; }
+			reference operator[] (difference_type n) const { return *(*this + n); }
+
+			Iterator & operator++ () {
+				// step into the next chunk once this one is exhausted
+				if (++_current == _last) {
+					moveTo(_chunk + 1, 0);
+				}
+				return *this;
+			}
+
+			Iterator & operator-- () {
+				// step back into the previous chunk when at the front of this one (or at the end)
+				if (_current == _first) {
+					moveTo(_chunk - 1, _table->chunks[_chunk - 1]->size() - 1);
+				}
+				else {
+					--_current;
+				}
+				return *this;
+			}
+
+			Iterator operator++ (int) { Iterator old(*this); ++*this; return old; }
+			Iterator operator-- (int) { Iterator old(*this); --*this; return old; }
+
+			Iterator & operator+= (difference_type n) {
+				// stay within the current chunk when possible, otherwise look the position up in the chunk table
+				const difference_type offset = (_current - _first) + n;
+				if (offset >= 0 && offset < _last - _first) {
+					_current = _first + offset;
+				}
+				else {
+					seek(index() + n);
+				}
+				return *this;
+			}
+
+			Iterator & operator-= (difference_type n) { return *this += -n; }
+
+			friend Iterator operator+ (Iterator itr, difference_type n) { return itr += n; }
+			friend Iterator operator+ (difference_type n, Iterator itr) { return itr += n; }
+			friend Iterator operator- (Iterator itr, difference_type n) { return itr -= n; }
+
+			difference_type operator- (const Iterator & rhs) const {
+				return static_cast<difference_type>(index()) - static_cast<difference_type>(rhs.index());
+			}
+
+			bool operator== (const Iterator & rhs) const { return _chunk == rhs._chunk && _current == rhs._current; }
+			bool operator!= (const Iterator & rhs) const { return !(*this == rhs); }
+			bool operator<  (const Iterator & rhs) const {
+				return _chunk < rhs._chunk || (_chunk == rhs._chunk && _current < rhs._current);
+			}
+			bool operator>  (const Iterator & rhs) const { return rhs < *this; }
+			bool operator<= (const Iterator & rhs) const { return !(rhs < *this); }
+			bool operator>= (const Iterator & rhs) const { return !(*this < rhs); }
+
+			// position of the element within the whole sequence
+			size_type index() const {
+				return _table->starts[_chunk] + static_cast<size_type>(_current - _first);
+			}
+
+		private:
+			Iterator(const Table * table, size_type chunk, size_type offset) : _table(table) {
+				moveTo(chunk, offset);
+			}
+
+			// point at an offset within a chunk, or at the end if there is no such chunk
+			void moveTo(size_type chunk, size_type offset) {
+				_chunk = chunk;
+				if (chunk < _table->chunks.size()) {
+					const auto & elements = *_table->chunks[chunk];
+					_first   = elements.data();
+					_last    = _first + elements.size();
+					_current = _first + offset;
+				}
+				else {
+					_first = _current = _last = nullptr;
+				}
+			}
+
+			// point at an absolute position, using a binary search of the chunk table
+			void seek(size_type position) {
+				const auto & starts = _table->starts;
+				const size_type chunk = static_cast<size_type>(std::upper_bound(starts.cbegin(), starts.cend(), position) - starts.cbegin()) - 1;
+				moveTo(chunk, position - starts[chunk]);
+			}
+
+			const Table *	_table   = nullptr;
+			size_type		_chunk   = 0;
+			const T *		_first   = nullptr;	// bounds of the current chunk
+			const T *		_current = nullptr;
+			const T *		_last    = nullptr;
+		};
+
+		// constructors
+		Rope() = default;
+		explicit Rope(const Allocator & allocator) : _allocator(allocator) {}
+
+		// copies and moves with a given allocator share or take the other's chunks only when the allocators compare equal,
+		// as only then can each free what the other allocated. Otherwise the elements are copied into chunks of their own
+		Rope(const Rope & other, const Allocator & allocator) : _allocator(allocator) {
+			shareOrCopy(other);
+		}
+
+		Rope(Rope && other, const Allocator & allocator) : _allocator(allocator) {
+			if (_allocator == other._allocator) {
+				_table = std::move(other._table);
+			}
+			else {
+				copyChunks(other);
+				other.clear();
+			}
+		}
+
+		// a copy gets its allocator the way copies of the standard containers do; polymorphic allocators fall back to the
+		// default resource, so such a copy has chunks of its own
+		Rope(const Rope & other) : Rope(other, AllocatorTraits::select_on_container_copy_construction(other._allocator)) {}
+		Rope(Rope &&) = default;
+
+		// assignment shares the other's chunks when the allocators end up equal. As with the standard containers, the
+		// allocator only goes along with them if it propagates; polymorphic allocators don't
+		Rope & operator=(const Rope & other) {
+			if (this != &other) {
+				if constexpr (AllocatorTraits::propagate_on_container_copy_assignment::value) {
+					_allocator = other._allocator;
+				}
+				shareOrCopy(other);
+			}
+			return *this;
+		}
+
+		Rope & operator=(Rope && other) noexcept(AllocatorTraits::propagate_on_container_move_assignment::value || AllocatorTraits::is_always_equal::value) {
+			if constexpr (AllocatorTraits::propagate_on_container_move_assignment::value) {
+				_table = std::move(other._table);
+				_allocator = std::move(other._allocator);
+			}
+			else if (_allocator == other._allocator) {
+				_table = std::move(other._table);
+			}
+			else if (this != &other) {
+				copyChunks(other);
+				other.clear();
+			}
+			return *this;
+		}
+
+		template<class InputIt>
+		Rope(InputIt first, InputIt last, const Allocator & allocator = Allocator()) : Rope(allocator) {
+			assign(first, last);
+		}
+
+		// iterators
+		const_iterator	begin()	 const	{ return const_iterator(&table(), 0, 0); }
+		const_iterator	cbegin() const	{ return begin(); }
+		const_iterator	end()	 const	{ return const_iterator(&table(), table().chunks.size(), 0); }
+		const_iterator	cend()	 const	{ return end(); }
+
+		// capacity
+		size_type		size()	 const	{ return table().starts.back(); }
+		bool			empty()	 const	{ return size() == 0; }
+		allocator_type	get_allocator() const { return _allocator; }
+
+		// approximate bytes held by this rope, with each shared chunk split evenly among the ropes sharing it
+		size_type footprint() const {
+			if (!_table) {
+				return 0;
+			}
+
+			size_type bytes = (_table->chunks.size() * (sizeof(ChunkPointer) + sizeof(size_type)) + sizeof(Table)) / _table.use_count();
+			for (const auto & chunk : _table->chunks) {
+				bytes += (chunk->capacity() * sizeof(T) + sizeof(ChunkType)) / chunk.use_count();
+			}
+			return bytes;
+		}
+
+		// modifiers
+		void clear() {
+			_table.reset();
+		}
+
+		template<class InputIt>
+		void assign(InputIt first, InputIt last) {
+			clear();
+			while (first != last) {
+				emplace_back(*first++);
+			}
+		}
+
+		template<class... Args>
+		void emplace_back(Args &&... args) {
+			Table & table = mutableTable();
+
+			// start a new chunk when the last one is full
+			if (table.chunks.empty() || table.chunks.back()->size() == chunkCapacity()) {
+				table.chunks.push_back(makeChunk());
+				table.starts.push_back(table.starts.back());
+			}
+
+			mutableChunk(table, table.chunks.size() - 1).emplace_back(std::forward<Args>(args)...);
+			++table.starts.back();
+		}
+
+		void push_back(const T & value) { emplace_back(value); }
+		void push_back(T && value)		{ emplace_back(std::move(value)); }
+
+		// insert a range before pos, returning an iterator to the first inserted element
+		template<class InputIt>
+		iterator insert(const_iterator pos, InputIt first, InputIt last) {
+			const size_type position = pos.index();
+			if (first == last) {
+				return makeIterator(position);
+			}
+
+			Table & table = mutableTable();
+
+			// inserting at the end goes into the last chunk, if there is one
+			size_type chunk  = pos._chunk;
+			size_type offset = static_cast<size_type>(pos._current - pos._first);
+			if (chunk == table.chunks.size()) {
+				if (table.chunks.empty()) {
+					table.chunks.push_back(makeChunk());
+					table.starts.push_back(0);
+				}
+				chunk  = table.chunks.size() - 1;
+				offset = table.chunks[chunk]->size();
+			}
+
+			// cut the chunk at the insertion point, then refill it with the new elements followed by the tail, spilling
+			// into new chunks as each one fills up. The chunk list is only touched once, at the end.
+			ChunkType & target = mutableChunk(table, chunk);
+			ChunkType tail(std::make_move_iterator(target.begin() + offset), std::make_move_iterator(target.end()), _allocator);
+			target.erase(target.begin() + offset, target.end());
+
+			ChunkList added(_allocator);
+			ChunkType * current = &target;
+			auto append = [&](auto && value) {
+				if (current->size() == chunkCapacity()) {
+					added.push_back(makeChunk());
+					current = added.back().get();
+				}
+				current->emplace_back(std::forward<decltype(value)>(value));
+			};
+
+			for (; first != last; ++first) {
+				append(*first);
+			}
+			for (auto & value : tail) {
+				append(std::move(value));
+			}
+
+			table.chunks.insert(table.chunks.begin() + chunk + 1, std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()));
+			refreshStarts(table, chunk);
+
+			return makeIterator(position);
+		}
+
+		// erase a range, returning an iterator to the element that followed it
+		iterator erase(const_iterator first, const_iterator last) {
+			const size_type position = first.index();
+			if (first == last) {
+				return makeIterator(position);
+			}
+
+			Table & table = mutableTable();
+
+			const size_type firstChunk = first._chunk;
+			const size_type lastChunk  = last._chunk;
+			const size_type firstOffset = static_cast<size_type>(first._current - first._first);
+			const size_type lastOffset  = static_cast<size_type>(last._current - last._first);
+
+			if (firstChunk == lastChunk) {
+				auto & elements = mutableChunk(table, firstChunk);
+				elements.erase(elements.begin() + firstOffset, elements.begin() + lastOffset);
+			}
+			else {
+				// trim both ends, then drop every chunk in between
+				auto & front = mutableChunk(table, firstChunk);
+				front.erase(front.begin() + firstOffset, front.end());
+				if (lastChunk < table.chunks.size()) {
+					auto & back = mutableChunk(table, lastChunk);
+					back.erase(back.begin(), back.begin() + lastOffset);
+				}
+				table.chunks.erase(table.chunks.begin() + firstChunk + 1, table.chunks.begin() + lastChunk);
+			}
+
+			// remove chunks left empty and fold small neighbors together so the chunk table stays short
+			size_type chunk = firstChunk;
+			for (size_type i = std::min(firstChunk + 1, table.chunks.size()); i-- > firstChunk;) {
+				if (table.chunks[i]->empty()) {
+					table.chunks.erase(table.chunks.begin() + i);
+				}
+			}
+			if (chunk > 0) {
+				--chunk;
+			}
+			for (size_type i = 0; i < 2 && chunk + 1 < table.chunks.size(); ++i) {
+				if (table.chunks[chunk]->size() + table.chunks[chunk + 1]->size() <= chunkCapacity()) {
+					auto & into = mutableChunk(table, chunk);
+					auto & from = *table.chunks[chunk + 1];
+					// the chunk being folded in may be shared, so only move out of it when this rope is its only owner
+					if (table.chunks[chunk + 1].use_count() == 1) {
+						into.insert(into.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+					}
+					else {
+						into.insert(into.end(), from.cbegin(), from.cend());
+					}
+					table.chunks.erase(table.chunks.begin() + chunk + 1);
+				}
+				else {
+					++chunk;
+				}
+			}
+
+			refreshStarts(table, firstChunk > 0 ? firstChunk - 1 : 0);
+
+			return makeIterator(position);
+		}
+
+		iterator erase(const_iterator pos) {
+			return erase(pos, std::next(pos));
+		}
+
+		// replace every match of find with a range of elements, in one pass. find(first, last) returns the first match in
+		// [first, last) and find.size() is the length of a match. onHit is given the position of each match in the original
+		// rope
+		template<class Searcher, class ForwardIt, class HitFunction>
+		size_type replace_all(const Searcher & find, ForwardIt first, ForwardIt last, HitFunction onHit) {
+			// find every match up front, against the unmodified rope
+			std::vector<Replacement<ForwardIt>> replacements;
+			const auto matchSize = static_cast<difference_type>(find.size());
+			for (auto hit = find(cbegin(), cend()); hit != cend(); hit = find(hit + matchSize, cend())) {
+				replacements.push_back(Replacement<ForwardIt>{ hit.index(), find.size(), first, last });
+				onHit(hit.index());
+			}
+
+			replace_ranges(replacements.cbegin(), replacements.cend());
+			return replacements.size();
+		}
+
+		// replace ranges of elements, in one pass. Each replacement has members position and removed, the range of
+		// elements it replaces, and first and last, the range of elements it puts in their place. Replacements are sorted
+		// by position and don't overlap. Chunks without a replacement are carried over as they are, so they stay shared with
+		// any copies; only chunks with a replacement are rebuilt. Cost: O(n/B + B per chunk with a replacement + the
+		// replacements)
+		template<class ReplacementIt>
+		void replace_ranges(ReplacementIt replacement, ReplacementIt replacementEnd) {
+			if (replacement == replacementEnd) {
+				return;
+			}
+
+			const Table & old = table();
+			const bool ownsOld = _table.use_count() == 1;
+			auto rebuilt = std::allocate_shared<Table>(_allocator, _allocator);
+			ChunkList & chunks = rebuilt->chunks;
+
+			// elements are gathered into pending, which is flushed into the new table whenever it fills up or an untouched
+			// chunk is carried over
+			ChunkPointer pending;
+			auto flush = [&]() {
+				if (pending && !pending->empty()) {
+					chunks.push_back(std::move(pending));
+				}
+				pending.reset();
+			};
+			auto append = [&](auto && value) {
+				if (!pending || pending->size() == chunkCapacity()) {
+					flush();
+					pending = makeChunk();
+				}
+				pending->emplace_back(std::forward<decltype(value)>(value));
+			};
+
+			size_type removeUntil = 0;		// elements before this position are being replaced
+			for (size_type chunk = 0; chunk < old.chunks.size(); ++chunk) {
+				const ChunkPointer & source = old.chunks[chunk];
+				const size_type start = old.starts[chunk];
+				const size_type end = old.starts[chunk + 1];
+
+				// a chunk untouched by any replacement is shared, or folded into pending when both are small
+				if ((replacement == replacementEnd || replacement->position >= end) && removeUntil <= start) {
+					if (pending && pending->size() + source->size() <= chunkCapacity()) {
+						pending->insert(pending->end(), source->cbegin(), source->cend());
+					}
+					else {
+						flush();
+						chunks.push_back(source);
+					}
+					continue;
+				}
+
+				// elements of a chunk nobody else holds can be moved out of it
+				const bool movable = ownsOld && source.use_count() == 1;
+				for (size_type i = start; i < end; ++i) {
+					for (; replacement != replacementEnd && replacement->position == i; ++replacement) {
+						std::for_each(replacement->first, replacement->last, append);
+						removeUntil = std::max(removeUntil, i + replacement->removed);
+					}
+					if (i < removeUntil) {
+						continue;
+					}
+
+					auto & value = (*source)[i - start];
+					if (movable) {
+						append(std::move(value));
+					}
+					else {
+						append(static_cast<const T &>(value));
+					}
+				}
+			}
+
+			// anything inserted at the very end
+			for (; replacement != replacementEnd; ++replacement) {
+				std::for_each(replacement->first, replacement->last, append);
+			}
+			flush();
+
+			refreshStarts(*rebuilt, 0);
+			_table = std::move(rebuilt);
+		}
+
+		void swap(Rope & other) noexcept {
+			using std::swap;
+			swap(_table, other._table);
+			if constexpr (AllocatorTraits::propagate_on_container_swap::value) {
+				swap(_allocator, other._allocator);
+			}
+		}
+
+	private:
+		// an empty rope has no table of its own
+		const Table & table() const {
+			static const Table empty{ Allocator() };
+			return _table ? *_table : empty;
+		}
+
+		// the table, cloned first if another rope shares it
+		Table & mutableTable() {
+			if (!_table) {
+				_table = std::allocate_shared<Table>(_allocator, _allocator);
+			}
+			else if (_table.use_count() > 1) {
+				_table = std::allocate_shared<Table>(_allocator, *_table, _allocator);
+			}
+			return *_table;
+		}
+
+		// take the other's chunks if they were allocated with an allocator equal to this one, else copy its elements
+		void shareOrCopy(const Rope & other) {
+			if (_allocator == other._allocator) {
+				_table = other._table;
+			}
+			else {
+				copyChunks(other);
+			}
+		}
+
+		// a table of new chunks, allocated with this rope's allocator, holding the other's elements
+		void copyChunks(const Rope & other) {
+			if (other.empty()) {
+				_table.reset();
+				return;
+			}
+
+			auto copy = std::allocate_shared<Table>(_allocator, _allocator);
+			copy->chunks.reserve(other.table().chunks.size());
+			for (const auto & source : other.table().chunks) {
+				auto chunk = makeChunk();
+				chunk->assign(source->cbegin(), source->cend());
+				copy->chunks.push_back(std::move(chunk));
+			}
+			refreshStarts(*copy, 0);
+			_table = std::move(copy);
+		}
+
+		// a chunk of a table this rope owns, cloned first if another rope shares it
+		ChunkType & mutableChunk(Table & table, size_type chunk) {
+			auto & elements = table.chunks[chunk];
+			if (elements.use_count() > 1) {
+				auto copy = makeChunk();
+				copy->assign(elements->cbegin(), elements->cend());
+				elements = std::move(copy);
+			}
+			return *elements;
+		}
+
+		// one range of elements, and what replace_all puts in its place
+		template<class ForwardIt>
+		struct Replacement {
+			size_type	position;
+			size_type	removed;
+			ForwardIt	first;
+			ForwardIt	last;
+		};
+
+		ChunkPointer makeChunk() const {
+			// moved from an empty chunk rather than given the allocator, which a polymorphic allocator would pass on twice
+			auto chunk = std::allocate_shared<ChunkType>(_allocator, ChunkType(_allocator));
+			chunk->reserve(chunkCapacity());
+			return chunk;
+		}
+
+		iterator makeIterator(size_type position) const {
+			iterator itr(&table(), 0, 0);
+			itr.seek(position);
+			return itr;
+		}
+
+		// recompute the starting position of each chunk from the given chunk onward
+		static void refreshStarts(Table & table, size_type fromChunk) {
+			fromChunk = std::min(fromChunk, table.chunks.size());
+			table.starts.resize(table.chunks.size() + 1);
+			for (size_type i = fromChunk; i < table.chunks.size(); ++i) {
+				table.starts[i + 1] = table.starts[i] + table.chunks[i]->size();
+			}
+		}
+
+		std::shared_ptr<Table>	_table;			// shared with copies until one of them is modified
+		Allocator				_allocator;
+	};
+
+	template<class T, class Allocator>
+	inline void swap(Rope<T, Allocator> & lhs, Rope<T, Allocator> & rhs) noexcept {
+		lhs.swap(rhs);
+	}
+}
+
+#endif
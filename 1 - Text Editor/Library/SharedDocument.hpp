@@ -0,0 +1,135 @@
+/**
+* File:		SharedDocument.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a Document that any number of threads can read while one thread edits it. The writer edits
+*			a private working document and, after each edit, publishes an immutable version of it: the words, the copy
+*			buffer and an up to date word index, without the undo history. Readers pin the current version and search,
+*			copy from and write out that version for as long as they hold it, whatever the writer does meanwhile.
+*
+*			Readers never wait on the writer: pinning a version only copies a shared pointer, and the writer only takes a
+*			lock to keep other writers out. A version is freed by whoever lets go of it last, so an old version lives
+*			exactly as long as some reader still holds it. Publishing copies the document, so like snap() it is cheapest
+*			with a structure-sharing container (Library::Rope), where a version shares everything an edit didn't touch.
+*
+*			Documents of Library::Word may be read and edited from different threads, since the word pool is safe to look
+*			up while another thread interns. The working document's thread pool, if any, is not passed on to versions:
+*			readers are threads of their own. Versions are allocated the way the working document is and freed by whichever
+*			thread lets go of them last, so a document drawing on a memory resource needs one that is safe to use from any
+*			thread (std::pmr::synchronized_pool_resource, not the unsynchronized resources).
+*
+*			Usage:
+*				SharedDocument<Rope> shared(std::move(doc));
+*				shared.edit([](auto & doc) { doc.substitute("old phrase", "new phrase"); });	// the writer
+*				auto version = shared.pin();													// a reader
+*				version->find_all("new phrase");
+*				std::cout << *version;
+*/
+
+#ifndef SHARED_DOCUMENT_HPP
+#define SHARED_DOCUMENT_HPP
+
+// includes
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Library/Document.hpp"
+
+namespace Library {
+	template<template<class, class> class T1 = std::vector, class T2 = std::string, class T3 = std::allocator<T2>>
+	class SharedDocument {
+	public:
+		using DocumentType = Document<T1, T2, T3>;
+		using PhraseType = typename DocumentType::PhraseType;
+		using Version = std::shared_ptr<const DocumentType>;
+
+		SharedDocument() : SharedDocument(DocumentType()) {}
+
+		// share a document, publishing it as the first version
+		explicit SharedDocument(DocumentType document) : _working(std::move(document)) {
+			publish();
+		}
+
+		SharedDocument(const SharedDocument &) = delete;
+		SharedDocument & operator=(const SharedDocument &) = delete;
+
+		// the current version, which stays as it is for as long as it is held. Safe to call from any thread
+		Version pin() const {
+			return std::atomic_load_explicit(&_current, std::memory_order_acquire);
+		}
+
+		// number of versions published so far, the first one included
+		std::uint64_t versions() const {
+			return _versions.load(std::memory_order_acquire);
+		}
+
+		// reads of the current version, for readers that don't need several reads to see the same one
+		std::vector<std::size_t> find_all(const PhraseType & phrase) const {
+			return pin()->find_all(phrase);
+		}
+
+		// the words from the first occurrence of one phrase through the next occurrence of another, as a document of their
+		// own. A reader has no copy buffer to fill, so the copy is handed back instead; it is empty if either isn't found
+		DocumentType copy_range(const PhraseType & startingPhrase, const PhraseType & endingPhrase) const {
+			const Version version = pin();
+			DocumentType copy;
+			version->copyRange(startingPhrase, endingPhrase, copy._document);
+			copy._sources = version->_sources;
+			return copy;
+		}
+
+		// edit the working document and publish the result, returning whatever edit returns. An edit that throws part way
+		// through still publishes what it did, so readers always see the working document. Edits from different threads take
+		// turns
+		template<class Edit>
+		auto edit(Edit edit) -> decltype(edit(std::declval<DocumentType &>())) {
+			using Result = decltype(edit(std::declval<DocumentType &>()));
+			std::lock_guard<std::mutex> lock(_writer);
+			try {
+				if constexpr (std::is_void<Result>::value) {
+					edit(_working);
+					publish();
+				}
+				else {
+					Result result = edit(_working);
+					publish();
+					return result;
+				}
+			}
+			catch (...) {
+				publish();
+				throw;
+			}
+		}
+
+	private:
+		// copy what readers can see of the working document into a new version, allocated the way the working document is,
+		// and make it the current one. The index is built and settled first, so reading it never changes it
+		void publish() {
+			auto version = std::make_shared<DocumentType>(_working._document.get_allocator());
+			version->_document = _working._document;
+			version->_copy_buffer = _working._copy_buffer;
+			version->_sources = _working._sources;
+			if (_working.index()) {
+				version->_index = _working._index;
+				version->_index->settle();
+			}
+
+			std::atomic_store_explicit(&_current, Version(std::move(version)), std::memory_order_release);
+			_versions.fetch_add(1, std::memory_order_release);
+		}
+
+		DocumentType				_working;			// the writer's document, with its history
+		Version						_current;			// the version readers pin
+		std::atomic<std::uint64_t>	_versions{ 0 };
+		std::mutex					_writer;			// keeps writers from editing at the same time
+	};
+}
+
+#endif
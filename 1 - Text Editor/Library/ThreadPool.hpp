@@ -0,0 +1,147 @@
+/**
+* File:		ThreadPool.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a fixed set of worker threads used by Document to split a search or a rewrite of a large
+*			document into pieces. The threads are started once and then wait for work, so handing out a job costs a
+*			wake-up rather than a thread start. The thread that hands out a job works on it too.
+*
+*			Usage:
+*				ThreadPool pool(4);
+*				pool.parallel_for(pieces, [&](std::size_t piece) { ... });
+*/
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+// includes
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Library {
+	class ThreadPool {
+	public:
+		// threads counts the calling thread, so one less worker is started. 0 means one per hardware thread
+		explicit ThreadPool(std::size_t threads = 0) {
+			if (threads == 0) {
+				threads = std::max(1U, std::thread::hardware_concurrency());
+			}
+			for (std::size_t i = 1; i < threads; ++i) {
+				_workers.emplace_back([this] { work(); });
+			}
+		}
+
+		~ThreadPool() noexcept {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stop = true;
+			}
+			_wake.notify_all();
+			for (auto & worker : _workers) {
+				worker.join();
+			}
+		}
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool & operator=(const ThreadPool &) = delete;
+
+		// number of threads that work on a job, including the caller
+		std::size_t size() const { return _workers.size() + 1; }
+
+		// call fn(i) for every i in [0, count), spread over the threads, and return once every call has. The first
+		// exception thrown by any call is rethrown here
+		template<class Function>
+		void parallel_for(std::size_t count, Function fn) {
+			// one job at a time, however many threads hand them out
+			std::lock_guard<std::mutex> submit(_submit);
+
+			const std::function<void(std::size_t)> job(std::ref(fn));
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_job = &job;
+				_count = count;
+				_next = 0;
+				_error = nullptr;
+				++_generation;
+			}
+			_wake.notify_all();
+
+			runJob(job, count);
+
+			// wait for the workers still running a piece, then make sure none picks the job up late
+			std::unique_lock<std::mutex> lock(_mutex);
+			_done.wait(lock, [this] { return _active == 0; });
+			_job = nullptr;
+
+			if (_error) {
+				std::rethrow_exception(_error);
+			}
+		}
+
+	private:
+		void work() {
+			std::uint64_t seen = 0;
+			while (true) {
+				const std::function<void(std::size_t)> * job;
+				std::size_t count;
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+					_wake.wait(lock, [&] { return _stop || (_generation != seen && _job != nullptr); });
+					if (_stop) {
+						return;
+					}
+					seen = _generation;
+					job = _job;
+					count = _count;
+					++_active;
+				}
+
+				runJob(*job, count);
+
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					--_active;
+				}
+				_done.notify_one();
+			}
+		}
+
+		// take pieces until there are none left
+		void runJob(const std::function<void(std::size_t)> & job, std::size_t count) {
+			for (std::size_t i = _next++; i < count; i = _next++) {
+				try {
+					job(i);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(_mutex);
+					if (!_error) {
+						_error = std::current_exception();
+					}
+				}
+			}
+		}
+
+		std::vector<std::thread>						_workers;
+		std::mutex										_submit;		// serializes jobs
+		std::mutex										_mutex;			// guards everything below but _next
+		std::condition_variable							_wake;			// a job was handed out, or the pool is stopping
+		std::condition_variable							_done;			// a worker finished its part of a job
+		const std::function<void(std::size_t)> *		_job = nullptr;
+		std::size_t										_count = 0;
+		std::atomic<std::size_t>						_next{ 0 };		// next piece of the job to take
+		std::size_t										_active = 0;	// workers running the job
+		std::uint64_t									_generation = 0;
+		std::exception_ptr								_error;
+		bool											_stop = false;
+	};
+}
+
+#endif
@@ -0,0 +1,86 @@
+/**
+* File:		Token.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a word type that refers to text it does not own. Words loaded by Document::load(path)
+*			are views into the memory mapped file, so loading allocates nothing per word. Words that come from
+*			anywhere else (phrases, streams) own a copy of their text, which means the words an edit introduces are
+*			the only ones ever copied.
+*
+*			Usage:
+*				Document<std::vector, Library::Token> doc;
+*				doc.load(std::filesystem::path("input.txt"));
+*/
+
+#ifndef TOKEN_HPP
+#define TOKEN_HPP
+
+// includes
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Library/MappedFile.hpp"
+
+namespace Library {
+	class Token {
+	public:
+		Token() = default;
+
+		// borrow text owned by someone else, which must outlive the token
+		explicit Token(std::string_view borrowed) : _view(borrowed) {}
+
+		// own a copy of the text, allowing phrases and streams of std::string to be converted implicitly
+		Token(const std::string & text) : _owned(std::make_shared<const std::string>(text)), _view(*_owned) {}
+
+		std::string_view	view()	const { return _view; }
+		std::string			str()	const { return std::string(_view); }
+		std::size_t			size()	const { return _view.size(); }
+		bool				empty()	const { return _view.empty(); }
+
+		// true if the token owns its text rather than borrowing it
+		bool owned() const { return _owned != nullptr; }
+
+		// comparisons look at the text, wherever it is stored
+		friend bool operator== (const Token & lhs, const Token & rhs) { return lhs._view == rhs._view; }
+		friend bool operator!= (const Token & lhs, const Token & rhs) { return lhs._view != rhs._view; }
+		friend bool operator<  (const Token & lhs, const Token & rhs) { return lhs._view <  rhs._view; }
+
+		// stream operators
+		friend std::ostream & operator<< (std::ostream & s, const Token & token) {
+			return s << token._view;
+		}
+
+		friend std::istream & operator>> (std::istream & s, Token & token) {
+			std::string text;
+			if (s >> text) {
+				token = Token(text);
+			}
+			return s;
+		}
+
+	private:
+		// owned text is shared between copies, it is never modified
+		std::shared_ptr<const std::string>	_owned;
+		std::string_view					_view;
+	};
+
+	// tokens keep pointing into the file they were loaded from
+	template<>
+	struct ViewsMapping<Token> : std::true_type {};
+}
+
+namespace std {
+	// hash on the text so Token can be used as a key in unordered containers
+	template<>
+	struct hash<Library::Token> {
+		std::size_t operator()(const Library::Token & token) const {
+			return std::hash<std::string_view>()(token.view());
+		}
+	};
+}
+
+#endif
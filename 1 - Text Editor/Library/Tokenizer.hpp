@@ -0,0 +1,335 @@
+/**
+* File:		Tokenizer.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the whitespace tokenizer used by Document::load. It splits text exactly where operator>>
+*			into a std::string does in the "C" locale (on ' ', '\t', '\n', '\v', '\f' and '\r', nothing else), but
+*			classifies 64 bytes at a time with SSE2 or AVX2 compares where the processor has them, turns each block into a
+*			bit mask, and walks only the word boundaries in the mask. Words are gathered into a batch of spans before
+*			being handed out, instead of being appended a character at a time behind a sentry and a locale lookup.
+*
+*			The fastest kernel the processor supports is picked the first time one is needed; use() can pick a slower
+*			one, to compare them or to check they agree.
+*
+*			Usage:
+*				Tokenizer::split(text, [&](std::string_view word) { words.emplace_back(word); });
+*				Tokenizer::split(std::cin, [&](std::string_view word) { words.emplace_back(word); });
+*/
+
+#ifndef TOKENIZER_HPP
+#define TOKENIZER_HPP
+
+// includes
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define TOKENIZER_SSE2
+		#include <emmintrin.h>
+	#endif
+	// AVX2 code is compiled for its own functions only, and only called once the processor is known to have it
+	#if defined(__GNUC__) || defined(__clang__)
+		#define TOKENIZER_AVX2
+		#define TOKENIZER_AVX2_TARGET __attribute__((target("avx2")))
+		#include <immintrin.h>
+	#elif defined(_MSC_VER)
+		#define TOKENIZER_AVX2
+		#define TOKENIZER_AVX2_TARGET
+		#include <immintrin.h>
+		#include <intrin.h>
+	#endif
+#endif
+
+namespace Library {
+	namespace Tokenizing {
+		constexpr std::size_t BlockSize = 64;			// bytes classified into one mask
+		constexpr std::size_t BlocksPerChunk = 64;		// blocks classified before their boundaries are walked
+		constexpr std::size_t BatchSize = 256;			// words gathered before they are handed out
+
+		// whitespace as the "C" locale has it
+		inline bool isSpace(char c) {
+			return c == ' ' || (c >= '\t' && c <= '\r');
+		}
+
+		// index of the lowest set bit, which must exist
+		inline unsigned lowestBit(std::uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<unsigned>(__builtin_ctzll(bits));
+#elif defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanForward64(&index, bits);
+			return static_cast<unsigned>(index);
+#else
+			unsigned index = 0;
+			for (; (bits & 1) == 0; bits >>= 1) {
+				++index;
+			}
+			return index;
+#endif
+		}
+
+		// each classifier sets bit i of masks[b] when byte i of block b is whitespace
+		using Classifier = void (*)(const char * data, std::size_t blocks, std::uint64_t * masks);
+
+		inline void classifyScalar(const char * data, std::size_t blocks, std::uint64_t * masks) {
+			for (std::size_t block = 0; block < blocks; ++block, data += BlockSize) {
+				std::uint64_t mask = 0;
+				for (std::size_t i = 0; i < BlockSize; ++i) {
+					mask |= std::uint64_t(isSpace(data[i])) << i;
+				}
+				masks[block] = mask;
+			}
+		}
+
+#ifdef TOKENIZER_SSE2
+		inline void classifySse2(const char * data, std::size_t blocks, std::uint64_t * masks) {
+			// bytes are compared as signed, so those above 0x7f are below '\t' and never whitespace
+			const __m128i space = _mm_set1_epi8(' ');
+			const __m128i belowTab = _mm_set1_epi8('\t' - 1);
+			const __m128i aboveReturn = _mm_set1_epi8('\r' + 1);
+			for (std::size_t block = 0; block < blocks; ++block, data += BlockSize) {
+				std::uint64_t mask = 0;
+				for (std::size_t i = 0; i < BlockSize; i += 16) {
+					const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+					const __m128i control = _mm_and_si128(_mm_cmpgt_epi8(bytes, belowTab), _mm_cmplt_epi8(bytes, aboveReturn));
+					const __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(bytes, space), control);
+					mask |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(spaces))) << i;
+				}
+				masks[block] = mask;
+			}
+		}
+#endif
+
+#ifdef TOKENIZER_AVX2
+		TOKENIZER_AVX2_TARGET inline void classifyAvx2(const char * data, std::size_t blocks, std::uint64_t * masks) {
+			const __m256i space = _mm256_set1_epi8(' ');
+			const __m256i belowTab = _mm256_set1_epi8('\t' - 1);
+			const __m256i aboveReturn = _mm256_set1_epi8('\r' + 1);
+			for (std::size_t block = 0; block < blocks; ++block, data += BlockSize) {
+				std::uint64_t mask = 0;
+				for (std::size_t i = 0; i < BlockSize; i += 32) {
+					const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+					const __m256i control = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, belowTab), _mm256_cmpgt_epi8(aboveReturn, bytes));
+					const __m256i spaces = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, space), control);
+					mask |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(spaces))) << i;
+				}
+				masks[block] = mask;
+			}
+		}
+
+		inline bool hasAvx2() {
+	#if defined(__GNUC__) || defined(__clang__)
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+	#else
+			// the processor must have AVX2, and the operating system must save the AVX registers
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) {
+				return false;
+			}
+			__cpuid(info, 1);
+			if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) {
+				return false;
+			}
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+	#endif
+		}
+#endif
+	}
+
+	class Tokenizer {
+	public:
+		enum class Kernel { Scalar, Sse2, Avx2 };
+
+		// the fastest kernel this processor supports
+		static Kernel best() {
+			static const Kernel fastest = detect();
+			return fastest;
+		}
+
+		static bool supported(Kernel kernel) {
+			return kernel <= best();
+		}
+
+		// the kernel in use, and choosing another. A kernel the processor doesn't support falls back to the fastest one it
+		// does; the kernel actually used is returned
+		static Kernel kernel() {
+			return static_cast<Kernel>(selected().load(std::memory_order_relaxed));
+		}
+
+		static Kernel use(Kernel kernel) {
+			const Kernel chosen = supported(kernel) ? kernel : best();
+			selected().store(static_cast<int>(chosen), std::memory_order_relaxed);
+			return chosen;
+		}
+
+		static const char * name(Kernel kernel) {
+			switch (kernel) {
+				case Kernel::Avx2:	return "avx2";
+				case Kernel::Sse2:	return "sse2";
+				default:			return "scalar";
+			}
+		}
+
+		// call fn with each whitespace delimited word of text, in order
+		template<class Function>
+		static void split(std::string_view text, Function fn) {
+			Splitter<Function>(text.data(), fn).split(text.size());
+		}
+
+		// call fn with each whitespace delimited word read from a stream, which is read to its end a buffer at a time. As
+		// with operator>>, the stream is left with eofbit and failbit set. The text fn is given is only valid during the call
+		template<class Function>
+		static void split(std::istream & stream, Function fn) {
+			constexpr std::size_t ReadSize = std::size_t(1) << 20;
+			std::string buffer(ReadSize, '\0');
+			std::size_t kept = 0;		// bytes of an unfinished word carried over from the last read
+
+			while (true) {
+				// a word longer than the buffer grows it
+				if (buffer.size() - kept < ReadSize / 2) {
+					buffer.resize(buffer.size() * 2);
+				}
+				stream.read(&buffer[kept], static_cast<std::streamsize>(buffer.size() - kept));
+				const std::size_t size = kept + static_cast<std::size_t>(stream.gcount());
+				if (!stream) {
+					Splitter<Function>(buffer.data(), fn).split(size);
+					break;
+				}
+
+				// the word still going at the end of the buffer may continue in the next read, so split up to the whitespace
+				// before it and carry it over
+				std::size_t cut = size;
+				while (cut > 0 && !Tokenizing::isSpace(buffer[cut - 1])) {
+					--cut;
+				}
+				Splitter<Function>(buffer.data(), fn).split(cut);
+				kept = size - cut;
+				std::memmove(&buffer[0], buffer.data() + cut, kept);
+			}
+			stream.setstate(std::ios::eofbit | std::ios::failbit);
+		}
+
+	private:
+		static Kernel detect() {
+#ifdef TOKENIZER_AVX2
+			if (Tokenizing::hasAvx2()) {
+				return Kernel::Avx2;
+			}
+#endif
+#ifdef TOKENIZER_SSE2
+			return Kernel::Sse2;
+#else
+			return Kernel::Scalar;
+#endif
+		}
+
+		static std::atomic<int> & selected() {
+			static std::atomic<int> kernel{ static_cast<int>(best()) };
+			return kernel;
+		}
+
+		static Tokenizing::Classifier classifier(Kernel kernel) {
+			switch (kernel) {
+#ifdef TOKENIZER_AVX2
+				case Kernel::Avx2:	return Tokenizing::classifyAvx2;
+#endif
+#ifdef TOKENIZER_SSE2
+				case Kernel::Sse2:	return Tokenizing::classifySse2;
+#endif
+				default:			return Tokenizing::classifyScalar;
+			}
+		}
+
+		// walks the word boundaries of text from the masks of its blocks, gathering the words into batches
+		template<class Function>
+		class Splitter {
+		public:
+			Splitter(const char * text, Function & fn) : _text(text), _fn(fn), _classify(classifier(kernel())) {}
+
+			// split the first size bytes. Whole blocks are classified by the kernel, the partial one at the end is padded out
+			// with whitespace, which ends a word running into it
+			void split(std::size_t size) {
+				std::uint64_t masks[Tokenizing::BlocksPerChunk];
+				const std::size_t wholeBlocks = size / Tokenizing::BlockSize;
+				for (std::size_t block = 0; block < wholeBlocks; ) {
+					const std::size_t count = std::min(wholeBlocks - block, Tokenizing::BlocksPerChunk);
+					_classify(_text + block * Tokenizing::BlockSize, count, masks);
+					for (std::size_t i = 0; i < count; ++i) {
+						walk(masks[i], (block + i) * Tokenizing::BlockSize);
+					}
+					block += count;
+				}
+
+				const std::size_t tail = size - wholeBlocks * Tokenizing::BlockSize;
+				if (tail > 0) {
+					char padded[Tokenizing::BlockSize];
+					std::memcpy(padded, _text + wholeBlocks * Tokenizing::BlockSize, tail);
+					std::memset(padded + tail, ' ', Tokenizing::BlockSize - tail);
+					Tokenizing::classifyScalar(padded, 1, masks);
+					walk(masks[0], wholeBlocks * Tokenizing::BlockSize);
+				}
+
+				// a word running to the end of the last whole block ends with the text
+				if (_inWord) {
+					emit(_start, size);
+				}
+				flush();
+			}
+
+		private:
+			// every word starting or ending in a block, given whether each of its bytes is whitespace
+			void walk(std::uint64_t spaces, std::size_t base) {
+				const std::uint64_t words = ~spaces;
+				const std::uint64_t previous = (words << 1) | std::uint64_t(_inWord);
+				_inWord = (words >> (Tokenizing::BlockSize - 1)) != 0;
+
+				std::uint64_t boundaries = words ^ previous;		// a word starts or ends at each set bit
+				const std::uint64_t starts = words & ~previous;
+				while (boundaries != 0) {
+					const unsigned bit = Tokenizing::lowestBit(boundaries);
+					if ((starts >> bit) & 1) {
+						_start = base + bit;
+					}
+					else {
+						emit(_start, base + bit);
+					}
+					boundaries &= boundaries - 1;
+				}
+			}
+
+			void emit(std::size_t first, std::size_t last) {
+				if (_count == Tokenizing::BatchSize) {
+					flush();
+				}
+				_batch[_count++] = std::string_view(_text + first, last - first);
+			}
+
+			void flush() {
+				for (std::size_t i = 0; i < _count; ++i) {
+					_fn(_batch[i]);
+				}
+				_count = 0;
+			}
+
+			const char *				_text;
+			Function &					_fn;
+			Tokenizing::Classifier		_classify;
+			std::string_view			_batch[Tokenizing::BatchSize];
+			std::size_t					_count = 0;
+			std::size_t					_start = 0;				// where the word being walked started
+			bool						_inWord = false;		// the last byte walked was part of a word
+		};
+	};
+}
+
+#endif
@@ -0,0 +1,181 @@
+/**
+* File:		Word.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains an interned word type that can be used as the value type of a Document.
+*			Each distinct word is stored exactly once in a shared pool and a Word holds only its 32-bit ID,
+*			so a document becomes a flat sequence of integers. Comparisons are integer comparisons, and copying
+*			a document (for example in snap()) copies 4 bytes per word.
+*
+*			Usage:
+*				Document<std::vector, Library::Word>
+*/
+
+#ifndef WORD_HPP
+#define WORD_HPP
+
+// includes
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace Library {
+	// the dictionary shared by every Word in the process. IDs are dense and handed out in order of first appearance;
+	// ID 0 is reserved for the empty word so a default constructed Word is well defined
+	class WordPool {
+	public:
+		using IdType = std::uint32_t;
+
+		// the one pool all words are interned in
+		static WordPool & instance() {
+			static WordPool pool;
+			return pool;
+		}
+
+		// return the ID of a word, adding it to the pool the first time it is seen
+		IdType intern(std::string_view word) {
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			auto found = _ids.find(word);
+			if (found != _ids.end()) {
+				return found->second;
+			}
+
+			// stored words never move, so the map can key on views of the stored text
+			const IdType id = static_cast<IdType>(_size);
+			const Slot slot = slotOf(id);
+			if (!_segments[slot.segment]) {
+				_segments[slot.segment].reset(new std::string[segmentSize(slot.segment)]);
+			}
+			std::string & stored = _segments[slot.segment][slot.offset];
+			stored.assign(word.data(), word.size());
+			_ids.emplace(stored, id);
+			++_size;
+
+			return id;
+		}
+
+		// the text of an interned word. Words are stored in segments that are allocated once and never move, so this needs no
+		// lock, even while another thread is interning: whoever handed over the ID saw the word stored before it did
+		const std::string & lookup(IdType id) const {
+			const Slot slot = slotOf(id);
+			return _segments[slot.segment][slot.offset];
+		}
+
+		// number of distinct words in the pool, including the empty word
+		std::size_t size() const {
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _size;
+		}
+
+		WordPool(const WordPool &) = delete;
+		WordPool & operator=(const WordPool &) = delete;
+
+	private:
+		// segment s holds FirstSegment << s words, so every ID fits in Segments of them
+		static constexpr unsigned FirstBits = 10;
+		static constexpr std::size_t FirstSegment = std::size_t(1) << FirstBits;
+		static constexpr unsigned Segments = 33 - FirstBits;
+
+		struct Slot {
+			unsigned	segment;
+			std::size_t	offset;
+		};
+
+		static std::size_t segmentSize(unsigned segment) {
+			return FirstSegment << segment;
+		}
+
+		// index of the highest set bit, which must exist
+		static unsigned highestBit(std::uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+			return 63U - static_cast<unsigned>(__builtin_clzll(bits));
+#elif defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanReverse64(&index, bits);
+			return static_cast<unsigned>(index);
+#else
+			unsigned index = 0;
+			while ((bits >>= 1) != 0) {
+				++index;
+			}
+			return index;
+#endif
+		}
+
+		static Slot slotOf(IdType id) {
+			const std::uint64_t shifted = std::uint64_t(id) + FirstSegment;
+			const unsigned segment = highestBit(shifted) - FirstBits;
+			return Slot{ segment, static_cast<std::size_t>(shifted - segmentSize(segment)) };
+		}
+
+		WordPool() {
+			intern(std::string_view());
+		}
+
+		std::unique_ptr<std::string[]>				_segments[Segments];	// ID to word text
+		std::size_t									_size = 0;				// words stored
+		std::unordered_map<std::string_view, IdType>	_ids;				// word text, viewing _segments, to ID
+		mutable std::mutex							_mutex;				// guards interning
+	};
+
+	// a word stored as its ID in the shared pool
+	class Word {
+	public:
+		using IdType = WordPool::IdType;
+
+		Word() = default;
+
+		// intern the text, allowing phrases and streams of std::string to be converted implicitly
+		Word(const std::string & text) : _id(WordPool::instance().intern(text)) {}
+		Word(const char * text) : _id(WordPool::instance().intern(text)) {}
+		explicit Word(std::string_view text) : _id(WordPool::instance().intern(text)) {}
+
+		IdType				id()	const { return _id; }
+		const std::string &	str()	const { return WordPool::instance().lookup(_id); }
+		bool				empty()	const { return _id == 0; }
+
+		// comparisons only look at the ID; ordering is by ID, not alphabetical
+		friend bool operator== (const Word & lhs, const Word & rhs) { return lhs._id == rhs._id; }
+		friend bool operator!= (const Word & lhs, const Word & rhs) { return lhs._id != rhs._id; }
+		friend bool operator<  (const Word & lhs, const Word & rhs) { return lhs._id <  rhs._id; }
+
+		// stream operators, reading and writing the text of the word
+		friend std::ostream & operator<< (std::ostream & s, const Word & word) {
+			return s << word.str();
+		}
+
+		friend std::istream & operator>> (std::istream & s, Word & word) {
+			std::string text;
+			if (s >> text) {
+				word = Word(text);
+			}
+			return s;
+		}
+
+	private:
+		IdType _id = 0;
+	};
+}
+
+namespace std {
+	// hash on the ID so Word can be used as a key in unordered containers
+	template<>
+	struct hash<Library::Word> {
+		std::size_t operator()(const Library::Word & word) const {
+			return std::hash<Library::Word::IdType>()(word.id());
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,191 @@
+/**
+* File:		WordIndex.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains an inverted index from each word of a Document to the positions it occurs at. It lets
+*			Document jump straight to the places a phrase could start, and give up without looking at the document at
+*			all when one of the words of a phrase doesn't occur in it.
+*
+*			Edits are recorded in a log instead of being applied to every word right away. An edit moves the position of
+*			every word after it, so applying it eagerly would cost O(n) like rebuilding would; instead each word brings
+*			its own positions up to date the next time they are asked for, by applying the edits logged since then. The
+*			log is folded into every word and emptied once it has grown as long as the document.
+*
+*			Usage:
+*				doc.use_index();
+*/
+
+#ifndef WORD_INDEX_HPP
+#define WORD_INDEX_HPP
+
+// includes
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace Library {
+	template<class T, class Hash = std::hash<T>>
+	class WordIndex {
+	public:
+		using Positions = std::vector<std::size_t>;
+
+		// index a sequence of words from scratch
+		template<class InputIt>
+		void build(InputIt first, InputIt last) {
+			clear();
+			for (; first != last; ++first) {
+				_entries[*first].positions.push_back(_size++);
+			}
+		}
+
+		void clear() {
+			_entries.clear();
+			_log.clear();
+			_firstEdit = 0;
+			_logged = 0;
+			_size = 0;
+		}
+
+		// number of words indexed
+		std::size_t size() const { return _size; }
+
+		// every position a word occurs at, in order
+		const Positions & positions(const T & word) const {
+			static const Positions none;
+
+			auto found = _entries.find(word);
+			if (found == _entries.end()) {
+				return none;
+			}
+			catchUp(found->second);
+			return found->second.positions;
+		}
+
+		// positions where the phrase in [first, last) could start, in order. Every one of them has the rarest word of the
+		// phrase in the right place; the rest of the phrase still has to be compared. Empty if any word never occurs
+		template<class ForwardIt>
+		Positions candidates(ForwardIt first, ForwardIt last) const {
+			const Positions * rarest = nullptr;
+			std::size_t offset = 0;
+			std::size_t length = 0;
+			for (; first != last; ++first, ++length) {
+				const Positions & found = positions(*first);
+				if (found.empty()) {
+					return Positions();
+				}
+				if (rarest == nullptr || found.size() < rarest->size()) {
+					rarest = &found;
+					offset = length;
+				}
+			}
+
+			Positions result;
+			if (rarest != nullptr) {
+				for (auto position : *rarest) {
+					if (position >= offset && position - offset + length <= _size) {
+						result.push_back(position - offset);
+					}
+				}
+			}
+			return result;
+		}
+
+		// record that removed words at each of the (sorted, non-overlapping) hits were replaced with [first, last)
+		template<class ForwardIt>
+		void replaced(const Positions & hits, std::size_t removed, ForwardIt first, ForwardIt last) {
+			if (hits.empty()) {
+				return;
+			}
+
+			const auto added = static_cast<std::size_t>(std::distance(first, last));
+			_log.push_back(Edit{ hits, removed, added });
+			_logged += hits.size();
+			_size = _size - hits.size() * removed + hits.size() * added;
+
+			// the replacement words are the only ones gaining positions, so they are brought up to date now
+			std::size_t offset = 0;
+			for (; first != last; ++first, ++offset) {
+				Entry & entry = _entries.try_emplace(*first, Entry{ Positions(), currentEdit() }).first->second;
+				catchUp(entry);
+
+				auto & positions = entry.positions;
+				const auto middle = positions.size();
+				for (std::size_t i = 0; i < hits.size(); ++i) {
+					positions.push_back(hits[i] - i * removed + i * added + offset);
+				}
+				std::inplace_merge(positions.begin(), positions.begin() + middle, positions.end());
+			}
+
+			compact();
+		}
+
+		// bring every word up to date now, so that looking positions up no longer changes the index and any number of
+		// threads can do it at once
+		void settle() {
+			for (auto & entry : _entries) {
+				catchUp(entry.second);
+			}
+			_firstEdit = currentEdit();
+			_log.clear();
+			_logged = 0;
+		}
+
+		// record that [first, last) was inserted before position
+		template<class ForwardIt>
+		void inserted(std::size_t position, ForwardIt first, ForwardIt last) {
+			replaced(Positions(1, position), 0, first, last);
+		}
+
+	private:
+		// one logged edit: removed words at each hit became added words
+		struct Edit {
+			Positions	hits;
+			std::size_t	removed;
+			std::size_t	added;
+		};
+
+		struct Entry {
+			Positions	positions;
+			std::size_t	applied = 0;		// number of edits, counted since the index was built, reflected in positions
+		};
+
+		std::size_t currentEdit() const { return _firstEdit + _log.size(); }
+
+		// apply the edits a word hasn't seen yet to its positions
+		void catchUp(Entry & entry) const {
+			for (; entry.applied < currentEdit(); ++entry.applied) {
+				const Edit & edit = _log[entry.applied - _firstEdit];
+
+				// positions only ever get dropped, so they can be rewritten in place
+				auto write = entry.positions.begin();
+				for (auto position : entry.positions) {
+					// the hits starting at or before this position
+					const auto before = static_cast<std::size_t>(std::upper_bound(edit.hits.cbegin(), edit.hits.cend(), position) - edit.hits.cbegin());
+					if (before > 0 && position < edit.hits[before - 1] + edit.removed) {
+						continue;		// the word was replaced
+					}
+					*write++ = position - before * edit.removed + before * edit.added;
+				}
+				entry.positions.erase(write, entry.positions.end());
+			}
+		}
+
+		// once the log is as long as the document, bring every word up to date and start a new log
+		void compact() {
+			if (_logged > _size) {
+				settle();
+			}
+		}
+
+		mutable std::unordered_map<T, Entry, Hash>	_entries;		// positions are brought up to date when looked at
+		std::vector<Edit>							_log;			// edits not yet applied to every word
+		std::size_t									_firstEdit = 0;	// number of the first edit in the log
+		std::size_t									_logged = 0;	// hits in the log
+		std::size_t									_size = 0;
+	};
+}
+
+#endif
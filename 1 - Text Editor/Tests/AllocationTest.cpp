@@ -0,0 +1,140 @@
+/**
+* File:		AllocationTest.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Checks that erase and substitute allocate nothing beyond their result once they're warmed up. Every operator new
+*			in the program is counted. Each operation is run twice, on fresh copies of the same document: the first run may
+*			set up whatever lives for the whole program, and the second must make no allocation at all when the document
+*			doesn't grow. A substitute that lengthens the document may only allocate what growing its container by as many
+*			words does. Fails, with a line for each operation that allocated too much, if any did.
+*
+*			The vector and deque backends are checked. Rope is left out: every edit of a Rope builds new chunks, so a
+*			copy made before the edit keeps sharing the old ones, and those chunks are its result.
+*
+*			Built and run with the other checks:
+*				make test
+*/
+
+#include "Library/Document.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// every allocation in the program goes through these, so an operation's allocations can be counted
+namespace {
+	std::atomic<std::size_t> allocationCount{ 0 };
+
+	void * countedAllocate(std::size_t size) {
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		if (void * memory = std::malloc(size == 0 ? 1 : size)) {
+			return memory;
+		}
+		throw std::bad_alloc();
+	}
+}
+
+void * operator new  (std::size_t size) { return countedAllocate(size); }
+void * operator new[](std::size_t size) { return countedAllocate(size); }
+void operator delete  (void * memory) noexcept { std::free(memory); }
+void operator delete[](void * memory) noexcept { std::free(memory); }
+void operator delete  (void * memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void * memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+	// an operation and the most it may allocate once warmed up
+	template<class D>
+	struct Operation {
+		const char *				name;
+		std::size_t					allowed;
+		std::function<void(D &)>	run;
+	};
+
+	// words long enough that copying one would allocate, with the phrases below scattered through them
+	std::string makeText() {
+		std::ostringstream text;
+		for (int i = 0; i < 20000; ++i) {
+			text << "paragraph" << i % 97 << "-words-that-do-not-fit-in-a-small-string ";
+			if (i % 50 == 0) {
+				text << "a string ";
+			}
+			if (i % 70 == 0) {
+				text << "old word ";
+			}
+		}
+		return text.str();
+	}
+
+	// what growing a copy of the document's container by some words allocates: the result a lengthening substitute has
+	// to build, whatever else it does
+	template<class D>
+	std::size_t growth(std::size_t size, std::size_t added) {
+		std::size_t allocations = 0;
+		for (int pass = 0; pass < 2; ++pass) {
+			typename D::ContainerType words(size);
+			const std::size_t start = allocationCount.load();
+			words.resize(size + added);
+			allocations = allocationCount.load() - start;
+		}
+		return allocations;
+	}
+
+	// run each operation twice on fresh copies, counting the second run. Returns the number that allocated too much
+	template<class D>
+	int check(const char * backend, const std::string & text) {
+		// phrases are made before counting, so their own strings aren't counted
+		const std::string erased = "a string", missing = "there's no way this phrase is in there";
+		const std::string before = "old word", same = "new word", longer = "a much longer new word";
+
+		std::istringstream stream(text);
+		D original(stream);
+		const std::size_t replaced = original.find_all(before).size();
+		std::size_t words = 0;
+		std::istringstream count(text);
+		for (std::string word; count >> word; ) {
+			++words;
+		}
+
+		const std::vector<Operation<D>> operations = {
+			{ "erase",				0, [&](D & doc) { doc.erase(erased); } },
+			{ "erase_missing",		0, [&](D & doc) { doc.erase(missing); } },
+			{ "substitute",			0, [&](D & doc) { doc.substitute(before, same); } },
+			{ "substitute_longer",	growth<D>(words, replaced * 3), [&](D & doc) { doc.substitute(before, longer); } },
+		};
+
+		int failures = 0;
+		for (const auto & operation : operations) {
+			std::size_t allocations = 0;
+			for (int pass = 0; pass < 2; ++pass) {
+				D doc(original);
+				const std::size_t start = allocationCount.load();
+				operation.run(doc);
+				allocations = allocationCount.load() - start;
+			}
+
+			if (allocations > operation.allowed) {
+				std::cerr << backend << ' ' << operation.name << ": " << allocations << " allocations, expected at most "
+					<< operation.allowed << '\n';
+				++failures;
+			}
+		}
+		return failures;
+	}
+}
+
+int main() {
+	const std::string text = makeText();
+
+	int failures = 0;
+	failures += check<Library::Document<std::vector, std::string>>("vector", text);
+	failures += check<Library::Document<std::deque, std::string>>("deque", text);
+
+	std::cout << (failures == 0 ? "AllocationTest passed\n" : "AllocationTest failed\n");
+	return failures == 0 ? 0 : 1;
+}
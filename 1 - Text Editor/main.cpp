@@ -8,8 +8,13 @@
 */
 
 #include "Library/Document.hpp"
+#include "Library/PagedDocument.hpp"
+#include "Library/Rope.hpp"
 #include "Library/Timer.hpp"
+#include "Library/Token.hpp"
+#include "Library/Word.hpp"
 
+#include <fstream>
 #include <typeinfo>
 #include <forward_list>
 #include <deque>
@@ -54,10 +59,70 @@ namespace {
 
 		std::cout << '\n';
 	}
+
+	// template function that applies the edits of the session above, but as one batch
+	template<class T>
+	void testBatch(T && doc, std::istream & is) {
+		std::cout << "Batch editing Document with " << typeid(T).name() << "\n------------------------------------------------\n";
+
+		is.clear();
+		is.seekg(0);
+		doc.load(is);
+
+		Library::EditBatch batch;
+		batch.substitute("effective length", "ineffective measurement")
+			.erase("a string")
+			.erase("there's no way this phrase is in there");
+
+		std::vector<std::size_t> hits;
+		Library::Timer("Elapsed Time of ::apply() \t= "), hits = doc.apply(batch);
+
+		std::cout << "Occurrences replaced by each edit:";
+		for (auto count : hits) {
+			std::cout << ' ' << count;
+		}
+		std::cout << "\n\n";
+	}
+
+	// template function comparing loading a file through a stream with loading it through a memory mapping
+	template<class T>
+	void testLoad(T && doc, const char * path) {
+		std::cout << "Loading Document with " << typeid(T).name() << "\n------------------------------------------------\n";
+
+		{
+			std::ifstream in(path);
+			Library::Timer("Elapsed Time of ::load(stream) \t= "), doc.load(in);
+		}
+
+		bool loaded;
+		Library::Timer("Elapsed Time of ::load(path) \t= "), loaded = doc.load(std::filesystem::path(path));
+		if (!loaded) {
+			std::cerr << "Can't read " << path << "!\n";
+		}
+
+		std::cout << '\n';
+	}
+
+	// the edit session above on a document that keeps only a few pages of the file in memory
+	void testPaged(const char * path) {
+		std::cout << "Testing PagedDocument with 4 resident pages of 64 KiB\n------------------------------------------------\n";
+
+		Library::PagedDocument doc(4, 1 << 16);
+		Library::Timer("Elapsed Time of ::load(path) \t= "), doc.load(path);
+		Library::Timer("Elapsed Time of ::snap() \t= "), doc.snap();
+		Library::Timer("Elapsed Time of ::erase() \t= "), doc.erase("a string");
+		Library::Timer("Elapsed Time of ::undo(1) \t= "), doc.undo(1);
+		Library::Timer("Elapsed Time of ::copy_range() \t= "), doc.copy_range("is a directive", "argument less");
+		Library::Timer("Elapsed Time of ::paste_after() \t= "), doc.paste_after("whose remaining");
+		Library::Timer("Elapsed Time of ::substitute() \t= "), doc.substitute("effective length", "ineffective measurement");
+		Library::Timer("Elapsed Time of ::erase() \t= "), doc.erase("there's no way this phrase is in there");
+
+		std::cout << "Pages: " << doc.pages() << ", read back: " << doc.faults() << ", spilled: " << doc.spills() << "\n\n";
+	}
 }
 
-// main routine
-int main() {
+// main routine. If given the path of the input file, also compares the ways of loading it
+int main(int argc, char * argv[]) {
 	
 	// test the document functions using each of the STL containers specified
 	testDocument(Document<std::vector>(), std::cin);
@@ -65,6 +130,37 @@ int main() {
 	testDocument(Document<std::deque>(), std::cin);
 	testDocument(Document<std::forward_list>(), std::cin);
 
+	// and with the chunked sequence written for Document
+	testDocument(Document<Library::Rope>(), std::cin);
+
+	// and with each word interned as an ID in a shared dictionary
+	testDocument(Document<std::vector, Library::Word>(), std::cin);
+
+	// and with an index of where each word occurs, showing where the time goes
+	Document<std::vector> indexed;
+	indexed.use_index();
+	Library::Profiler::enable();
+	testDocument(indexed, std::cin);
+	Library::Profiler::enable(false);
+	Library::Profiler::write(std::cout);
+	std::cout << '\n';
+
+	// and with the work split over every hardware thread
+	Document<std::vector> threaded;
+	threaded.threads(0);
+	testDocument(threaded, std::cin);
+
+	// and the same edits as one batch
+	testBatch(Document<std::vector>(), std::cin);
+	testBatch(Document<std::list>(), std::cin);
+
+	if (argc > 1) {
+		testLoad(Document<std::vector>(), argv[1]);
+		testLoad(Document<std::vector, Library::Word>(), argv[1]);
+		testLoad(Document<std::vector, Library::Token>(), argv[1]);
+		testPaged(argv[1]);
+	}
+
 	return 0;
 }
 
@@ -0,0 +1,88 @@
+/**
+* File:		BenchmarkSupport.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains what the benchmarks share: the tickets they're run on, timing, and reading options, each
+*			followed by a value, from the command line. Each benchmark takes the options it knows and fails on the rest.
+*
+*			Usage:
+*				const std::vector<TroubleTicket> tickets = Benchmark::makeTickets(1000000);
+*				Benchmark::parseOptions(argc, argv, [&](std::string const & option, std::string const & value) {
+*					if (option == "--tickets") { counts = Benchmark::parseCounts(value); return true; }
+*					return false;
+*				});
+*/
+
+#ifndef BENCHMARK_SUPPORT_HPP
+#define BENCHMARK_SUPPORT_HPP
+
+// includes
+#include "TroubleTicket.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Benchmark {
+	using Clock = std::chrono::steady_clock;
+
+	// tickets with priorities spread evenly over the levels and 20 to 80 character descriptions
+	inline std::vector<TroubleTicket> makeTickets(std::size_t count) {
+		std::mt19937 random(42);
+		std::uniform_int_distribution<int> priority(TroubleTicket::Priority::NONE, TroubleTicket::Priority::CRITICAL);
+		std::uniform_int_distribution<std::size_t> length(20, 80);
+
+		std::vector<TroubleTicket> tickets;
+		tickets.reserve(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			std::string description(length(random), 'x');
+			tickets.emplace_back(description, static_cast<TroubleTicket::Priority::Type>(priority(random)));
+		}
+		return tickets;
+	}
+
+	inline double seconds(Clock::time_point start, Clock::time_point stop) {
+		return std::chrono::duration<double>(stop - start).count();
+	}
+
+	// median of the samples
+	inline double median(std::vector<double> samples) {
+		std::sort(samples.begin(), samples.end());
+		return samples[samples.size() / 2];
+	}
+
+	// a comma separated list of counts, each at least 1
+	inline std::vector<std::size_t> parseCounts(std::string const & text) {
+		std::vector<std::size_t> counts;
+		std::istringstream stream(text);
+		for (std::string item; std::getline(stream, item, ','); ) {
+			if (!item.empty()) {
+				counts.push_back(std::max<std::size_t>(std::stoul(item), 1));
+			}
+		}
+		return counts;
+	}
+
+	// hands each option and its value to take, which returns false for an option it doesn't know
+	template<class Take>
+	void parseOptions(int argc, char * argv[], Take take) {
+		for (int i = 1; i < argc; ++i) {
+			const std::string option = argv[i];
+			if (i + 1 >= argc) {
+				throw std::invalid_argument("missing value for " + option);
+			}
+			const std::string value = argv[++i];
+
+			if (!take(option, value)) {
+				throw std::invalid_argument("unknown option " + option);
+			}
+		}
+	}
+}
+
+#endif
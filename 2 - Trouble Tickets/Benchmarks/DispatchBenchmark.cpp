@@ -0,0 +1,244 @@
+/**
+* File:		DispatchBenchmark.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Scaling measurement of TicketDispatcher. For each thread count n, n intake threads create tickets with random
+*			priorities and submit them while n workers work them, and the time from the first ticket created to the last
+*			one worked is taken. The same run is made against locked_queue, one std::priority_queue behind one mutex
+*			shared by every thread, which is what putting a lock around the single threaded queues would give. Each is run
+*			a number of times and the median is reported in CSV, with how many tickets the dispatcher's workers stole.
+*
+*			Working a ticket walks its description a number of times (--work) so the workers have something to do
+*			besides contend; with --work 0 the run measures nothing but the queues.
+*
+*			This is built separately from the ticket program, with optimization:
+*				make benchmark
+*				./DispatchBenchmark_g++.exe --threads 1,2,4,8 --tickets 1000000 --work 4 --reps 3
+*/
+
+#include "BenchmarkSupport.hpp"
+#include "TicketDispatcher.hpp"
+#include "TroubleTicket.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+	using Benchmark::Clock;
+
+	struct Options {
+		std::vector<std::size_t>	threads;
+		std::size_t					tickets = 1000000;
+		std::size_t					work = 4;
+		std::size_t					repetitions = 3;
+	};
+
+	// the sum every handler adds to, so working a ticket isn't optimized away
+	std::atomic<unsigned long> checksum{ 0 };
+
+	void handle(TroubleTicket & ticket, std::size_t work) {
+		const std::string_view description = ticket.description();
+		unsigned long hash = ticket.ticketNumber();
+		for (std::size_t pass = 0; pass < work; ++pass) {
+			for (char c : description) {
+				hash = hash * 31 + static_cast<unsigned char>(c);
+			}
+		}
+		ticket.status(TroubleTicket::Status::CLOSED);
+		if (hash == 0) {
+			checksum.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// every thread through one lock, for comparison
+	class LockedQueue {
+	public:
+		LockedQueue(std::size_t workers, std::size_t work) : _work(work) {
+			for (std::size_t i = 0; i < workers; ++i) {
+				_threads.emplace_back([this] { run(); });
+			}
+		}
+
+		~LockedQueue() {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_closing = true;
+			}
+			_ready.notify_all();
+			for (auto & thread : _threads) {
+				thread.join();
+			}
+		}
+
+		void submit(TroubleTicket && ticket) {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_queue.push(std::move(ticket));
+				++_submitted;
+			}
+			_ready.notify_one();
+		}
+
+		void drain() {
+			std::unique_lock<std::mutex> lock(_mutex);
+			_done.wait(lock, [this] { return _worked == _submitted; });
+		}
+
+		std::size_t stolen() const { return 0; }
+
+	private:
+		void run() {
+			std::unique_lock<std::mutex> lock(_mutex);
+			while (true) {
+				_ready.wait(lock, [this] { return _closing || !_queue.empty(); });
+				if (_queue.empty()) {
+					return;
+				}
+				TroubleTicket ticket = _queue.top();
+				_queue.pop();
+				lock.unlock();
+
+				handle(ticket, _work);
+
+				lock.lock();
+				if (++_worked == _submitted) {
+					_done.notify_all();
+				}
+			}
+		}
+
+		const std::size_t					_work;
+		std::mutex							_mutex;
+		std::condition_variable				_ready;
+		std::condition_variable				_done;
+		std::priority_queue<TroubleTicket>	_queue;
+		std::size_t							_submitted = 0;
+		std::size_t							_worked = 0;
+		bool								_closing = false;
+		std::vector<std::thread>			_threads;
+	};
+
+	std::unique_ptr<TicketDispatcher> makeDispatcher(std::size_t threads, std::size_t work) {
+		return std::unique_ptr<TicketDispatcher>(new TicketDispatcher(threads, [work](TroubleTicket & ticket) { handle(ticket, work); }));
+	}
+
+	std::unique_ptr<LockedQueue> makeLocked(std::size_t threads, std::size_t work) {
+		return std::unique_ptr<LockedQueue>(new LockedQueue(threads, work));
+	}
+
+	// n intake threads creating and submitting their share of the tickets, timed until all are worked. Returns seconds
+	template<class Dispatcher>
+	double run(Dispatcher & dispatcher, std::size_t threads, std::size_t tickets, std::size_t & stolen) {
+		const auto start = Clock::now();
+
+		std::vector<std::thread> intake;
+		for (std::size_t t = 0; t < threads; ++t) {
+			const std::size_t share = tickets / threads + (t < tickets % threads ? 1 : 0);
+			intake.emplace_back([&dispatcher, share, t] {
+				std::mt19937 random(static_cast<unsigned>(42 + t));
+				std::uniform_int_distribution<int> priority(TroubleTicket::Priority::NONE, TroubleTicket::Priority::CRITICAL);
+				std::uniform_int_distribution<std::size_t> length(20, 80);
+				for (std::size_t i = 0; i < share; ++i) {
+					dispatcher.submit(TroubleTicket(std::string(length(random), 'x'),
+						static_cast<TroubleTicket::Priority::Type>(priority(random))));
+				}
+			});
+		}
+		for (auto & thread : intake) {
+			thread.join();
+		}
+		dispatcher.drain();
+
+		const auto stop = Clock::now();
+		stolen = dispatcher.stolen();
+		return Benchmark::seconds(start, stop);
+	}
+
+	template<class Make>
+	void measure(char const * name, Make make, std::size_t threads, Options const & options) {
+		std::vector<double> samples;
+		std::size_t stolen = 0;
+		for (std::size_t rep = 0; rep < options.repetitions; ++rep) {
+			auto dispatcher = make(threads, options.work);
+			samples.push_back(run(*dispatcher, threads, options.tickets, stolen));
+		}
+		const double seconds = Benchmark::median(samples);
+
+		std::cout << name << ',' << threads << ',' << options.tickets << ',' << std::fixed << std::setprecision(3)
+			<< seconds * 1e3 << ',' << std::setprecision(2) << static_cast<double>(options.tickets) / seconds / 1e6
+			<< ',' << stolen << '\n';
+	}
+
+	// 1, 2, 4, ... up to the number of hardware threads, and that number itself
+	std::vector<std::size_t> defaultThreads() {
+		const std::size_t cores = std::max(std::thread::hardware_concurrency(), 1U);
+		std::vector<std::size_t> threads;
+		for (std::size_t n = 1; n < cores; n *= 2) {
+			threads.push_back(n);
+		}
+		threads.push_back(cores);
+		return threads;
+	}
+
+	Options parse(int argc, char * argv[]) {
+		Options options;
+		Benchmark::parseOptions(argc, argv, [&options](std::string const & option, std::string const & value) {
+			if (option == "--threads") {
+				options.threads = Benchmark::parseCounts(value);
+			}
+			else if (option == "--tickets") {
+				options.tickets = std::max<std::size_t>(std::stoul(value), 1);
+			}
+			else if (option == "--work") {
+				options.work = std::stoul(value);
+			}
+			else if (option == "--reps") {
+				options.repetitions = std::max<std::size_t>(std::stoul(value), 1);
+			}
+			else {
+				return false;
+			}
+			return true;
+		});
+		if (options.threads.empty()) {
+			options.threads = defaultThreads();
+		}
+		return options;
+	}
+}
+
+// main routine. Options, each followed by a value:
+//	--threads 1,2,4		intake threads and workers of each run (default 1, 2, 4, ... up to the hardware threads)
+//	--tickets n			tickets in each run
+//	--work n			passes over a ticket's description to work it
+//	--reps n			timed runs of each
+int main(int argc, char * argv[]) {
+	try {
+		const Options options = parse(argc, argv);
+
+		std::cout << "dispatcher,threads,tickets,ms,million_tickets_per_s,stolen\n";
+		for (auto threads : options.threads) {
+			measure("locked_queue", makeLocked, threads, options);
+			measure("ticket_dispatcher", makeDispatcher, threads, options);
+		}
+	}
+	catch (std::exception const & error) {
+		std::cerr << error.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
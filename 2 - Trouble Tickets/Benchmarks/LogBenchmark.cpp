@@ -0,0 +1,202 @@
+/**
+* File:		LogBenchmark.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Cost of logging a ticket event, as time and heap allocations per ticket. The ways measured are:
+*				-ostringstream	building the text in a std::ostringstream and streaming it, as toString used to
+*				-to_string		streaming toString(), one string per ticket
+*				-stream			operator<<, which now formats straight into the stream
+*				-format_to		TroubleTicket::format_to into a string buffer that is reused
+*				-ticket_log		TicketLog::record, with the writer thread writing the batches
+*			Output goes to a stream that discards it, so only the formatting and the logging machinery are measured. The
+*			median of a number of runs is reported in CSV. First, every ticket's toString() is checked against the old
+*			ostringstream text, and the benchmark fails if any differs.
+*
+*			This is built separately from the ticket program, with optimization:
+*				make benchmark
+*				./LogBenchmark_g++.exe --tickets 1000000 --reps 3
+*/
+
+#include "BenchmarkSupport.hpp"
+#include "TicketLog.hpp"
+#include "TroubleTicket.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace {
+	std::atomic<unsigned long long> allocations{ 0 };
+}
+
+// every allocation in the program is counted
+void * operator new(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void * memory = std::malloc(size > 0 ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void * memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void * memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+namespace {
+	using Benchmark::Clock;
+
+	struct Options {
+		std::size_t	tickets = 1000000;
+		std::size_t	repetitions = 3;
+	};
+
+	// a stream buffer that throws everything away
+	class NullBuffer : public std::streambuf {
+	protected:
+		int_type overflow(int_type c) override { return c; }
+		std::streamsize xsputn(char const *, std::streamsize count) override { return count; }
+	};
+
+	// what toString did before format_to
+	std::string streamed(TroubleTicket const & ticket) {
+		std::ostringstream temp;
+		temp << "ID=" << ticket.ticketNumber() << ", Priority=" << TroubleTicket::Priority::toString(ticket.priority())
+			<< ", Status=" << TroubleTicket::Status::toString(ticket.status()) << '\n' << "Description:\n" << ticket.description() << '\n';
+		if (!ticket.resolution().empty()) {
+			temp << "Resolution:\n" << ticket.resolution() << '\n';
+		}
+		return temp.str();
+	}
+
+	// tickets with random priorities and 20 to 80 character descriptions, a third of them resolved
+	std::vector<TroubleTicket> makeTickets(std::size_t count) {
+		std::mt19937 random(42);
+		std::uniform_int_distribution<int> priority(TroubleTicket::Priority::NONE, TroubleTicket::Priority::CRITICAL);
+		std::uniform_int_distribution<std::size_t> length(20, 80);
+
+		std::vector<TroubleTicket> tickets;
+		tickets.reserve(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			tickets.emplace_back(std::string(length(random), 'x'), static_cast<TroubleTicket::Priority::Type>(priority(random)));
+			if (i % 3 == 0) {
+				tickets.back().resolution(std::string(length(random), 'y'));
+			}
+		}
+		return tickets;
+	}
+
+	// time one way of logging every ticket, reporting the median time and the allocations of the last run
+	template<class Log>
+	void measure(char const * name, std::vector<TroubleTicket> const & tickets, Options const & options, Log log) {
+		std::vector<double> samples;
+		unsigned long long allocated = 0;
+		for (std::size_t rep = 0; rep < options.repetitions; ++rep) {
+			const unsigned long long before = allocations.load();
+			const auto start = Clock::now();
+			log(tickets);
+			const auto stop = Clock::now();
+			allocated = allocations.load() - before;
+			samples.push_back(Benchmark::seconds(start, stop));
+		}
+
+		const double count = static_cast<double>(tickets.size());
+		std::cout << name << ',' << tickets.size() << ',' << std::fixed << std::setprecision(1)
+			<< Benchmark::median(samples) * 1e9 / count << ',' << std::setprecision(3)
+			<< static_cast<double>(allocated) / count << '\n';
+	}
+
+	Options parse(int argc, char * argv[]) {
+		Options options;
+		Benchmark::parseOptions(argc, argv, [&options](std::string const & option, std::string const & value) {
+			if (option == "--tickets") {
+				options.tickets = std::max<std::size_t>(std::stoul(value), 1);
+			}
+			else if (option == "--reps") {
+				options.repetitions = std::max<std::size_t>(std::stoul(value), 1);
+			}
+			else {
+				return false;
+			}
+			return true;
+		});
+		return options;
+	}
+}
+
+// main routine. Options, each followed by a value:
+//	--tickets n		tickets logged in each run
+//	--reps n		timed runs of each
+int main(int argc, char * argv[]) {
+	try {
+		const Options options = parse(argc, argv);
+		const std::vector<TroubleTicket> tickets = makeTickets(options.tickets);
+
+		// the faster ways must write the same text the old one did
+		for (auto const & ticket : tickets) {
+			if (ticket.toString() != streamed(ticket)) {
+				std::cerr << "format_to differs from the old toString for ticket " << ticket.ticketNumber() << '\n';
+				return 1;
+			}
+		}
+
+		NullBuffer discard;
+		std::ostream out(&discard);
+
+		std::cout << "log,tickets,ns_per_ticket,allocations_per_ticket\n";
+		measure("ostringstream", tickets, options, [&out](std::vector<TroubleTicket> const & all) {
+			for (auto const & ticket : all) {
+				out << "Inserted: " << streamed(ticket) << '\n';
+			}
+		});
+		measure("to_string", tickets, options, [&out](std::vector<TroubleTicket> const & all) {
+			for (auto const & ticket : all) {
+				out << "Inserted: " << ticket.toString() << '\n';
+			}
+		});
+		measure("stream", tickets, options, [&out](std::vector<TroubleTicket> const & all) {
+			for (auto const & ticket : all) {
+				out << "Inserted: " << ticket << '\n';
+			}
+		});
+
+		std::string buffer;
+		measure("format_to", tickets, options, [&out, &buffer](std::vector<TroubleTicket> const & all) {
+			for (auto const & ticket : all) {
+				buffer.assign("Inserted: ");
+				const std::size_t before = buffer.size();
+				buffer.resize(before + ticket.formatted_size() + 1);
+				*ticket.format_to(&buffer[before]) = '\n';
+				out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			}
+		});
+
+		// one log for every run, so its batches have grown by the time it's measured again
+		TicketLog log(out);
+		measure("ticket_log", tickets, options, [&log](std::vector<TroubleTicket> const & all) {
+			for (auto const & ticket : all) {
+				log.record("Inserted", ticket);
+			}
+			log.flush();
+		});
+	}
+	catch (std::exception const & error) {
+		std::cerr << error.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
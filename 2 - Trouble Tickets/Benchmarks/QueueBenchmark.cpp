@@ -0,0 +1,148 @@
+/**
+* File:		QueueBenchmark.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Throughput comparison of the ticket containers simulateSession<T> runs on. For each number of tickets, the
+*			tickets are made up front with random priorities and descriptions long enough to live on the heap, and each
+*			container is then timed:
+*				-fill	pushing every ticket (a copy, as createTicket does)
+*				-drain	looking at the next ticket and popping it until the container is empty
+*				-churn	with the container full, working one ticket and pushing a new one, as a busy queue does
+*			Each is run a number of times and the median is reported, as nanoseconds per ticket and millions of tickets
+*			per second, in CSV.
+*
+*			This is built separately from the ticket program, with optimization:
+*				make benchmark
+*				./QueueBenchmark_g++.exe --tickets 1000000,4000000 --reps 3
+*/
+
+#include "BenchmarkSupport.hpp"
+#include "BucketQueue.hpp"
+#include "TicketStore.hpp"
+#include "TroubleTicket.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <stack>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	using Benchmark::Clock;
+	using Benchmark::makeTickets;
+	using Benchmark::median;
+	using Benchmark::seconds;
+
+	struct Options {
+		std::vector<std::size_t>	tickets = { 1000000, 4000000 };
+		std::size_t					repetitions = 3;
+	};
+
+	// the next ticket to work, whichever end of the container that is
+	template<typename T>
+	TroubleTicket const & peek(T & container) {
+		return container.top();
+	}
+
+	template<>
+	TroubleTicket const & peek(std::queue<TroubleTicket> & container) {
+		return container.front();
+	}
+
+	void report(char const * container, std::size_t tickets, char const * phase, double seconds) {
+		const double perTicket = seconds * 1e9 / static_cast<double>(tickets);
+		std::cout << container << ',' << tickets << ',' << phase << ',' << std::fixed << std::setprecision(1)
+			<< perTicket << ',' << std::setprecision(2) << 1e3 / perTicket << '\n';
+	}
+
+	template<typename T>
+	void measure(char const * name, std::vector<TroubleTicket> const & tickets, std::vector<TroubleTicket> const & arrivals, Options const & options) {
+		std::vector<double> fill, drain, churn;
+		unsigned long checksum = 0;
+
+		for (std::size_t rep = 0; rep < options.repetitions; ++rep) {
+			T container;
+
+			auto start = Clock::now();
+			for (auto const & ticket : tickets) {
+				container.push(ticket);
+			}
+			auto stop = Clock::now();
+			fill.push_back(seconds(start, stop));
+
+			start = Clock::now();
+			for (auto const & ticket : arrivals) {
+				checksum += peek(container).ticketNumber();
+				container.pop();
+				container.push(ticket);
+			}
+			stop = Clock::now();
+			churn.push_back(seconds(start, stop));
+
+			start = Clock::now();
+			while (container.size() > 0) {
+				checksum += peek(container).ticketNumber();
+				container.pop();
+			}
+			stop = Clock::now();
+			drain.push_back(seconds(start, stop));
+		}
+
+		report(name, tickets.size(), "fill", median(fill));
+		report(name, arrivals.size(), "churn", median(churn));
+		report(name, tickets.size(), "drain", median(drain));
+
+		// keeps the work from being optimized away
+		if (checksum == 0) {
+			std::cerr << "no tickets worked\n";
+		}
+	}
+
+	Options parse(int argc, char * argv[]) {
+		Options options;
+		Benchmark::parseOptions(argc, argv, [&options](std::string const & option, std::string const & value) {
+			if (option == "--tickets") {
+				options.tickets = Benchmark::parseCounts(value);
+			}
+			else if (option == "--reps") {
+				options.repetitions = std::max<std::size_t>(std::stoul(value), 1);
+			}
+			else {
+				return false;
+			}
+			return true;
+		});
+		return options;
+	}
+}
+
+// main routine. Options, each followed by a value:
+//	--tickets 1000000,4000000		numbers of tickets to measure with
+//	--reps n						timed runs of each container
+int main(int argc, char * argv[]) {
+	try {
+		const Options options = parse(argc, argv);
+
+		std::cout << "container,tickets,phase,ns_per_ticket,million_tickets_per_s\n";
+		for (auto count : options.tickets) {
+			// the tickets churn brings in are new ones, as TicketStore holds only one ticket with each number
+			const std::vector<TroubleTicket> tickets = makeTickets(count);
+			const std::vector<TroubleTicket> arrivals = makeTickets(count / 2);
+			measure<std::queue<TroubleTicket>>("queue", tickets, arrivals, options);
+			measure<std::stack<TroubleTicket>>("stack", tickets, arrivals, options);
+			measure<std::priority_queue<TroubleTicket>>("priority_queue", tickets, arrivals, options);
+			measure<TicketStore>("ticket_store", tickets, arrivals, options);
+			measure<BucketQueue>("bucket_queue", tickets, arrivals, options);
+		}
+	}
+	catch (std::exception const & error) {
+		std::cerr << error.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
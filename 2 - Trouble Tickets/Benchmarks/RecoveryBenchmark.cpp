@@ -0,0 +1,119 @@
+/**
+* File:		RecoveryBenchmark.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Cost of keeping tickets with DurableStore, and of getting them back. For each number of tickets, a store is
+*			filled with them and then churned, working one ticket and pushing a new one, for a number of changes of
+*			history. Then it is closed and opened again, the way a restarted program would, and timed:
+*				-snapshot	the default, a snapshot every 100000 changes and the journal after it
+*				-journal	no snapshots, so every change of the history is replayed
+*			Reported in CSV: the nanoseconds each change took to make (journaled, synced in the background), what
+*			recovery read, and how long the restart took. With snapshots the restart follows the number of tickets held,
+*			not the length of the history.
+*
+*			This is built separately from the ticket program, with optimization:
+*				make benchmark
+*				./RecoveryBenchmark_g++.exe --tickets 100000,1000000 --history 1000000
+*/
+
+#include "BenchmarkSupport.hpp"
+#include "DurableStore.hpp"
+#include "TroubleTicket.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	using Benchmark::Clock;
+	using Benchmark::makeTickets;
+	using Benchmark::seconds;
+
+	struct Options {
+		std::vector<std::size_t>	tickets = { 100000, 1000000 };
+		std::size_t					history = 1000000;
+		std::filesystem::path		directory = std::filesystem::temp_directory_path() / "RecoveryBenchmark";
+	};
+
+	// fill and churn a store, then time opening it again
+	void measure(char const * mode, std::size_t snapshotEvery, std::vector<TroubleTicket> const & tickets,
+		std::vector<TroubleTicket> const & arrivals, Options const & options) {
+		std::filesystem::remove_all(options.directory);
+
+		double perChange;
+		{
+			DurableStore store(options.directory, snapshotEvery);
+			const auto start = Clock::now();
+			for (auto const & ticket : tickets) {
+				store.push(ticket);
+			}
+			for (auto const & ticket : arrivals) {
+				store.pop();
+				store.push(ticket);
+			}
+			store.commit();
+			const auto stop = Clock::now();
+			perChange = seconds(start, stop) * 1e9 / static_cast<double>(tickets.size() + 2 * arrivals.size());
+		}
+
+		DurableStore store(options.directory, snapshotEvery);
+		if (store.size() != tickets.size()) {
+			std::cerr << "recovered " << store.size() << " tickets of " << tickets.size() << '\n';
+		}
+
+		DurableStore::Recovery const & recovery = store.recovery();
+		std::cout << mode << ',' << tickets.size() << ',' << options.history << ',' << std::fixed << std::setprecision(1)
+			<< perChange << ',' << recovery.snapshotTickets << ',' << recovery.journalRecords << ','
+			<< std::setprecision(2) << recovery.milliseconds << '\n';
+	}
+
+	Options parse(int argc, char * argv[]) {
+		Options options;
+		Benchmark::parseOptions(argc, argv, [&options](std::string const & option, std::string const & value) {
+			if (option == "--tickets") {
+				options.tickets = Benchmark::parseCounts(value);
+			}
+			else if (option == "--history") {
+				options.history = std::stoul(value);
+			}
+			else if (option == "--directory") {
+				options.directory = value;
+			}
+			else {
+				return false;
+			}
+			return true;
+		});
+		return options;
+	}
+}
+
+// main routine. Options, each followed by a value:
+//	--tickets 100000,1000000		numbers of tickets held
+//	--history n						tickets worked and replaced after filling, each two changes
+//	--directory path				where to keep the store, emptied first and removed after
+int main(int argc, char * argv[]) {
+	try {
+		const Options options = parse(argc, argv);
+
+		std::cout << "mode,tickets,history,ns_per_change,snapshot_tickets,journal_records,restart_ms\n";
+		for (auto count : options.tickets) {
+			const std::vector<TroubleTicket> tickets = makeTickets(count);
+			const std::vector<TroubleTicket> arrivals = makeTickets(options.history);
+			measure("snapshot", 100000, tickets, arrivals, options);
+			measure("journal", std::numeric_limits<std::size_t>::max(), tickets, arrivals, options);
+		}
+		std::filesystem::remove_all(options.directory);
+	}
+	catch (std::exception const & error) {
+		std::cerr << error.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
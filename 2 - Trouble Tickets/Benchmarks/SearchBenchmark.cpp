@@ -0,0 +1,186 @@
+/**
+* File:		SearchBenchmark.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Latency of TicketIndex queries over a large ticket history, against scanning every ticket's text as the
+*			program had to before. Tickets are made with descriptions of 6 to 20 words drawn, most often the common ones,
+*			from a vocabulary that includes host names and error codes; a third are resolved with a few more words, and
+*			most are closed. Then each query is timed:
+*				-rare_term		an error code on a few dozen tickets
+*				-common_term	one of the most common words, open tickets only
+*				-host_phrase	a host name, which is a phrase of its parts
+*				-word_phrase	two words one after the other, critical tickets only
+*			Each is run a number of times and the median is reported in microseconds, with the tickets it found, in CSV.
+*
+*			This is built separately from the ticket program, with optimization:
+*				make benchmark
+*				./SearchBenchmark_g++.exe --tickets 100000,500000 --reps 50
+*/
+
+#include "BenchmarkSupport.hpp"
+#include "TicketIndex.hpp"
+#include "TroubleTicket.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+	using Benchmark::Clock;
+	using Benchmark::median;
+
+	struct Options {
+		std::vector<std::size_t>	tickets = { 100000, 500000 };
+		std::size_t					repetitions = 50;
+	};
+
+	struct Query {
+		char const *			name;
+		std::string				text;
+		bool					phrase;
+		TicketIndex::Filter		filter;
+	};
+
+	// words w0 to w4999, host names db-0.example.com to db-199.example.com and error codes e1000 to e9999
+	std::string word(std::mt19937 & random) {
+		const unsigned pick = random() % 100;
+		if (pick < 3) {
+			return "db-" + std::to_string(random() % 200) + ".example.com";
+		}
+		if (pick < 5) {
+			return "E" + std::to_string(1000 + random() % 9000);
+		}
+		// squaring skews the draw toward the first words
+		const double skew = std::uniform_real_distribution<double>(0, 1)(random);
+		return "w" + std::to_string(static_cast<unsigned>(skew * skew * 5000));
+	}
+
+	std::string sentence(std::mt19937 & random, std::size_t words) {
+		std::string text;
+		for (std::size_t i = 0; i < words; ++i) {
+			text += word(random);
+			text += i + 1 < words ? " " : ".";
+		}
+		return text;
+	}
+
+	std::vector<TroubleTicket> makeTickets(std::size_t count) {
+		std::mt19937 random(42);
+		std::uniform_int_distribution<int> priority(TroubleTicket::Priority::NONE, TroubleTicket::Priority::CRITICAL);
+		std::uniform_int_distribution<std::size_t> length(6, 20);
+
+		std::vector<TroubleTicket> tickets;
+		tickets.reserve(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			const TroubleTicket::Status::Type status = random() % 4 == 0 ? TroubleTicket::Status::OPEN : TroubleTicket::Status::CLOSED;
+			tickets.emplace_back(sentence(random, length(random)), static_cast<TroubleTicket::Priority::Type>(priority(random)), status);
+			if (random() % 3 == 0) {
+				tickets.back().resolution(sentence(random, 4));
+			}
+		}
+		return tickets;
+	}
+
+	double microseconds(Clock::time_point start, Clock::time_point stop) {
+		return std::chrono::duration<double, std::micro>(stop - start).count();
+	}
+
+	// the old way: look at every ticket's text
+	std::size_t scan(std::vector<TroubleTicket> const & tickets, std::string_view text) {
+		std::size_t found = 0;
+		for (auto const & ticket : tickets) {
+			if (ticket.description().find(text) != std::string_view::npos || ticket.resolution().find(text) != std::string_view::npos) {
+				++found;
+			}
+		}
+		return found;
+	}
+
+	void report(char const * method, std::size_t tickets, char const * query, std::size_t found, double microseconds) {
+		std::cout << method << ',' << tickets << ',' << query << ',' << found << ',' << std::fixed << std::setprecision(1)
+			<< microseconds << '\n';
+	}
+
+	void measure(std::vector<TroubleTicket> const & tickets, Options const & options) {
+		TicketIndex index;
+		auto start = Clock::now();
+		for (auto const & ticket : tickets) {
+			index.add(ticket);
+		}
+		auto stop = Clock::now();
+		std::cout << "index_build," << tickets.size() << ",,," << std::fixed << std::setprecision(1)
+			<< microseconds(start, stop) << '\n';
+
+		std::vector<Query> queries = {
+			{ "rare_term", "e4242", false, TicketIndex::Filter() },
+			{ "common_term", "w0", false, TicketIndex::Filter().status(TroubleTicket::Status::OPEN) },
+			{ "host_phrase", "db-42.example.com", true, TicketIndex::Filter() },
+			{ "word_phrase", "w1 w2", true, TicketIndex::Filter().priority(TroubleTicket::Priority::CRITICAL) },
+		};
+		for (auto const & query : queries) {
+			std::vector<double> samples;
+			std::size_t found = 0;
+			for (std::size_t rep = 0; rep < options.repetitions; ++rep) {
+				start = Clock::now();
+				found = (query.phrase ? index.with_phrase(query.text, query.filter) : index.with_term(query.text, query.filter)).size();
+				stop = Clock::now();
+				samples.push_back(microseconds(start, stop));
+			}
+			report("index", tickets.size(), query.name, found, median(samples));
+		}
+
+		// a scan takes long enough that a few runs do
+		std::vector<double> samples;
+		std::size_t found = 0;
+		for (std::size_t rep = 0; rep < std::min<std::size_t>(options.repetitions, 5); ++rep) {
+			start = Clock::now();
+			found = scan(tickets, "E4242");
+			stop = Clock::now();
+			samples.push_back(microseconds(start, stop));
+		}
+		report("scan", tickets.size(), "rare_term", found, median(samples));
+	}
+
+	Options parse(int argc, char * argv[]) {
+		Options options;
+		Benchmark::parseOptions(argc, argv, [&options](std::string const & option, std::string const & value) {
+			if (option == "--tickets") {
+				options.tickets = Benchmark::parseCounts(value);
+			}
+			else if (option == "--reps") {
+				options.repetitions = std::max<std::size_t>(std::stoul(value), 1);
+			}
+			else {
+				return false;
+			}
+			return true;
+		});
+		return options;
+	}
+}
+
+// main routine. Options, each followed by a value:
+//	--tickets 100000,500000		numbers of tickets to search
+//	--reps n					timed runs of each query
+int main(int argc, char * argv[]) {
+	try {
+		const Options options = parse(argc, argv);
+
+		std::cout << "method,tickets,query,found,microseconds\n";
+		for (auto count : options.tickets) {
+			measure(makeTickets(count), options);
+		}
+	}
+	catch (std::exception const & error) {
+		std::cerr << error.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
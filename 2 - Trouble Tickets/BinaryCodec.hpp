@@ -0,0 +1,119 @@
+/**
+* File:		BinaryCodec.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the encoding shared by the ticket journal and snapshots: fixed width little-endian
+*			integers, length prefixed text, and a checksum to tell a whole record from a torn or damaged one. Files
+*			written on one machine read the same on any other.
+*
+*			Usage:
+*				std::string bytes;
+*				Binary::put<std::uint32_t>(bytes, 42);
+*				Binary::putText(bytes, "printer jammed");
+*				Binary::Reader in(bytes);
+*				in.get<std::uint32_t>();
+*				in.getText();
+*/
+
+#ifndef BINARY_CODEC_HPP
+#define BINARY_CODEC_HPP
+
+// includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace Binary {
+	// write an unsigned integer over the sizeof(T) bytes at out, low byte first
+	template<class T>
+	void store(char * out, T value) {
+		static_assert(std::is_unsigned<T>::value, "unsigned integers only");
+		for (std::size_t i = 0; i < sizeof(T); ++i) {
+			out[i] = static_cast<char>(static_cast<unsigned char>(value >> (8 * i)));
+		}
+	}
+
+	// append an unsigned integer, low byte first
+	template<class T>
+	void put(std::string & out, T value) {
+		out.append(sizeof(T), '\0');
+		store(&out[out.size() - sizeof(T)], value);
+	}
+
+	// append the length as 32 bits, then the text
+	inline void putText(std::string & out, std::string_view text) {
+		put<std::uint32_t>(out, static_cast<std::uint32_t>(text.size()));
+		out.append(text.data(), text.size());
+	}
+
+	// FNV-1a over the bytes. Bytes checked in pieces carry on from the checksum of the pieces before
+	inline std::uint32_t checksum(std::string_view bytes, std::uint32_t hash = 2166136261U) {
+		for (char c : bytes) {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 16777619U;
+		}
+		return hash;
+	}
+
+	// reads back what put and putText wrote. Reading past the end sets a flag and gives zeros and empty text, so a
+	// whole record can be read and then checked once
+	class Reader {
+	public:
+		explicit Reader(std::string_view bytes) : _bytes(bytes) {}
+
+		template<class T>
+		T get() {
+			static_assert(std::is_unsigned<T>::value, "unsigned integers only");
+			if (!has(sizeof(T))) {
+				return 0;
+			}
+			T value = 0;
+			for (std::size_t i = 0; i < sizeof(T); ++i) {
+				value |= static_cast<T>(static_cast<unsigned char>(_bytes[_position + i])) << (8 * i);
+			}
+			_position += sizeof(T);
+			return value;
+		}
+
+		// a view into the bytes read from, not a copy
+		std::string_view getText() {
+			const std::size_t size = get<std::uint32_t>();
+			if (!has(size)) {
+				return std::string_view();
+			}
+			const std::string_view text = _bytes.substr(_position, size);
+			_position += size;
+			return text;
+		}
+
+		// the next bytes, skipped over
+		std::string_view getBytes(std::size_t size) {
+			if (!has(size)) {
+				return std::string_view();
+			}
+			const std::string_view bytes = _bytes.substr(_position, size);
+			_position += size;
+			return bytes;
+		}
+
+		bool			overrun()	const { return _overrun; }
+		std::size_t		position()	const { return _position; }
+		std::size_t		remaining()	const { return _bytes.size() - _position; }
+
+	private:
+		bool has(std::size_t size) {
+			if (_overrun || size > remaining()) {
+				_overrun = true;
+				return false;
+			}
+			return true;
+		}
+
+		std::string_view	_bytes;
+		std::size_t			_position = 0;
+		bool				_overrun = false;
+	};
+}
+
+#endif
@@ -0,0 +1,95 @@
+/**
+* File:		BucketQueue.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a priority queue of tickets made for the five levels of TroubleTicket::Priority. Each level
+*			has its own first in, first out RingBuffer, and a bit mask records which levels hold tickets, so the highest
+*			priority ticket is found with one table lookup. Push and pop are O(1), a ticket is moved once on the way in and
+*			never again until it is popped (std::priority_queue sifts whole tickets, strings and all, O(log n) times), and
+*			tickets of the same priority come out in the order they went in, which std::priority_queue doesn't promise.
+*
+*			It has the push/top/pop/size interface of std::priority_queue, so it drops into simulateSession<T>.
+*
+*			Usage:
+*				BucketQueue queue;
+*				queue.push(TroubleTicket("printer jammed", TroubleTicket::Priority::LOW));
+*				queue.top();
+*				queue.pop();
+*/
+
+#ifndef BUCKET_QUEUE_HPP
+#define BUCKET_QUEUE_HPP
+
+// includes
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include "RingBuffer.hpp"
+#include "TroubleTicket.hpp"
+
+class BucketQueue {
+public:
+	static constexpr std::size_t Levels = TroubleTicket::Priority::CRITICAL + 1;
+
+	void push(TroubleTicket const & ticket) {
+		emplace(ticket);
+	}
+
+	void push(TroubleTicket && ticket) {
+		emplace(std::move(ticket));
+	}
+
+	// the oldest ticket of the highest priority held. The queue must not be empty
+	TroubleTicket const & top() const {
+		return _levels[highest()].front();
+	}
+
+	// the same ticket, for moving out before it is popped
+	TroubleTicket & top() {
+		return _levels[highest()].front();
+	}
+
+	void pop() {
+		const std::size_t level = highest();
+		_levels[level].pop_front();
+		if (_levels[level].empty()) {
+			_occupied &= ~(1U << level);
+		}
+		--_size;
+	}
+
+	std::size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	// number of tickets held with a priority
+	std::size_t count(TroubleTicket::Priority::Type priority) const {
+		return _levels[priority].size();
+	}
+
+private:
+	template<class Ticket>
+	void emplace(Ticket && ticket) {
+		const std::size_t level = ticket.priority();
+		_levels[level].push_back(std::forward<Ticket>(ticket));
+		_occupied |= 1U << level;
+		++_size;
+	}
+
+	// the highest level holding tickets
+	std::size_t highest() const {
+		// highest set bit of each mask of Levels bits
+		static constexpr unsigned char highestBit[] = {
+			0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3,
+			4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+		};
+		static_assert(sizeof(highestBit) == std::size_t(1) << Levels, "one entry for each mask of Levels bits");
+		return highestBit[_occupied];
+	}
+
+	std::array<RingBuffer<TroubleTicket>, Levels>	_levels;
+	unsigned										_occupied = 0;		// bit p is set while level p holds tickets
+	std::size_t										_size = 0;
+};
+
+#endif
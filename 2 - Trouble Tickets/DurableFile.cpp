@@ -0,0 +1,186 @@
+/**
+* File:		DurableFile.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Member function definitions for DurableFile and MappedFile, described in DurableFile.hpp, for Windows and for
+*			POSIX systems.
+*/
+
+#include "DurableFile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+	#include <fcntl.h>
+	#include <io.h>
+	#include <sys/stat.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace {
+	[[noreturn]] void fail(char const * what, std::filesystem::path const & path) {
+		throw std::system_error(errno, std::generic_category(), std::string(what) + ' ' + path.string());
+	}
+}
+
+// open for appending, so every write lands at the end wherever the file was cut to
+DurableFile::DurableFile(std::filesystem::path const & path, bool truncate) : _path(path) {
+#ifdef _WIN32
+	_descriptor = _wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (truncate ? _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+#else
+	_descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+#endif
+	if (_descriptor < 0) {
+		fail("can't open", path);
+	}
+}
+
+DurableFile::~DurableFile() {
+#ifdef _WIN32
+	_close(_descriptor);
+#else
+	::close(_descriptor);
+#endif
+}
+
+// a descriptor may take less than it is given, so keep going until it has all of it
+void DurableFile::write(char const * data, std::size_t size) {
+	while (size > 0) {
+#ifdef _WIN32
+		const int written = _write(_descriptor, data, static_cast<unsigned>(std::min<std::size_t>(size, 1U << 30)));
+#else
+		const auto written = ::write(_descriptor, data, size);
+#endif
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			fail("can't write", _path);
+		}
+		data += written;
+		size -= static_cast<std::size_t>(written);
+	}
+}
+
+// the data, and as much of the metadata as reading it back needs
+void DurableFile::sync() {
+#ifdef _WIN32
+	const int result = _commit(_descriptor);
+#elif defined(__APPLE__)
+	const int result = ::fsync(_descriptor);
+#else
+	const int result = ::fdatasync(_descriptor);
+#endif
+	if (result != 0) {
+		fail("can't sync", _path);
+	}
+}
+
+void DurableFile::truncate(std::uint64_t size) {
+#ifdef _WIN32
+	const bool cut = _chsize_s(_descriptor, static_cast<long long>(size)) == 0;
+#else
+	const bool cut = ::ftruncate(_descriptor, static_cast<off_t>(size)) == 0;
+#endif
+	if (!cut) {
+		fail("can't truncate", _path);
+	}
+}
+
+// a directory's entries are synced through a descriptor of the directory
+void DurableFile::syncDirectory(std::filesystem::path const & directory) {
+#ifndef _WIN32
+	const int descriptor = ::open(directory.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		fail("can't open", directory);
+	}
+	const int result = ::fsync(descriptor);
+	::close(descriptor);
+	if (result != 0) {
+		fail("can't sync", directory);
+	}
+#else
+	static_cast<void>(directory);
+#endif
+}
+
+// map the whole file read-only, or leave the view empty if there is no file
+MappedFile::MappedFile(std::filesystem::path const & path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size)) {
+		_exists = true;
+		_size = static_cast<std::size_t>(size.QuadPart);
+		if (_size > 0) {
+			_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (_mapping != nullptr) {
+				_data = static_cast<char const *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+			}
+		}
+	}
+	CloseHandle(file);
+#else
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		return;
+	}
+
+	struct stat info;
+	if (::fstat(file, &info) == 0) {
+		_exists = true;
+		_size = static_cast<std::size_t>(info.st_size);
+		if (_size > 0) {
+			void * address = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (address != MAP_FAILED) {
+				// read front to back once
+				::madvise(address, _size, MADV_SEQUENTIAL);
+				_data = static_cast<char const *>(address);
+			}
+		}
+	}
+	// the mapping stays valid after the descriptor is closed
+	::close(file);
+#endif
+	if (_size > 0 && _data == nullptr) {
+#ifdef _WIN32
+		if (_mapping != nullptr) {
+			CloseHandle(_mapping);
+		}
+#endif
+		fail("can't map", path);
+	}
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mapping != nullptr) {
+		CloseHandle(_mapping);
+	}
+#else
+	if (_data != nullptr) {
+		::munmap(const_cast<char *>(_data), _size);
+	}
+#endif
+}
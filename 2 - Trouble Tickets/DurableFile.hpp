@@ -0,0 +1,74 @@
+/**
+* File:		DurableFile.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the two kinds of file access the durable ticket store needs, over the system calls so
+*			they can promise what they do:
+*				-DurableFile	a file written only at its end, whose sync() returns once what was written is on storage
+*				-MappedFile		a read-only memory mapping of a whole file, so it can be read with no copying or parsing
+*								into a buffer first
+*			Failures to open, write or sync throw std::system_error.
+*
+*			Usage:
+*				DurableFile journal("tickets/journal.wal");
+*				journal.write(bytes, size);
+*				journal.sync();
+*				MappedFile snapshot("tickets/snapshot.bin");
+*				snapshot.view();
+*/
+
+#ifndef DURABLE_FILE_HPP
+#define DURABLE_FILE_HPP
+
+// includes
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+class DurableFile {
+public:
+	// open a file to write at its end, creating it if it isn't there, or emptying it first if truncate is set
+	explicit DurableFile(std::filesystem::path const & path, bool truncate = false);
+	~DurableFile();
+
+	DurableFile(DurableFile const &) = delete;
+	DurableFile & operator=(DurableFile const &) = delete;
+
+	// write all of it, however many calls that takes
+	void write(char const * data, std::size_t size);
+
+	// wait until everything written is on storage
+	void sync();
+
+	// cut the file to a length, writing from there on
+	void truncate(std::uint64_t size);
+
+	// make a rename or a new file in a directory as durable as the file itself. Nothing is needed for this on Windows
+	static void syncDirectory(std::filesystem::path const & directory);
+
+private:
+	std::filesystem::path	_path;
+	int						_descriptor = -1;
+};
+
+class MappedFile {
+public:
+	// map the whole file. A file that isn't there, or is empty, maps to an empty view
+	explicit MappedFile(std::filesystem::path const & path);
+	~MappedFile();
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile & operator=(MappedFile const &) = delete;
+
+	bool				exists()	const { return _exists; }
+	std::string_view	view()		const { return std::string_view(_data, _size); }
+
+private:
+	char const *	_data = nullptr;
+	std::size_t		_size = 0;
+	bool			_exists = false;
+	void *			_mapping = nullptr;		// the mapping object's handle on Windows
+};
+
+#endif
@@ -0,0 +1,154 @@
+/**
+* File:		DurableStore.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Member function definitions for DurableStore, the persistent ticket store described in DurableStore.hpp.
+*/
+
+#include "DurableStore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+
+#include "TicketSnapshot.hpp"
+
+namespace {
+	char const * const SnapshotFile = "snapshot.bin";
+	char const * const JournalFile = "journal.wal";
+}
+
+// the snapshot, then the journal records it doesn't include, then carry on numbering and journaling from there
+DurableStore::DurableStore(std::filesystem::path const & directory, std::size_t snapshotEvery)
+	: _directory(directory), _snapshotEvery(std::max<std::size_t>(snapshotEvery, 1)) {
+	const auto start = std::chrono::steady_clock::now();
+	std::filesystem::create_directories(_directory);
+
+	const TicketSnapshot::Header header = TicketSnapshot::read(_directory / SnapshotFile, [this](TroubleTicket && ticket) {
+		_store.push(std::move(ticket));
+	});
+	_lastNumber = header.lastNumber;
+	_recovery.snapshotTickets = _store.size();
+
+	TicketJournal::Sequence last = header.sequence;
+	const std::uint64_t length = TicketJournal::replay(_directory / JournalFile, [this, &header, &last](TicketJournal::Record const & record) {
+		// a crash between writing a snapshot and emptying the journal leaves records the snapshot already has
+		if (record.sequence > header.sequence) {
+			apply(record);
+			last = record.sequence;
+			++_recovery.journalRecords;
+		}
+	});
+	_changes = _recovery.journalRecords;
+
+	TroubleTicket::continueAfter(_lastNumber);
+	_journal.reset(new TicketJournal(_directory / JournalFile, last + 1, length));
+	_recovery.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// a destructor can't throw, so changes that didn't make it to storage are reported instead
+DurableStore::~DurableStore() {
+	try {
+		_journal->commit();
+	}
+	catch (std::exception const & error) {
+		std::cerr << "DurableStore: changes to " << _directory.string() << " since the last commit were not kept: " << error.what() << '\n';
+	}
+}
+
+bool DurableStore::push(TroubleTicket const & ticket) {
+	if (!_store.push(ticket)) {
+		return false;
+	}
+	_lastNumber = std::max(_lastNumber, ticket.ticketNumber());
+	_journal->created(ticket);
+	changed();
+	return true;
+}
+
+void DurableStore::pop() {
+	const Id id = _store.top().ticketNumber();
+	_store.pop();
+	_journal->removed(id);
+	changed();
+}
+
+bool DurableStore::reprioritize(Id id, TroubleTicket::Priority::Type priority) {
+	if (!_store.reprioritize(id, priority)) {
+		return false;
+	}
+	_journal->reprioritized(id, priority);
+	changed();
+	return true;
+}
+
+bool DurableStore::update_status(Id id, TroubleTicket::Status::Type status) {
+	if (!_store.update_status(id, status)) {
+		return false;
+	}
+	_journal->statusChanged(id, status);
+	changed();
+	return true;
+}
+
+bool DurableStore::update_resolution(Id id, std::string const & resolution) {
+	if (!_store.update_resolution(id, resolution)) {
+		return false;
+	}
+	_journal->resolved(id, resolution);
+	changed();
+	return true;
+}
+
+bool DurableStore::cancel(Id id) {
+	if (!_store.cancel(id)) {
+		return false;
+	}
+	_journal->removed(id);
+	changed();
+	return true;
+}
+
+void DurableStore::commit() {
+	_journal->commit();
+}
+
+// the snapshot takes over from every record journaled so far, so once it's in place they can go
+void DurableStore::snapshot() {
+	TicketSnapshot::Header header;
+	header.sequence = _journal->last();
+	header.lastNumber = _lastNumber;
+	TicketSnapshot::write(_directory / SnapshotFile, header, _store.in_arrival_order());
+	_journal->clear();
+	_changes = 0;
+}
+
+// make a journaled change to the store while recovering
+void DurableStore::apply(TicketJournal::Record const & record) {
+	switch (record.kind) {
+	case TicketJournal::CREATE:
+		_store.push(TroubleTicket::restored(record.number, record.description, record.priority, record.status, record.resolution));
+		_lastNumber = std::max(_lastNumber, record.number);
+		break;
+	case TicketJournal::STATUS:
+		_store.update_status(record.number, record.status);
+		break;
+	case TicketJournal::PRIORITY:
+		_store.reprioritize(record.number, record.priority);
+		break;
+	case TicketJournal::RESOLUTION:
+		_store.update_resolution(record.number, std::string(record.resolution));
+		break;
+	case TicketJournal::REMOVE:
+		_store.cancel(record.number);
+		break;
+	}
+}
+
+// snapshot once enough has been journaled that replaying it would take longer than reading a snapshot
+void DurableStore::changed() {
+	if (++_changes >= _snapshotEvery) {
+		snapshot();
+	}
+}
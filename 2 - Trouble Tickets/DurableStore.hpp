@@ -0,0 +1,99 @@
+/**
+* File:		DurableStore.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a TicketStore that outlives the program. Every change (a ticket created, worked or
+*			cancelled, or its status, priority or resolution changed) is applied in memory and appended to a
+*			TicketJournal, whose writer thread syncs it to storage within a few milliseconds, or at once for commit().
+*			Every snapshotEvery changes the whole store is written as a TicketSnapshot and the journal is emptied.
+*
+*			Opening the directory again maps the snapshot, pushes its tickets back in the order they arrived, and
+*			replays only the journal records after it, so restarting reads each held ticket once plus at most
+*			snapshotEvery changes, however long the store has been in use. New tickets are numbered after the highest
+*			number the store ever gave out, including tickets long since worked.
+*
+*			If the journal can't be written, commit() and every change after the failure throw std::system_error; the
+*			change is made in memory but isn't kept. Closing the store reports, on std::cerr, changes it couldn't keep.
+*
+*			It has the push/top/pop/size interface of std::priority_queue, so it drops into simulateSession<T>.
+*
+*			Usage:
+*				DurableStore store("tickets");				// recovers whatever was there
+*				store.push(TroubleTicket("server down", TroubleTicket::Priority::CRITICAL));
+*				store.commit();								// wait until it's on storage
+*/
+
+#ifndef DURABLE_STORE_HPP
+#define DURABLE_STORE_HPP
+
+// includes
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TicketJournal.hpp"
+#include "TicketStore.hpp"
+#include "TroubleTicket.hpp"
+
+class DurableStore {
+public:
+	using Id = TicketStore::Id;
+
+	// what opening the store found
+	struct Recovery {
+		std::size_t		snapshotTickets = 0;	// tickets read from the snapshot
+		std::size_t		journalRecords = 0;		// changes replayed after it
+		double			milliseconds = 0;		// to do both
+	};
+
+	// open or create the store in a directory, recovering its tickets
+	explicit DurableStore(std::filesystem::path const & directory, std::size_t snapshotEvery = 100000);
+
+	// everything changed is committed, or the failure is reported on std::cerr
+	~DurableStore();
+
+	DurableStore(DurableStore const &) = delete;
+	DurableStore & operator=(DurableStore const &) = delete;
+
+	// as TicketStore, journaling each change. Throws if the journal has failed
+	bool push(TroubleTicket const & ticket);
+	TroubleTicket const & top() const { return _store.top(); }
+	void pop();
+
+	std::size_t size() const { return _store.size(); }
+	bool empty() const { return _store.empty(); }
+
+	TroubleTicket const * find(Id id) const { return _store.find(id); }
+	bool reprioritize(Id id, TroubleTicket::Priority::Type priority);
+	bool update_status(Id id, TroubleTicket::Status::Type status);
+	bool update_resolution(Id id, std::string const & resolution);
+	bool cancel(Id id);
+
+	std::size_t count_by_status(TroubleTicket::Status::Type status) const { return _store.count_by_status(status); }
+	std::vector<Id> with_status(TroubleTicket::Status::Type status) const { return _store.with_status(status); }
+	std::vector<TroubleTicket const *> in_work_order() const { return _store.in_work_order(); }
+
+	// wait until every change so far is on storage
+	void commit();
+
+	// write the store as a snapshot now and empty the journal
+	void snapshot();
+
+	Recovery const & recovery() const { return _recovery; }
+
+private:
+	void apply(TicketJournal::Record const & record);
+	void changed();
+
+	std::filesystem::path			_directory;
+	TicketStore						_store;
+	unsigned long					_lastNumber = 0;		// highest ticket number ever held
+	const std::size_t				_snapshotEvery;
+	std::size_t						_changes = 0;			// journaled since the last snapshot
+	Recovery						_recovery;
+	std::unique_ptr<TicketJournal>	_journal;				// opened once recovery knows where it ends
+};
+
+#endif
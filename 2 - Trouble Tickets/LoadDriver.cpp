@@ -0,0 +1,86 @@
+/**
+* File:		LoadDriver.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Member function definitions for LoadDriver, the scripted ticket session described in LoadDriver.hpp.
+*/
+
+#include "LoadDriver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+
+namespace {
+	// the value a fraction of the way through sorted samples, by nearest rank: the smallest sample with at least that
+	// fraction of them at or below it. Zero if there are none
+	double percentile(std::vector<double> const & sorted, double fraction) {
+		if (sorted.empty()) {
+			return 0;
+		}
+		const double rank = std::ceil(fraction * static_cast<double>(sorted.size()));
+		return sorted[static_cast<std::size_t>(std::clamp(rank, 1.0, static_cast<double>(sorted.size()))) - 1];
+	}
+
+	std::vector<double> sorted(std::vector<double> samples) {
+		std::sort(samples.begin(), samples.end());
+		return samples;
+	}
+}
+
+// the operations, and a ticket for each create with a description of the length it asks for
+LoadDriver::LoadDriver(Workload const & workload) : _operations(workload.operations()) {
+	const std::string text(workload.longestDescription(), 'x');
+
+	const std::size_t creates = static_cast<std::size_t>(std::count_if(_operations.cbegin(), _operations.cend(),
+		[](Operation const & operation) { return operation.kind == Operation::CREATE; }));
+	_tickets.reserve(creates);
+	_created.reserve(creates);
+
+	for (auto const & operation : _operations) {
+		if (operation.kind == Operation::CREATE) {
+			_tickets.emplace_back(text.substr(0, operation.length), operation.priority);
+			_created.emplace(_tickets.back().ticketNumber(), operation.time);
+		}
+	}
+}
+
+// one line per operation kind per container, then one per priority per container
+void LoadDriver::report(std::ostream & stream) const {
+	const std::size_t creates = _tickets.size();
+	const double span = _operations.empty() ? 0 : _operations.back().time;
+	// every container holds the same number of tickets at each point, so finds itself empty just as often
+	const std::size_t idle = _results.empty() ? 0 : _results.front().idle;
+	stream << "# " << _operations.size() << " operations: " << creates << " creates, " << _operations.size() - creates
+		<< " works (" << idle << " of them with nothing to work), over " << std::fixed << std::setprecision(1) << span
+		<< " seconds of workload time\n\n";
+
+	stream << "container,operations,ops_per_s,operation,count,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n";
+	for (auto const & result : _results) {
+		const std::pair<char const *, std::vector<double> const *> kinds[] = {
+			{ "create", &result.creates },
+			{ "work", &result.works },
+		};
+		for (auto const & kind : kinds) {
+			const std::vector<double> latencies = sorted(*kind.second);
+			stream << result.name << ',' << _operations.size() << ',' << std::setprecision(0)
+				<< static_cast<double>(_operations.size()) / result.seconds << ',' << kind.first << ','
+				<< latencies.size() << ',' << percentile(latencies, 0.5) << ',' << percentile(latencies, 0.9) << ','
+				<< percentile(latencies, 0.99) << ',' << percentile(latencies, 0.999) << ','
+				<< (latencies.empty() ? 0 : latencies.back()) << '\n';
+		}
+	}
+
+	stream << "\ncontainer,priority,worked,left,mean_wait_s,p50_wait_s,p99_wait_s,max_wait_s\n";
+	for (auto const & result : _results) {
+		for (std::size_t priority = 0; priority < Workload::Priorities; ++priority) {
+			const std::vector<double> waits = sorted(result.waits[priority]);
+			const double mean = waits.empty() ? 0 : std::accumulate(waits.cbegin(), waits.cend(), 0.0) / static_cast<double>(waits.size());
+			stream << result.name << ',' << TroubleTicket::Priority::name(static_cast<TroubleTicket::Priority::Type>(priority))
+				<< ',' << waits.size() << ',' << result.left[priority] << ',' << std::setprecision(3) << mean << ','
+				<< percentile(waits, 0.5) << ',' << percentile(waits, 0.99) << ',' << (waits.empty() ? 0 : waits.back()) << '\n';
+		}
+	}
+}
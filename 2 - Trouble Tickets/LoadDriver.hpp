@@ -0,0 +1,129 @@
+/**
+* File:		LoadDriver.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the scripted counterpart of simulateSession<T>: it plays a Workload's operations against a
+*			ticket container with no one at the keyboard. Creating pushes a copy of a new ticket and working takes a copy
+*			of the next ticket and pops it, as createTicket and workTicket do. Each container is run twice:
+*				-once straight through, timed as a whole, for throughput
+*				-once timing every operation, for latency percentiles, and noting how long each ticket waited, in the
+*				 workload's time, between being created and being worked
+*			The tickets are made before either run, so only the container's work is timed.
+*
+*			Usage:
+*				LoadDriver driver(Workload::fromSeed(7));
+*				driver.run<std::queue<TroubleTicket>>("queue");
+*				driver.run<BucketQueue>("bucket_queue");
+*				driver.report(std::cout);
+*/
+
+#ifndef LOAD_DRIVER_HPP
+#define LOAD_DRIVER_HPP
+
+// includes
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "TroubleTicket.hpp"
+#include "Workload.hpp"
+
+class LoadDriver {
+public:
+	explicit LoadDriver(Workload const & workload);
+
+	// play the workload against an empty container of type T, keeping the results under a name
+	template<class T>
+	void run(std::string const & name);
+
+	// a summary of the workload and, in CSV, the throughput and latencies of every container run, then the waits
+	// before each priority of ticket was worked
+	void report(std::ostream & stream) const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+	using Operation = Workload::Operation;
+
+	struct Result {
+		std::string										name;
+		double											seconds = 0;		// of the whole run
+		std::vector<double>								creates;			// nanoseconds each
+		std::vector<double>								works;
+		std::size_t										idle = 0;			// works that found the container empty
+		std::array<std::vector<double>, Workload::Priorities>	waits;		// seconds of workload time each
+		std::array<std::size_t, Workload::Priorities>	left{};				// still in the container at the end
+	};
+
+	// the next ticket to work, whichever end of the container that is
+	template<class T>
+	static TroubleTicket const & peek(T & container) { return container.top(); }
+	static TroubleTicket const & peek(std::queue<TroubleTicket> & container) { return container.front(); }
+
+	static double nanoseconds(Clock::time_point start, Clock::time_point stop) {
+		return std::chrono::duration<double, std::nano>(stop - start).count();
+	}
+
+	std::vector<Operation>						_operations;
+	std::vector<TroubleTicket>					_tickets;			// one for each create, in order
+	std::unordered_map<unsigned long, double>	_created;			// time each ticket was created, by number
+	std::vector<Result>							_results;
+};
+
+template<class T>
+void LoadDriver::run(std::string const & name) {
+	Result result;
+	result.name = name;
+
+	// straight through
+	{
+		T container;
+		auto ticket = _tickets.cbegin();
+		const auto start = Clock::now();
+		for (auto const & operation : _operations) {
+			if (operation.kind == Operation::CREATE) {
+				container.push(*ticket++);
+			}
+			else if (container.size() > 0) {
+				const TroubleTicket worked = peek(container);
+				container.pop();
+			}
+		}
+		result.seconds = nanoseconds(start, Clock::now()) / 1e9;
+	}
+
+	// one operation at a time
+	T container;
+	auto ticket = _tickets.cbegin();
+	for (auto const & operation : _operations) {
+		if (operation.kind == Operation::CREATE) {
+			const auto start = Clock::now();
+			container.push(*ticket++);
+			result.creates.push_back(nanoseconds(start, Clock::now()));
+		}
+		else if (container.size() > 0) {
+			const auto start = Clock::now();
+			const TroubleTicket worked = peek(container);
+			container.pop();
+			result.works.push_back(nanoseconds(start, Clock::now()));
+
+			result.waits[worked.priority()].push_back(operation.time - _created.at(worked.ticketNumber()));
+		}
+		else {
+			++result.idle;
+		}
+	}
+	while (container.size() > 0) {
+		++result.left[peek(container).priority()];
+		container.pop();
+	}
+
+	_results.push_back(std::move(result));
+}
+
+#endif
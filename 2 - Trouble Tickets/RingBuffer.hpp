@@ -0,0 +1,133 @@
+/**
+* File:		RingBuffer.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a first in, first out queue kept in one circular array. Pushing and popping only move an
+*			index, and the array doubles when it fills, so both are O(1) (amortized for push) and nothing is shifted or
+*			allocated per element the way std::deque allocates its blocks. Elements are constructed in place in raw
+*			storage, so the element type needs no default constructor (constructing a TroubleTicket uses up a ticket
+*			number).
+*
+*			Usage:
+*				RingBuffer<TroubleTicket> ring;
+*				ring.push_back(ticket);
+*				ring.front();
+*				ring.pop_front();
+*/
+
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+// includes
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+template<class T>
+class RingBuffer {
+public:
+	RingBuffer() = default;
+
+	RingBuffer(RingBuffer const & other) {
+		reserve(other._size);
+		for (std::size_t i = 0; i < other._size; ++i) {
+			push_back(other[i]);
+		}
+	}
+
+	RingBuffer(RingBuffer && other) noexcept
+		: _data(other._data), _capacity(other._capacity), _head(other._head), _size(other._size) {
+		other._data = nullptr;
+		other._capacity = other._head = other._size = 0;
+	}
+
+	// copy-and-swap, as Document does
+	RingBuffer & operator=(RingBuffer other) noexcept {
+		swap(other);
+		return *this;
+	}
+
+	~RingBuffer() noexcept {
+		clear();
+		std::allocator<T>().deallocate(_data, _capacity);
+	}
+
+	void swap(RingBuffer & other) noexcept {
+		std::swap(_data, other._data);
+		std::swap(_capacity, other._capacity);
+		std::swap(_head, other._head);
+		std::swap(_size, other._size);
+	}
+
+	std::size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	// the element i places from the front
+	T const & operator[](std::size_t i) const { return _data[(_head + i) & (_capacity - 1)]; }
+	T & operator[](std::size_t i) { return _data[(_head + i) & (_capacity - 1)]; }
+
+	T const & front() const { return _data[_head]; }
+	T & front() { return _data[_head]; }
+
+	template<class... Args>
+	void emplace_back(Args &&... args) {
+		if (_size == _capacity) {
+			reserve(_capacity == 0 ? InitialCapacity : _capacity * 2);
+		}
+		::new (static_cast<void *>(_data + ((_head + _size) & (_capacity - 1)))) T(std::forward<Args>(args)...);
+		++_size;
+	}
+
+	void push_back(T const & value) { emplace_back(value); }
+	void push_back(T && value) { emplace_back(std::move(value)); }
+
+	void pop_front() {
+		_data[_head].~T();
+		_head = (_head + 1) & (_capacity - 1);
+		--_size;
+	}
+
+	void clear() {
+		while (_size > 0) {
+			pop_front();
+		}
+		_head = 0;
+	}
+
+	// make room for at least count elements. The capacity stays a power of two so positions wrap with a mask
+	void reserve(std::size_t count) {
+		if (count <= _capacity) {
+			return;
+		}
+		std::size_t capacity = _capacity == 0 ? InitialCapacity : _capacity;
+		while (capacity < count) {
+			capacity *= 2;
+		}
+
+		T * data = std::allocator<T>().allocate(capacity);
+		for (std::size_t i = 0; i < _size; ++i) {
+			T & element = (*this)[i];
+			::new (static_cast<void *>(data + i)) T(std::move(element));
+			element.~T();
+		}
+		std::allocator<T>().deallocate(_data, _capacity);
+
+		_data = data;
+		_capacity = capacity;
+		_head = 0;
+	}
+
+private:
+	static constexpr std::size_t InitialCapacity = 16;
+
+	T *				_data = nullptr;
+	std::size_t		_capacity = 0;			// zero or a power of two
+	std::size_t		_head = 0;				// position of the front element
+	std::size_t		_size = 0;
+};
+
+template<class T>
+constexpr std::size_t RingBuffer<T>::InitialCapacity;
+
+#endif
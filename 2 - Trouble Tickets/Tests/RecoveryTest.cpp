@@ -0,0 +1,244 @@
+/**
+* File:		RecoveryTest.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Checks that a DurableStore opened again holds exactly the tickets it held when it was closed, or, after a
+*			crash, when the last whole change was made. A random run of changes (tickets pushed, worked and cancelled,
+*			statuses, priorities and resolutions changed) is made to a DurableStore and to a plain TicketStore, and
+*			the store recovered from the directory is compared with the plain one ticket by ticket:
+*				-snapshot_and_tail		snapshots every 64 changes, so recovery reads a snapshot and replays the
+*										journal after it
+*				-torn_tail				the last journal record is cut short, as a crash in the middle of writing it
+*										would; it's left out, and the journal is cut back so changes after it are kept
+*				-snapshot_not_cleared	the journal still holds the records a snapshot took over, as a crash between
+*										renaming the snapshot into place and emptying the journal would leave it
+*			Each then makes more changes to the recovered store and checks it recovers again. Fails, with a line for
+*			each difference, if any scenario doesn't recover.
+*
+*			Built and run with the other checks:
+*				make test
+*/
+
+#include "DurableStore.hpp"
+#include "TicketStore.hpp"
+#include "TroubleTicket.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	const std::filesystem::path Directory = std::filesystem::temp_directory_path() / "RecoveryTest";
+	const std::filesystem::path Journal = Directory / "journal.wal";
+
+	constexpr std::size_t Never = std::numeric_limits<std::size_t>::max();
+
+	// one change, made the same way to either kind of store
+	struct Step {
+		enum Kind { PUSH, POP, STATUS, PRIORITY, RESOLUTION, CANCEL };
+
+		Kind				kind;
+		TroubleTicket		ticket;		// PUSH
+		unsigned long		number;		// of the ticket changed
+		int					value;		// STATUS and PRIORITY
+		std::string			resolution;	// RESOLUTION
+	};
+
+	// a run of changes, each to a ticket that's held when it's made. The tickets pushed are numbered when the run is
+	// made, so every store gets the same numbers
+	std::vector<Step> makeSteps(std::size_t count, unsigned seed) {
+		std::mt19937 random(seed);
+		TicketStore held;
+		std::vector<Step> steps;
+		steps.reserve(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			const unsigned pick = held.empty() ? 0 : random() % 100;
+			if (pick < 40) {
+				const auto priority = static_cast<TroubleTicket::Priority::Type>(random() % (TroubleTicket::Priority::CRITICAL + 1));
+				steps.push_back(Step{ Step::PUSH, TroubleTicket("ticket " + std::to_string(i), priority), 0, 0, "" });
+				held.push(steps.back().ticket);
+				continue;
+			}
+
+			const std::vector<TroubleTicket const *> tickets = held.in_work_order();
+			const unsigned long number = tickets[random() % tickets.size()]->ticketNumber();
+			Step step{ Step::POP, TroubleTicket::restored(0, "", TroubleTicket::Priority::NONE, TroubleTicket::Status::NEW, ""), number, 0, "" };
+			if (pick < 50) {
+				step.number = held.top().ticketNumber();
+				held.pop();
+			}
+			else if (pick < 65) {
+				step.kind = Step::STATUS;
+				step.value = static_cast<int>(random() % (TroubleTicket::Status::HOLD + 1));
+				held.update_status(number, static_cast<TroubleTicket::Status::Type>(step.value));
+			}
+			else if (pick < 80) {
+				step.kind = Step::PRIORITY;
+				step.value = static_cast<int>(random() % (TroubleTicket::Priority::CRITICAL + 1));
+				held.reprioritize(number, static_cast<TroubleTicket::Priority::Type>(step.value));
+			}
+			else if (pick < 90) {
+				step.kind = Step::RESOLUTION;
+				step.resolution = "resolved in step " + std::to_string(i);
+				held.update_resolution(number, step.resolution);
+			}
+			else {
+				step.kind = Step::CANCEL;
+				held.cancel(number);
+			}
+			steps.push_back(std::move(step));
+		}
+		return steps;
+	}
+
+	template<class Store>
+	void apply(Store & store, std::vector<Step> const & steps, std::size_t from, std::size_t to) {
+		for (std::size_t i = from; i < to; ++i) {
+			Step const & step = steps[i];
+			switch (step.kind) {
+			case Step::PUSH:		store.push(step.ticket); break;
+			case Step::POP:			store.pop(); break;
+			case Step::STATUS:		store.update_status(step.number, static_cast<TroubleTicket::Status::Type>(step.value)); break;
+			case Step::PRIORITY:	store.reprioritize(step.number, static_cast<TroubleTicket::Priority::Type>(step.value)); break;
+			case Step::RESOLUTION:	store.update_resolution(step.number, step.resolution); break;
+			case Step::CANCEL:		store.cancel(step.number); break;
+			}
+		}
+	}
+
+	// every ticket the same, and the same one next to be worked. Returns the number of differences, each reported
+	int compare(char const * scenario, TicketStore const & expected, DurableStore const & recovered) {
+		int differences = 0;
+		auto differ = [scenario, &differences](std::string const & what) {
+			std::cerr << scenario << ": " << what << '\n';
+			++differences;
+		};
+
+		if (recovered.size() != expected.size()) {
+			differ("recovered " + std::to_string(recovered.size()) + " tickets of " + std::to_string(expected.size()));
+		}
+		for (TroubleTicket const * ticket : expected.in_work_order()) {
+			TroubleTicket const * found = recovered.find(ticket->ticketNumber());
+			if (found == nullptr) {
+				differ("ticket " + std::to_string(ticket->ticketNumber()) + " is missing");
+			}
+			else if (found->description() != ticket->description() || found->priority() != ticket->priority()
+				|| found->status() != ticket->status() || found->resolution() != ticket->resolution()) {
+				differ("ticket " + std::to_string(ticket->ticketNumber()) + " is " + found->toString() + ", expected " + ticket->toString());
+			}
+		}
+		if (!expected.empty() && !recovered.empty() && recovered.top().ticketNumber() != expected.top().ticketNumber()) {
+			differ("ticket " + std::to_string(recovered.top().ticketNumber()) + " is next, expected "
+				+ std::to_string(expected.top().ticketNumber()));
+		}
+		return differences;
+	}
+
+	// recover and compare, then make the rest of the changes to both and check they're kept too
+	int carryOn(char const * scenario, TicketStore & expected, std::vector<Step> const & steps, std::size_t from, std::size_t snapshotEvery) {
+		int differences = 0;
+		{
+			DurableStore store(Directory, snapshotEvery);
+			differences += compare(scenario, expected, store);
+			apply(store, steps, from, steps.size());
+			store.commit();
+		}
+		apply(expected, steps, from, steps.size());
+
+		DurableStore store(Directory, snapshotEvery);
+		return differences + compare(scenario, expected, store);
+	}
+
+	int snapshotAndTail() {
+		std::filesystem::remove_all(Directory);
+		const std::vector<Step> steps = makeSteps(2000, 1);
+		TicketStore expected;
+		{
+			DurableStore store(Directory, 64);
+			apply(store, steps, 0, 1500);
+			store.commit();
+		}
+		apply(expected, steps, 0, 1500);
+
+		int differences = 0;
+		{
+			DurableStore store(Directory, 64);
+			if (store.recovery().snapshotTickets == 0 || store.recovery().journalRecords == 0) {
+				std::cerr << "snapshot_and_tail: recovered " << store.recovery().snapshotTickets << " tickets from the snapshot and "
+					<< store.recovery().journalRecords << " changes from the journal, expected some of each\n";
+				++differences;
+			}
+		}
+		return differences + carryOn("snapshot_and_tail", expected, steps, 1500, 64);
+	}
+
+	int tornTail() {
+		std::filesystem::remove_all(Directory);
+		const std::vector<Step> steps = makeSteps(1000, 2);
+		const TroubleTicket torn("torn", TroubleTicket::Priority::CRITICAL);
+		TicketStore expected;
+		{
+			DurableStore store(Directory, Never);
+			apply(store, steps, 0, 500);
+			store.push(torn);
+			store.commit();
+		}
+		apply(expected, steps, 0, 500);
+
+		std::filesystem::resize_file(Journal, std::filesystem::file_size(Journal) - 3);
+		return carryOn("torn_tail", expected, steps, 500, Never);
+	}
+
+	int snapshotNotCleared() {
+		std::filesystem::remove_all(Directory);
+		const std::vector<Step> steps = makeSteps(1000, 3);
+		const std::filesystem::path saved = Directory.string() + ".journal";
+		TicketStore expected;
+		{
+			DurableStore store(Directory, Never);
+			apply(store, steps, 0, 500);
+			store.commit();
+		}
+		apply(expected, steps, 0, 500);
+
+		std::filesystem::copy_file(Journal, saved, std::filesystem::copy_options::overwrite_existing);
+		{
+			DurableStore store(Directory, Never);
+			store.snapshot();
+		}
+		std::filesystem::copy_file(saved, Journal, std::filesystem::copy_options::overwrite_existing);
+		std::filesystem::remove(saved);
+
+		int differences = 0;
+		{
+			DurableStore store(Directory, Never);
+			if (store.recovery().journalRecords != 0) {
+				std::cerr << "snapshot_not_cleared: replayed " << store.recovery().journalRecords << " changes the snapshot already had\n";
+				++differences;
+			}
+		}
+		return differences + carryOn("snapshot_not_cleared", expected, steps, 500, Never);
+	}
+}
+
+int main() {
+	int differences = 0;
+	try {
+		differences += snapshotAndTail();
+		differences += tornTail();
+		differences += snapshotNotCleared();
+	}
+	catch (std::exception const & error) {
+		std::cerr << error.what() << '\n';
+		++differences;
+	}
+	std::filesystem::remove_all(Directory);
+
+	std::cout << (differences == 0 ? "RecoveryTest passed\n" : "RecoveryTest failed\n");
+	return differences == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/**
+* File:		TicketDispatcher.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Member function definitions for TicketDispatcher, the concurrent ticket dispatcher described in
+*			TicketDispatcher.hpp.
+*
+*			Waking works without a lock on the intake side. A worker about to sleep counts itself in _sleepers and then
+*			looks at every shard's size; intake stores a shard's size and then looks at _sleepers. Both are sequentially
+*			consistent, so at least one of them sees the other, and a worker never sleeps through a ticket. drain and the
+*			workers' worked counts pair up the same way.
+*/
+
+#include "TicketDispatcher.hpp"
+
+#include <algorithm>
+#include <utility>
+
+constexpr std::size_t TicketDispatcher::Batch;
+
+// make the shards and start a thread on each
+TicketDispatcher::TicketDispatcher(std::size_t workers, Handler handler)
+	: _count(workers > 0 ? workers : std::max(std::thread::hardware_concurrency(), 1U)),
+	_handler(std::move(handler)),
+	_shards(new Shard[_count]) {
+	_threads.reserve(_count);
+	try {
+		for (std::size_t i = 0; i < _count; ++i) {
+			_threads.emplace_back(&TicketDispatcher::work, this, i);
+		}
+	}
+	catch (...) {
+		stop();
+		throw;
+	}
+}
+
+// work what's left, then join the workers
+TicketDispatcher::~TicketDispatcher() {
+	stop();
+}
+
+void TicketDispatcher::submit(TroubleTicket const & ticket) {
+	enqueue(ticket);
+}
+
+void TicketDispatcher::submit(TroubleTicket && ticket) {
+	enqueue(std::move(ticket));
+}
+
+// sleep until the worked counts catch up with the submitted counts
+void TicketDispatcher::drain() {
+	std::unique_lock<std::mutex> lock(_idle);
+	++_drainers;
+	_drained.wait(lock, [this] { return settled(); });
+	--_drainers;
+}
+
+// sum of the workers' counts
+std::size_t TicketDispatcher::worked() const {
+	std::size_t total = 0;
+	for (std::size_t i = 0; i < _count; ++i) {
+		total += _shards[i].worked.load();
+	}
+	return total;
+}
+
+std::size_t TicketDispatcher::stolen() const {
+	std::size_t total = 0;
+	for (std::size_t i = 0; i < _count; ++i) {
+		total += _shards[i].stolen.load();
+	}
+	return total;
+}
+
+// push to the next shard from this thread's place whose lock is free, waking a worker if any are asleep
+template<class Ticket>
+void TicketDispatcher::enqueue(Ticket && ticket) {
+	// each intake thread starts somewhere different and moves on one shard a ticket
+	thread_local std::size_t next = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+	std::size_t chosen = next++ % _count;
+	std::unique_lock<std::mutex> lock(_shards[chosen].mutex, std::try_to_lock);
+	for (std::size_t tried = 1; !lock.owns_lock() && tried < _count; ++tried) {
+		chosen = (chosen + 1) % _count;
+		lock = std::unique_lock<std::mutex>(_shards[chosen].mutex, std::try_to_lock);
+	}
+	if (!lock.owns_lock()) {
+		// every shard is busy: wait on the last one tried
+		lock.lock();
+	}
+
+	Shard & shard = _shards[chosen];
+	shard.queue.push(std::forward<Ticket>(ticket));
+	++shard.submitted;
+	shard.size = shard.queue.size();
+	lock.unlock();
+
+	if (_sleepers > 0) {
+		std::lock_guard<std::mutex> idle(_idle);
+		_wake.notify_one();
+	}
+}
+
+// a worker's loop: work the batch, refill it from its own queue or another's, and sleep when there's nothing anywhere
+void TicketDispatcher::work(std::size_t self) {
+	Shard & own = _shards[self];
+	RingBuffer<TroubleTicket> batch;
+
+	while (true) {
+		if (batch.empty() && !refill(self, batch)) {
+			std::unique_lock<std::mutex> lock(_idle);
+			++_sleepers;
+			_wake.wait(lock, [this] { return _closing || queued(); });
+			--_sleepers;
+			if (_closing && !queued()) {
+				return;
+			}
+			continue;
+		}
+
+		_handler(batch.front());
+		batch.pop_front();
+
+		++own.worked;
+		if (_drainers > 0) {
+			std::lock_guard<std::mutex> idle(_idle);
+			_drained.notify_all();
+		}
+	}
+}
+
+// take a batch from the worker's own queue, or else steal up to half of the first other queue holding tickets
+bool TicketDispatcher::refill(std::size_t self, RingBuffer<TroubleTicket> & batch) {
+	Shard & own = _shards[self];
+	if (own.size > 0 && take(own, Batch, batch) > 0) {
+		return true;
+	}
+
+	for (std::size_t i = 1; i < _count; ++i) {
+		Shard & victim = _shards[(self + i) % _count];
+		const std::size_t size = victim.size;
+		if (size == 0) {
+			continue;
+		}
+
+		const std::size_t taken = take(victim, std::min(Batch, (size + 1) / 2), batch);
+		if (taken > 0) {
+			own.stolen += taken;
+			return true;
+		}
+	}
+	return false;
+}
+
+// move up to most tickets, highest priority first, from a shard's queue to the end of a batch
+std::size_t TicketDispatcher::take(Shard & shard, std::size_t most, RingBuffer<TroubleTicket> & batch) {
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	std::size_t taken = 0;
+	for (; taken < most && !shard.queue.empty(); ++taken) {
+		batch.push_back(std::move(shard.queue.top()));
+		shard.queue.pop();
+	}
+	shard.size = shard.queue.size();
+	return taken;
+}
+
+// true if any shard holds a ticket no worker has taken
+bool TicketDispatcher::queued() const {
+	for (std::size_t i = 0; i < _count; ++i) {
+		if (_shards[i].size > 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// true if every ticket submitted has been worked. The worked counts are read first: each can only have grown by the
+// time the submitted counts are read, so equal sums mean nothing was in flight between the two
+bool TicketDispatcher::settled() const {
+	const std::size_t done = worked();
+	std::size_t submitted = 0;
+	for (std::size_t i = 0; i < _count; ++i) {
+		submitted += _shards[i].submitted.load();
+	}
+	return done == submitted;
+}
+
+// tell the workers to finish up and wait for them
+void TicketDispatcher::stop() {
+	{
+		std::lock_guard<std::mutex> lock(_idle);
+		_closing = true;
+	}
+	_wake.notify_all();
+	for (auto & thread : _threads) {
+		thread.join();
+	}
+}
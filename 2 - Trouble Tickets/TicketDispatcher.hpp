@@ -0,0 +1,102 @@
+/**
+* File:		TicketDispatcher.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a dispatcher that hands tickets submitted from any number of intake threads to a pool of
+*			worker threads. Each worker owns a BucketQueue behind its own mutex. Intake spreads tickets round robin over
+*			the workers' queues and skips a queue whose lock is held, so producers rarely wait on each other or on a
+*			worker. A worker takes a few tickets at a time from its own queue, highest priority first, and when that is
+*			empty steals from the others. Priority order holds within each queue; across queues it is approximate, as a
+*			worker finishes what it has taken before looking again.
+*
+*			Workers with nothing to do sleep until a ticket is submitted. The destructor works every ticket submitted
+*			before it, then stops the workers.
+*
+*			Usage:
+*				TicketDispatcher dispatcher(4, [](TroubleTicket & ticket) { ticket.status(TroubleTicket::Status::CLOSED); });
+*				dispatcher.submit(TroubleTicket("server down", TroubleTicket::Priority::CRITICAL));	// from any thread
+*				dispatcher.drain();		// wait until every ticket submitted so far has been worked
+*/
+
+#ifndef TICKET_DISPATCHER_HPP
+#define TICKET_DISPATCHER_HPP
+
+// includes
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BucketQueue.hpp"
+#include "RingBuffer.hpp"
+#include "TroubleTicket.hpp"
+
+class TicketDispatcher {
+public:
+	// called on a worker thread for each ticket. It must not throw
+	using Handler = std::function<void(TroubleTicket &)>;
+
+	// start a number of workers, or one for each hardware thread if it is zero
+	TicketDispatcher(std::size_t workers, Handler handler);
+	~TicketDispatcher();
+
+	TicketDispatcher(TicketDispatcher const &) = delete;
+	TicketDispatcher & operator=(TicketDispatcher const &) = delete;
+
+	// queue a ticket to be worked. Safe to call from any number of threads at once, but not after destruction begins
+	void submit(TroubleTicket const & ticket);
+	void submit(TroubleTicket && ticket);
+
+	// wait until every ticket submitted so far has been worked
+	void drain();
+
+	std::size_t workers() const { return _count; }
+
+	// tickets worked so far, and how many of them a worker stole from another's queue
+	std::size_t worked() const;
+	std::size_t stolen() const;
+
+private:
+	// tickets a worker takes from its own queue at once, and at most from another's
+	static constexpr std::size_t Batch = 8;
+
+	// one for each worker: its queue and its counts. Everything a ticket touches on the way through is here, so intake
+	// threads and workers using different shards share nothing
+	struct Shard {
+		std::mutex					mutex;
+		BucketQueue					queue;
+		std::atomic<std::size_t>	size{ 0 };			// queue.size(), readable without the lock
+		std::atomic<std::size_t>	submitted{ 0 };		// tickets pushed to this queue
+		std::atomic<std::size_t>	worked{ 0 };		// tickets this worker finished, from any queue
+		std::atomic<std::size_t>	stolen{ 0 };		// of them, taken from another's queue
+		char						padding[64];		// keeps neighbouring shards off each other's cache lines
+	};
+
+	template<class Ticket>
+	void enqueue(Ticket && ticket);
+	void work(std::size_t self);
+	bool refill(std::size_t self, RingBuffer<TroubleTicket> & batch);
+	std::size_t take(Shard & shard, std::size_t most, RingBuffer<TroubleTicket> & batch);
+	bool queued() const;
+	bool settled() const;
+	void stop();
+
+	const std::size_t				_count;
+	Handler							_handler;
+	std::unique_ptr<Shard[]>		_shards;
+	std::vector<std::thread>		_threads;
+
+	// the rest is only touched by workers with nothing to do, by drain, and by intake when a worker needs waking
+	std::atomic<std::size_t>		_sleepers{ 0 };		// workers waiting on _wake
+	std::atomic<std::size_t>		_drainers{ 0 };		// threads waiting on _drained
+	std::mutex						_idle;
+	std::condition_variable			_wake;
+	std::condition_variable			_drained;
+	bool							_closing = false;
+};
+
+#endif
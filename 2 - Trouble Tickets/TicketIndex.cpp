@@ -0,0 +1,229 @@
+/**
+* File:		TicketIndex.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Member function definitions for TicketIndex, the full-text index described in TicketIndex.hpp.
+*/
+
+#include "TicketIndex.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+	// stale postings tolerated before a sweep, however few live ones there are
+	constexpr std::size_t SweepAtLeast = 1 << 16;
+
+	// documents are mostly in the order their tickets were numbered, so the ids usually come out sorted already
+	std::vector<TicketIndex::Id> sorted(std::vector<TicketIndex::Id> ids) {
+		if (!std::is_sorted(ids.cbegin(), ids.cend())) {
+			std::sort(ids.begin(), ids.end());
+		}
+		return ids;
+	}
+}
+
+constexpr TicketIndex::TermId TicketIndex::Gap;
+
+// reuse the ticket's document if it has one, else a removed one, else a new one
+void TicketIndex::add(TroubleTicket const & ticket) {
+	std::uint32_t document;
+	auto found = _byId.find(ticket.ticketNumber());
+	if (found != _byId.end()) {
+		document = found->second;
+		retire(document);
+	}
+	else if (!_free.empty()) {
+		document = _free.back();
+		_free.pop_back();
+		_states[document].id = ticket.ticketNumber();
+		_byId.emplace(ticket.ticketNumber(), document);
+	}
+	else {
+		document = static_cast<std::uint32_t>(_documents.size());
+		_states.push_back(State{ ticket.ticketNumber(), 0, 0, 0 });
+		_documents.emplace_back();
+		_byId.emplace(ticket.ticketNumber(), document);
+	}
+
+	_states[document].status = static_cast<std::uint8_t>(ticket.status());
+	_states[document].priority = static_cast<std::uint8_t>(ticket.priority());
+	Document & indexed = _documents[document];
+	indexed.terms.clear();
+	append(indexed.terms, ticket.description());
+	indexed.descriptionLength = static_cast<std::uint32_t>(indexed.terms.size());
+	indexed.terms.push_back(Gap);
+	append(indexed.terms, ticket.resolution());
+	post(document);
+	sweep();
+}
+
+bool TicketIndex::update_status(Id id, TroubleTicket::Status::Type status) {
+	auto found = _byId.find(id);
+	if (found == _byId.end()) {
+		return false;
+	}
+	_states[found->second].status = static_cast<std::uint8_t>(status);
+	return true;
+}
+
+bool TicketIndex::update_priority(Id id, TroubleTicket::Priority::Type priority) {
+	auto found = _byId.find(id);
+	if (found == _byId.end()) {
+		return false;
+	}
+	_states[found->second].priority = static_cast<std::uint8_t>(priority);
+	return true;
+}
+
+// the description's terms are kept; all of them are posted again under the new generation
+bool TicketIndex::update_resolution(Id id, std::string_view resolution) {
+	auto found = _byId.find(id);
+	if (found == _byId.end()) {
+		return false;
+	}
+
+	Document & document = _documents[found->second];
+	retire(found->second);
+	document.terms.resize(document.descriptionLength + 1);
+	append(document.terms, resolution);
+	post(found->second);
+	sweep();
+	return true;
+}
+
+bool TicketIndex::remove(Id id) {
+	auto found = _byId.find(id);
+	if (found == _byId.end()) {
+		return false;
+	}
+
+	retire(found->second);
+	std::vector<TermId>().swap(_documents[found->second].terms);
+	_free.push_back(found->second);
+	_byId.erase(found);
+	sweep();
+	return true;
+}
+
+// a ticket's postings of one term are next to each other, so a repeat is always the one just taken
+std::vector<TicketIndex::Id> TicketIndex::with_term(std::string_view word, Filter const & filter) const {
+	std::vector<Id> ids;
+	TermId term = Gap;
+	tokenize(word, [this, &term](std::string const & found) {
+		if (term == Gap) {
+			term = lookup(found);
+		}
+	});
+	if (term == Gap) {
+		return ids;
+	}
+
+	std::uint32_t last = ~std::uint32_t(0);
+	for (auto const & posting : _postings[term]) {
+		if (posting.document == last || !live(posting)) {
+			continue;
+		}
+		last = posting.document;
+		State const & state = _states[posting.document];
+		if (filter.allows(static_cast<TroubleTicket::Status::Type>(state.status), static_cast<TroubleTicket::Priority::Type>(state.priority))) {
+			ids.push_back(state.id);
+		}
+	}
+	return sorted(std::move(ids));
+}
+
+// walk the rarest term's postings and line the phrase up against the terms around each one
+std::vector<TicketIndex::Id> TicketIndex::with_phrase(std::string_view text, Filter const & filter) const {
+	std::vector<Id> ids;
+	std::vector<TermId> phrase;
+	tokenize(text, [this, &phrase](std::string const & found) {
+		phrase.push_back(lookup(found));
+	});
+	if (phrase.empty() || std::find(phrase.cbegin(), phrase.cend(), Gap) != phrase.cend()) {
+		return ids;
+	}
+
+	std::size_t rarest = 0;
+	for (std::size_t i = 1; i < phrase.size(); ++i) {
+		if (_postings[phrase[i]].size() < _postings[phrase[rarest]].size()) {
+			rarest = i;
+		}
+	}
+
+	std::uint32_t last = ~std::uint32_t(0);
+	for (auto const & posting : _postings[phrase[rarest]]) {
+		if (posting.document == last || posting.position < rarest || !live(posting)) {
+			continue;
+		}
+		State const & state = _states[posting.document];
+		if (!filter.allows(static_cast<TroubleTicket::Status::Type>(state.status), static_cast<TroubleTicket::Priority::Type>(state.priority))) {
+			continue;
+		}
+		std::vector<TermId> const & terms = _documents[posting.document].terms;
+		const std::size_t start = posting.position - rarest;
+		if (start + phrase.size() > terms.size()
+			|| !std::equal(phrase.cbegin(), phrase.cend(), terms.cbegin() + static_cast<std::ptrdiff_t>(start))) {
+			continue;
+		}
+		last = posting.document;
+		ids.push_back(state.id);
+	}
+	return sorted(std::move(ids));
+}
+
+// the term's number, giving it one if it's new
+TicketIndex::TermId TicketIndex::intern(std::string const & term) {
+	auto found = _termIds.find(term);
+	if (found != _termIds.end()) {
+		return found->second;
+	}
+	const TermId id = static_cast<TermId>(_postings.size());
+	_termIds.emplace(term, id);
+	_postings.emplace_back();
+	return id;
+}
+
+// the term's number, or Gap if nothing has ever had it
+TicketIndex::TermId TicketIndex::lookup(std::string const & term) const {
+	auto found = _termIds.find(term);
+	return found == _termIds.end() ? Gap : found->second;
+}
+
+void TicketIndex::append(std::vector<TermId> & terms, std::string_view text) {
+	tokenize(text, [this, &terms](std::string const & term) {
+		terms.push_back(intern(term));
+	});
+}
+
+// post every term of a document under its current generation
+void TicketIndex::post(std::uint32_t document) {
+	std::vector<TermId> const & terms = _documents[document].terms;
+	const std::uint32_t generation = _states[document].generation;
+	for (std::size_t position = 0; position < terms.size(); ++position) {
+		if (terms[position] != Gap) {
+			_postings[terms[position]].push_back(Posting{ document, static_cast<std::uint32_t>(position), generation });
+			++_posted;
+		}
+	}
+}
+
+// make the document's postings stale
+void TicketIndex::retire(std::uint32_t document) {
+	std::vector<TermId> const & terms = _documents[document].terms;
+	++_states[document].generation;
+	_stale += terms.size() - static_cast<std::size_t>(std::count(terms.cbegin(), terms.cend(), Gap));
+}
+
+// once half the postings are stale, drop them all in one pass
+void TicketIndex::sweep() {
+	if (_stale < SweepAtLeast || _stale * 2 < _posted) {
+		return;
+	}
+	for (auto & postings : _postings) {
+		postings.erase(std::remove_if(postings.begin(), postings.end(), [this](Posting const & posting) { return !live(posting); }),
+			postings.end());
+	}
+	_posted -= _stale;
+	_stale = 0;
+}
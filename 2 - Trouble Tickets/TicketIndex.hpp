@@ -0,0 +1,152 @@
+/**
+* File:		TicketIndex.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a full-text index over the descriptions and resolutions of tickets, so triage can find the
+*			tickets that mention a host or an error code without scanning every one. Text is split into terms at anything
+*			that isn't a letter or a digit, and ASCII letters are lowered, so "DB-01.example.com" is the terms db 01 example
+*			com and the phrase query "db-01.example.com" finds it.
+*
+*			Each term has a posting list of where it occurs: the ticket and the position in its text. Each ticket keeps
+*			its text as a list of term numbers, with its status and priority. A term query walks one posting list; a
+*			phrase query walks the shortest posting list among its terms and checks the rest against each candidate's
+*			terms, so neither depends on how many tickets don't contain the rarest word. Both can be narrowed to
+*			statuses and priorities.
+*
+*			Changing a resolution or removing a ticket leaves its old postings behind, marked stale by the ticket's
+*			generation; once stale postings outnumber live ones they're swept out in one pass, so updates are O(length of
+*			the text) amortized. Tickets stay in the index after they're worked, until they're removed.
+*
+*			Usage:
+*				TicketIndex index;
+*				index.add(ticket);
+*				index.update_status(ticket.ticketNumber(), TroubleTicket::Status::CLOSED);
+*				index.with_term("e1234");
+*				index.with_phrase("db-01.example.com", TicketIndex::Filter().status(TroubleTicket::Status::OPEN));
+*/
+
+#ifndef TICKET_INDEX_HPP
+#define TICKET_INDEX_HPP
+
+// includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "TroubleTicket.hpp"
+
+class TicketIndex {
+public:
+	using Id = unsigned long;
+
+	// which tickets a query may return. Naming no status (or no priority) allows any
+	class Filter {
+	public:
+		Filter() : _statuses(0), _priorities(0) {}
+
+		Filter & status(TroubleTicket::Status::Type status) { _statuses |= 1U << status; return *this; }
+		Filter & priority(TroubleTicket::Priority::Type priority) { _priorities |= 1U << priority; return *this; }
+
+		bool allows(TroubleTicket::Status::Type status, TroubleTicket::Priority::Type priority) const {
+			return (_statuses == 0 || ((_statuses >> status) & 1U) != 0) && (_priorities == 0 || ((_priorities >> priority) & 1U) != 0);
+		}
+
+	private:
+		unsigned	_statuses;
+		unsigned	_priorities;
+	};
+
+	// index a ticket's description and resolution, replacing what was indexed for its number before.
+	// O(length of the text)
+	void add(TroubleTicket const & ticket);
+
+	// change what's indexed for a ticket. Each returns false if the ticket isn't indexed. Status and priority O(1),
+	// resolution O(length of the text)
+	bool update_status(Id id, TroubleTicket::Status::Type status);
+	bool update_priority(Id id, TroubleTicket::Priority::Type priority);
+	bool update_resolution(Id id, std::string_view resolution);
+
+	// take a ticket out of the index. Returns false if it isn't indexed
+	bool remove(Id id);
+
+	// the tickets whose description or resolution contains the word (the first term of it), in ticket number order.
+	// O(occurrences of the word)
+	std::vector<Id> with_term(std::string_view word, Filter const & filter = Filter()) const;
+
+	// the tickets whose description or resolution contains the terms of the text one after another, in ticket number
+	// order. A phrase doesn't run from a description into a resolution. O(occurrences of its rarest term)
+	std::vector<Id> with_phrase(std::string_view text, Filter const & filter = Filter()) const;
+
+	// tickets indexed
+	std::size_t size() const { return _byId.size(); }
+
+	// call found with each term of the text, in order, in a buffer reused between calls
+	template<typename Found>
+	static void tokenize(std::string_view text, Found found);
+
+private:
+	using TermId = std::uint32_t;
+
+	// between a description and a resolution, so no phrase matches across them
+	static constexpr TermId Gap = ~TermId(0);
+
+	struct Posting {
+		std::uint32_t	document;
+		std::uint32_t	position;
+		std::uint32_t	generation;		// the document's when posted; stale once it moves on
+	};
+
+	// what a query reads for every posting it walks, kept apart from the text so more of it stays in cache
+	struct State {
+		Id				id;
+		std::uint32_t	generation;
+		std::uint8_t	status;
+		std::uint8_t	priority;
+	};
+
+	struct Document {
+		std::uint32_t			descriptionLength;	// terms of the description, before the gap
+		std::vector<TermId>		terms;				// description, gap, resolution
+	};
+
+	TermId intern(std::string const & term);
+	TermId lookup(std::string const & term) const;
+	void append(std::vector<TermId> & terms, std::string_view text);
+	void post(std::uint32_t document);
+	void retire(std::uint32_t document);
+	void sweep();
+	bool live(Posting const & posting) const { return _states[posting.document].generation == posting.generation; }
+
+	std::unordered_map<std::string, TermId>		_termIds;
+	std::vector<std::vector<Posting>>			_postings;		// by term
+	std::vector<State>							_states;		// by document
+	std::vector<Document>						_documents;
+	std::vector<std::uint32_t>					_free;			// documents removed, to reuse
+	std::unordered_map<Id, std::uint32_t>		_byId;			// ticket number to document
+	std::size_t									_posted = 0;	// postings, live and stale
+	std::size_t									_stale = 0;
+};
+
+// runs of letters and digits, lowered; bytes from 0x80 up are kept as letters so UTF-8 words stay whole
+template<typename Found>
+void TicketIndex::tokenize(std::string_view text, Found found) {
+	std::string term;
+	for (std::size_t i = 0; i <= text.size(); ++i) {
+		const unsigned char c = i < text.size() ? static_cast<unsigned char>(text[i]) : ' ';
+		if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80) {
+			term += static_cast<char>(c);
+		}
+		else if (c >= 'A' && c <= 'Z') {
+			term += static_cast<char>(c - 'A' + 'a');
+		}
+		else if (!term.empty()) {
+			found(term);
+			term.clear();
+		}
+	}
+}
+
+#endif
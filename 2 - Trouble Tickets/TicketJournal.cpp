@@ -0,0 +1,212 @@
+/**
+* File:		TicketJournal.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Member function definitions for TicketJournal, the write-ahead log described in TicketJournal.hpp.
+*/
+
+#include "TicketJournal.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "BinaryCodec.hpp"
+
+namespace {
+	// the length and the checksum in front of each body
+	constexpr std::size_t HeaderSize = 2 * sizeof(std::uint32_t);
+}
+
+// cut off any torn record and start the writer
+TicketJournal::TicketJournal(std::filesystem::path const & path, Sequence next, std::uint64_t length, std::chrono::milliseconds interval)
+	: _file(path), _interval(interval), _next(next), _durable(next - 1) {
+	_file.truncate(length);
+	_file.sync();
+	_writer = std::thread(&TicketJournal::run, this);
+}
+
+TicketJournal::~TicketJournal() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_closing = true;
+	}
+	_ready.notify_one();
+	_writer.join();
+}
+
+TicketJournal::Sequence TicketJournal::created(TroubleTicket const & ticket) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	const std::size_t start = begin(CREATE, ticket.ticketNumber());
+	Binary::put<std::uint8_t>(_pending, static_cast<std::uint8_t>(ticket.priority()));
+	Binary::put<std::uint8_t>(_pending, static_cast<std::uint8_t>(ticket.status()));
+	Binary::putText(_pending, ticket.description());
+	Binary::putText(_pending, ticket.resolution());
+	return finish(start);
+}
+
+TicketJournal::Sequence TicketJournal::statusChanged(unsigned long number, TroubleTicket::Status::Type status) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	const std::size_t start = begin(STATUS, number);
+	Binary::put<std::uint8_t>(_pending, static_cast<std::uint8_t>(status));
+	return finish(start);
+}
+
+TicketJournal::Sequence TicketJournal::reprioritized(unsigned long number, TroubleTicket::Priority::Type priority) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	const std::size_t start = begin(PRIORITY, number);
+	Binary::put<std::uint8_t>(_pending, static_cast<std::uint8_t>(priority));
+	return finish(start);
+}
+
+TicketJournal::Sequence TicketJournal::resolved(unsigned long number, std::string_view resolution) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	const std::size_t start = begin(RESOLUTION, number);
+	Binary::putText(_pending, resolution);
+	return finish(start);
+}
+
+TicketJournal::Sequence TicketJournal::removed(unsigned long number) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return finish(begin(REMOVE, number));
+}
+
+// ask the writer to go now, and wait for it to get past this point
+void TicketJournal::commit() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	const Sequence target = _next - 1;
+	_wanted = std::max(_wanted, target);
+	_ready.notify_one();
+	_committed.wait(lock, [this, target] { return _durable >= target || _error; });
+	if (_error) {
+		std::rethrow_exception(_error);
+	}
+}
+
+// with everything committed the writer has nothing in hand, so the file can be cut under the lock
+void TicketJournal::clear() {
+	commit();
+	std::lock_guard<std::mutex> lock(_mutex);
+	_file.truncate(0);
+	_file.sync();
+}
+
+TicketJournal::Sequence TicketJournal::last() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _next - 1;
+}
+
+// map the file and read records until one is short, fails its checksum or doesn't make sense
+std::uint64_t TicketJournal::replay(std::filesystem::path const & path, std::function<void(Record const &)> const & apply) {
+	const MappedFile file(path);
+	const std::string_view bytes = file.view();
+
+	std::size_t good = 0;
+	while (bytes.size() - good >= HeaderSize) {
+		Binary::Reader header(bytes.substr(good, HeaderSize));
+		const std::uint32_t size = header.get<std::uint32_t>();
+		const std::uint32_t checksum = header.get<std::uint32_t>();
+		if (bytes.size() - good - HeaderSize < size) {
+			break;
+		}
+		const std::string_view body = bytes.substr(good + HeaderSize, size);
+		if (Binary::checksum(body) != checksum) {
+			break;
+		}
+
+		Binary::Reader in(body);
+		Record record{};
+		record.sequence = in.get<std::uint64_t>();
+		record.kind = static_cast<Kind>(in.get<std::uint8_t>());
+		record.number = static_cast<unsigned long>(in.get<std::uint64_t>());
+		switch (record.kind) {
+		case CREATE:
+			record.priority = static_cast<TroubleTicket::Priority::Type>(in.get<std::uint8_t>());
+			record.status = static_cast<TroubleTicket::Status::Type>(in.get<std::uint8_t>());
+			record.description = in.getText();
+			record.resolution = in.getText();
+			break;
+		case STATUS:
+			record.status = static_cast<TroubleTicket::Status::Type>(in.get<std::uint8_t>());
+			break;
+		case PRIORITY:
+			record.priority = static_cast<TroubleTicket::Priority::Type>(in.get<std::uint8_t>());
+			break;
+		case RESOLUTION:
+			record.resolution = in.getText();
+			break;
+		case REMOVE:
+			break;
+		default:
+			return good;
+		}
+		if (in.overrun() || in.remaining() != 0 || record.priority > TroubleTicket::Priority::CRITICAL
+			|| record.status > TroubleTicket::Status::HOLD) {
+			break;
+		}
+
+		apply(record);
+		good += HeaderSize + size;
+	}
+	return good;
+}
+
+// room for the header, then the body every record starts with. Nothing more is taken once the writer has failed
+std::size_t TicketJournal::begin(Kind kind, unsigned long number) {
+	if (_error) {
+		std::rethrow_exception(_error);
+	}
+	const std::size_t start = _pending.size();
+	_pending.append(HeaderSize, '\0');
+	Binary::put<std::uint64_t>(_pending, _next);
+	Binary::put<std::uint8_t>(_pending, kind);
+	Binary::put<std::uint64_t>(_pending, number);
+	return start;
+}
+
+// fill in the header now the body's length is known
+TicketJournal::Sequence TicketJournal::finish(std::size_t start) {
+	const std::string_view body = std::string_view(_pending).substr(start + HeaderSize);
+	Binary::store<std::uint32_t>(&_pending[start], static_cast<std::uint32_t>(body.size()));
+	Binary::store<std::uint32_t>(&_pending[start + sizeof(std::uint32_t)], Binary::checksum(body));
+	return _next++;
+}
+
+// the writer's loop: wait for a commit or the interval, then write and sync everything appended in one go
+void TicketJournal::run() {
+	std::string writing;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_ready.wait_for(lock, _interval, [this] { return _closing || (_wanted > _durable && !_error); });
+
+		if (!_pending.empty() && !_error) {
+			writing.swap(_pending);
+			const Sequence last = _next - 1;
+			lock.unlock();
+
+			std::exception_ptr error;
+			try {
+				_file.write(writing.data(), writing.size());
+				_file.sync();
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+			writing.clear();
+
+			lock.lock();
+			if (error) {
+				// what was appended while this write failed can't be written either
+				_error = error;
+				std::string().swap(_pending);
+			}
+			else {
+				_durable = last;
+			}
+			_committed.notify_all();
+		}
+		else if (_closing) {
+			return;
+		}
+	}
+}
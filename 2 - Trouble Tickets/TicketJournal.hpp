@@ -0,0 +1,112 @@
+/**
+* File:		TicketJournal.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the write-ahead log of DurableStore: one record for every change made to the tickets,
+*			appended to a file before the change is relied on. Appending only copies the record into memory; a writer
+*			thread writes everything appended since it last went and syncs it with one call, every few milliseconds or
+*			as soon as someone is waiting in commit(), so a burst of changes costs one sync instead of one each (group
+*			commit).
+*
+*			Each record is its length, a checksum, and then the body: a sequence number, the kind of change, the ticket
+*			number and whatever the change needs. A crash can leave the last record half written; replay stops at the
+*			first record that doesn't check out, and the journal is cut back to there when it is next opened.
+*
+*			If a write or a sync fails, the writer stops: commit() and every append after it throw what it hit, and the
+*			records it couldn't write are dropped rather than kept piling up.
+*
+*			Usage:
+*				std::uint64_t length = TicketJournal::replay(path, apply);
+*				TicketJournal journal(path, next, length);
+*				journal.created(ticket);
+*				journal.commit();		// wait until it's on storage
+*/
+
+#ifndef TICKET_JOURNAL_HPP
+#define TICKET_JOURNAL_HPP
+
+// includes
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "DurableFile.hpp"
+#include "TroubleTicket.hpp"
+
+class TicketJournal {
+public:
+	using Sequence = std::uint64_t;
+
+	enum Kind : std::uint8_t { CREATE = 1, STATUS, PRIORITY, RESOLUTION, REMOVE };
+
+	// one change, as read back. The text points into the journal being replayed
+	struct Record {
+		Sequence						sequence;
+		Kind							kind;
+		unsigned long					number;			// of the ticket changed
+		TroubleTicket::Priority::Type	priority;		// CREATE and PRIORITY
+		TroubleTicket::Status::Type		status;			// CREATE and STATUS
+		std::string_view				description;	// CREATE
+		std::string_view				resolution;		// CREATE and RESOLUTION
+	};
+
+	// append to a journal file, numbering records from next. Whatever is past length, where replay found the whole
+	// records end, is cut off first
+	TicketJournal(std::filesystem::path const & path, Sequence next, std::uint64_t length, std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+	// commits everything appended, unless the writer has failed; commit() first to find out
+	~TicketJournal();
+
+	TicketJournal(TicketJournal const &) = delete;
+	TicketJournal & operator=(TicketJournal const &) = delete;
+
+	// append a record of a change, returning its sequence number. Throws what the writer hit if it has failed
+	Sequence created(TroubleTicket const & ticket);
+	Sequence statusChanged(unsigned long number, TroubleTicket::Status::Type status);
+	Sequence reprioritized(unsigned long number, TroubleTicket::Priority::Type priority);
+	Sequence resolved(unsigned long number, std::string_view resolution);
+	Sequence removed(unsigned long number);
+
+	// wait until every record appended so far is on storage. Throws what the writer hit if it failed
+	void commit();
+
+	// commit, then empty the file, once a snapshot holds everything in it
+	void clear();
+
+	// sequence number of the last record appended
+	Sequence last() const;
+
+	// call apply with every whole record of a journal file in order, and return the length they take up. A file that
+	// isn't there has none
+	static std::uint64_t replay(std::filesystem::path const & path, std::function<void(Record const &)> const & apply);
+
+private:
+	// start a record in _pending, returning where it starts, and finish it once the body is written
+	std::size_t begin(Kind kind, unsigned long number);
+	Sequence finish(std::size_t start);
+	void run();
+
+	DurableFile						_file;
+	const std::chrono::milliseconds	_interval;
+
+	mutable std::mutex				_mutex;
+	std::condition_variable			_ready;			// the writer waits on this for a commit or closing
+	std::condition_variable			_committed;		// commit waits on this for the writer
+	std::string						_pending;		// appended and not yet taken by the writer
+	Sequence						_next;			// of the next record appended
+	Sequence						_wanted = 0;	// last record a commit is waiting for
+	Sequence						_durable;		// last record on storage
+	std::exception_ptr				_error;			// what stopped the writer
+	bool							_closing = false;
+
+	std::thread						_writer;		// last, so it starts after everything it uses
+};
+
+#endif
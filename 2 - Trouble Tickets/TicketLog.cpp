@@ -0,0 +1,88 @@
+/**
+* File:		TicketLog.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Member function definitions for TicketLog, the asynchronous ticket log described in TicketLog.hpp.
+*/
+
+#include "TicketLog.hpp"
+
+#include <algorithm>
+
+// reserve the batch and start the writer
+TicketLog::TicketLog(std::ostream & stream, std::chrono::milliseconds interval, std::size_t batchSize)
+	: _stream(stream), _interval(interval), _batchSize(std::max<std::size_t>(batchSize, 1)) {
+	_pending.reserve(_batchSize);
+	_writer = std::thread(&TicketLog::run, this);
+}
+
+// write what's left and stop the writer
+TicketLog::~TicketLog() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_closing = true;
+	}
+	_ready.notify_one();
+	_writer.join();
+}
+
+// format straight into the batch, waking the writer if it has filled
+void TicketLog::record(std::string_view event, TroubleTicket const & ticket) {
+	const std::size_t size = event.size() + 2 + ticket.formatted_size() + 1;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	const std::size_t before = _pending.size();
+	_pending.resize(before + size);
+
+	char * out = std::copy(event.begin(), event.end(), &_pending[before]);
+	*out++ = ':';
+	*out++ = ' ';
+	out = ticket.format_to(out);
+	*out = '\n';
+	_recorded += size;
+
+	const bool full = _pending.size() >= _batchSize;
+	lock.unlock();
+	if (full) {
+		_ready.notify_one();
+	}
+}
+
+// ask the writer to go now, and wait for it to get past this point
+void TicketLog::flush() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	const unsigned long long target = _recorded;
+	_wanted = std::max(_wanted, target);
+	_ready.notify_one();
+	_written.wait(lock, [this, target] { return _flushed >= target; });
+}
+
+// the writer's loop: wait for a reason to write, swap the batch for the empty one and write it without the lock
+void TicketLog::run() {
+	std::string writing;
+	writing.reserve(_batchSize);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_ready.wait_for(lock, _interval, [this] {
+			return _closing || _pending.size() >= _batchSize || _wanted > _flushed;
+		});
+
+		if (!_pending.empty()) {
+			writing.swap(_pending);
+			const std::size_t size = writing.size();
+			lock.unlock();
+
+			_stream.write(writing.data(), static_cast<std::streamsize>(writing.size()));
+			_stream.flush();
+			writing.clear();
+
+			lock.lock();
+			_flushed += size;
+			_written.notify_all();
+		}
+		else if (_closing) {
+			return;
+		}
+	}
+}
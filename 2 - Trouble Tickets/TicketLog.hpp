@@ -0,0 +1,69 @@
+/**
+* File:		TicketLog.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains an asynchronous, batched log of ticket events. record() formats the event into an in memory
+*			batch with TroubleTicket::format_to and returns; a writer thread swaps the batch out and writes it to the
+*			stream in one call, once the batch is large or a short interval has passed. The two batches keep their
+*			capacity when they are cleared, so once they have grown to the busiest interval's size logging allocates
+*			nothing, and the thread recording never waits on the stream.
+*
+*			Everything recorded is written by flush() or the destructor. The stream must not be written by anything else
+*			while the log is using it, apart from through the standard streams' own synchronization.
+*
+*			Usage:
+*				TicketLog log(std::clog);
+*				log.record("Inserted", ticket);		// from any thread
+*				log.flush();						// wait until everything recorded so far is written
+*/
+
+#ifndef TICKET_LOG_HPP
+#define TICKET_LOG_HPP
+
+// includes
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "TroubleTicket.hpp"
+
+class TicketLog {
+public:
+	// write to a stream at least every interval, or as soon as a batch reaches batchSize characters
+	explicit TicketLog(std::ostream & stream, std::chrono::milliseconds interval = std::chrono::milliseconds(50), std::size_t batchSize = 64 * 1024);
+	~TicketLog();
+
+	TicketLog(TicketLog const &) = delete;
+	TicketLog & operator=(TicketLog const &) = delete;
+
+	// add "<event>: <ticket>\n" to the batch, the text operator<< writes for the ticket
+	void record(std::string_view event, TroubleTicket const & ticket);
+
+	// wait until everything recorded before the call has been written to the stream
+	void flush();
+
+private:
+	void run();
+
+	std::ostream &					_stream;
+	const std::chrono::milliseconds	_interval;
+	const std::size_t				_batchSize;
+
+	std::mutex						_mutex;
+	std::condition_variable			_ready;			// the writer waits on this for a full batch, a flush or closing
+	std::condition_variable			_written;		// flush waits on this for the writer
+	std::string						_pending;		// recorded and not yet taken by the writer
+	unsigned long long				_recorded = 0;	// characters recorded, ever
+	unsigned long long				_flushed = 0;	// characters written, ever
+	unsigned long long				_wanted = 0;	// characters a flush is waiting for
+	bool							_closing = false;
+
+	std::thread						_writer;		// last, so it starts after everything it uses
+};
+
+#endif
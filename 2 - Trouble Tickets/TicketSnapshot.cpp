@@ -0,0 +1,110 @@
+/**
+* File:		TicketSnapshot.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Function definitions for the DurableStore snapshots described in TicketSnapshot.hpp.
+*/
+
+#include "TicketSnapshot.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "BinaryCodec.hpp"
+#include "DurableFile.hpp"
+
+namespace {
+	constexpr std::string_view Magic = "TKTSNAP1";
+
+	// bytes gathered before each write
+	constexpr std::size_t ChunkSize = std::size_t(1) << 20;
+
+	[[noreturn]] void damaged(std::filesystem::path const & path) {
+		throw std::runtime_error("damaged ticket snapshot " + path.string());
+	}
+}
+
+// gather the file a chunk at a time into a temporary file, keeping the checksum going, then put it in place
+void TicketSnapshot::write(std::filesystem::path const & path, Header const & header, std::vector<TroubleTicket const *> const & tickets) {
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+
+	{
+		DurableFile file(temporary, true);
+		std::uint32_t checksum = Binary::checksum(std::string_view());
+		std::string chunk;
+		chunk.reserve(ChunkSize);
+
+		const auto send = [&file, &checksum, &chunk] {
+			checksum = Binary::checksum(chunk, checksum);
+			file.write(chunk.data(), chunk.size());
+			chunk.clear();
+		};
+
+		chunk.append(Magic.data(), Magic.size());
+		Binary::put<std::uint64_t>(chunk, header.sequence);
+		Binary::put<std::uint64_t>(chunk, header.lastNumber);
+		Binary::put<std::uint64_t>(chunk, tickets.size());
+		for (auto ticket : tickets) {
+			Binary::put<std::uint64_t>(chunk, ticket->ticketNumber());
+			Binary::put<std::uint8_t>(chunk, static_cast<std::uint8_t>(ticket->priority()));
+			Binary::put<std::uint8_t>(chunk, static_cast<std::uint8_t>(ticket->status()));
+			Binary::putText(chunk, ticket->description());
+			Binary::putText(chunk, ticket->resolution());
+			if (chunk.size() >= ChunkSize) {
+				send();
+			}
+		}
+		send();
+
+		Binary::put<std::uint32_t>(chunk, checksum);
+		file.write(chunk.data(), chunk.size());
+		file.sync();
+	}
+
+	std::filesystem::rename(temporary, path);
+	DurableFile::syncDirectory(path.parent_path().empty() ? std::filesystem::path(".") : path.parent_path());
+}
+
+// check the whole file first, so a damaged snapshot restores nothing
+TicketSnapshot::Header TicketSnapshot::read(std::filesystem::path const & path, std::function<void(TroubleTicket &&)> const & restore) {
+	const MappedFile file(path);
+	if (!file.exists()) {
+		return Header();
+	}
+
+	const std::string_view bytes = file.view();
+	const std::size_t fixed = Magic.size() + 3 * sizeof(std::uint64_t) + sizeof(std::uint32_t);
+	if (bytes.size() < fixed || bytes.substr(0, Magic.size()) != Magic) {
+		damaged(path);
+	}
+	const std::string_view body = bytes.substr(0, bytes.size() - sizeof(std::uint32_t));
+	if (Binary::Reader(bytes.substr(body.size())).get<std::uint32_t>() != Binary::checksum(body)) {
+		damaged(path);
+	}
+
+	Binary::Reader in(body.substr(Magic.size()));
+	Header header;
+	header.sequence = in.get<std::uint64_t>();
+	header.lastNumber = static_cast<unsigned long>(in.get<std::uint64_t>());
+	header.count = in.get<std::uint64_t>();
+
+	for (std::uint64_t i = 0; i < header.count; ++i) {
+		const unsigned long number = static_cast<unsigned long>(in.get<std::uint64_t>());
+		const unsigned priority = in.get<std::uint8_t>();
+		const unsigned status = in.get<std::uint8_t>();
+		const std::string_view description = in.getText();
+		const std::string_view resolution = in.getText();
+		if (in.overrun() || priority > TroubleTicket::Priority::CRITICAL || status > TroubleTicket::Status::HOLD) {
+			damaged(path);
+		}
+		restore(TroubleTicket::restored(number, description, static_cast<TroubleTicket::Priority::Type>(priority),
+			static_cast<TroubleTicket::Status::Type>(status), resolution));
+	}
+	if (in.remaining() != 0) {
+		damaged(path);
+	}
+	return header;
+}
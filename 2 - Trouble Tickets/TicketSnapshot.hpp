@@ -0,0 +1,47 @@
+/**
+* File:		TicketSnapshot.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the snapshots of DurableStore: every held ticket in one compact binary file, with the
+*			sequence number of the last journal record it includes and the highest ticket number ever given. Tickets
+*			are written in the order they arrived, so reading them back into an empty TicketStore costs one pass over
+*			the file and O(1) a ticket on average, and tickets of the same priority are worked in the order they were
+*			before, even once some of them are reprioritized.
+*
+*			A snapshot is written to a temporary file, synced, and renamed over the last one, so there is always one
+*			whole snapshot on storage. It is read through a memory mapping, front to back, with a checksum over the
+*			whole file.
+*
+*			File layout (integers little-endian, text as a 32 bit length and then the bytes):
+*				"TKTSNAP1", sequence (64), last ticket number (64), ticket count (64)
+*				for each ticket: number (64), priority (8), status (8), description, resolution
+*				checksum of everything before it (32)
+*/
+
+#ifndef TICKET_SNAPSHOT_HPP
+#define TICKET_SNAPSHOT_HPP
+
+// includes
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+#include "TroubleTicket.hpp"
+
+namespace TicketSnapshot {
+	struct Header {
+		std::uint64_t	sequence = 0;		// last journal record included
+		unsigned long	lastNumber = 0;		// highest ticket number given so far
+		std::uint64_t	count = 0;			// tickets in the snapshot
+	};
+
+	// replace the snapshot at path with one of the tickets
+	void write(std::filesystem::path const & path, Header const & header, std::vector<TroubleTicket const *> const & tickets);
+
+	// call restore with each ticket of the snapshot at path, in the order written, and return its header. If there is
+	// no snapshot, returns an empty header. Throws std::runtime_error if the file is damaged
+	Header read(std::filesystem::path const & path, std::function<void(TroubleTicket &&)> const & restore);
+}
+
+#endif
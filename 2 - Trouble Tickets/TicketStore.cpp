@@ -0,0 +1,228 @@
+/**
+* File:		TicketStore.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Member function definitions for TicketStore, the indexed ticket queue described in TicketStore.hpp.
+*/
+
+#include "TicketStore.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+constexpr std::size_t TicketStore::StatusCount;
+
+// add a ticket to a free slot and sift it up to its place
+bool TicketStore::push(TroubleTicket ticket) {
+	const Id id = ticket.ticketNumber();
+	if (_byId.count(id) > 0) {
+		return false;
+	}
+
+	const TroubleTicket::Status::Type status = ticket.status();
+	std::size_t slot;
+	if (_free.empty()) {
+		slot = _slots.size();
+		_slots.push_back(Slot{ std::move(ticket), 0, _arrivals++ });
+	}
+	else {
+		slot = _free.back();
+		_free.pop_back();
+		_slots[slot].ticket = std::move(ticket);
+		_slots[slot].arrival = _arrivals++;
+	}
+
+	_byId.emplace(id, slot);
+	_byStatus[status].insert(id);
+
+	_heap.push_back(slot);
+	_slots[slot].position = _heap.size() - 1;
+	siftUp(_heap.size() - 1);
+	return true;
+}
+
+// look at the front of the heap
+TroubleTicket const & TicketStore::top() const {
+	return _slots[_heap.front()].ticket;
+}
+
+// take the front of the heap out
+void TicketStore::pop() {
+	remove(_heap.front());
+}
+
+// look the ticket up by number
+TroubleTicket const * TicketStore::find(Id id) const {
+	auto found = _byId.find(id);
+	return found == _byId.end() ? nullptr : &_slots[found->second].ticket;
+}
+
+// change the priority and sift the ticket whichever way it now belongs
+bool TicketStore::reprioritize(Id id, TroubleTicket::Priority::Type priority) {
+	auto found = _byId.find(id);
+	if (found == _byId.end()) {
+		return false;
+	}
+
+	Slot & slot = _slots[found->second];
+	const TroubleTicket::Priority::Type old = slot.ticket.priority();
+	slot.ticket.priority(priority);
+	if (priority > old) {
+		siftUp(slot.position);
+	}
+	else if (priority < old) {
+		siftDown(slot.position);
+	}
+	return true;
+}
+
+// change the status and move the ticket to the index of its new status
+bool TicketStore::update_status(Id id, TroubleTicket::Status::Type status) {
+	auto found = _byId.find(id);
+	if (found == _byId.end()) {
+		return false;
+	}
+
+	TroubleTicket & ticket = _slots[found->second].ticket;
+	if (ticket.status() != status) {
+		_byStatus[ticket.status()].erase(id);
+		_byStatus[status].insert(id);
+		ticket.status(status);
+	}
+	return true;
+}
+
+// the resolution changes nothing the heap or the indexes depend on
+bool TicketStore::update_resolution(Id id, std::string const & resolution) {
+	auto found = _byId.find(id);
+	if (found == _byId.end()) {
+		return false;
+	}
+
+	_slots[found->second].ticket.resolution(resolution);
+	return true;
+}
+
+// remove the ticket from wherever it is in the heap
+bool TicketStore::cancel(Id id) {
+	auto found = _byId.find(id);
+	if (found == _byId.end()) {
+		return false;
+	}
+
+	remove(found->second);
+	return true;
+}
+
+// size of the status index
+std::size_t TicketStore::count_by_status(TroubleTicket::Status::Type status) const {
+	return _byStatus[status].size();
+}
+
+// copy the status index out
+std::vector<TicketStore::Id> TicketStore::with_status(TroubleTicket::Status::Type status) const {
+	return std::vector<Id>(_byStatus[status].cbegin(), _byStatus[status].cend());
+}
+
+// sort a copy of the heap the way it pops
+std::vector<TroubleTicket const *> TicketStore::in_work_order() const {
+	std::vector<std::size_t> order(_heap);
+	std::sort(order.begin(), order.end(), [this](std::size_t lhs, std::size_t rhs) { return before(lhs, rhs); });
+
+	std::vector<TroubleTicket const *> tickets;
+	tickets.reserve(order.size());
+	for (auto slot : order) {
+		tickets.push_back(&_slots[slot].ticket);
+	}
+	return tickets;
+}
+
+// sort a copy of the heap by arrival
+std::vector<TroubleTicket const *> TicketStore::in_arrival_order() const {
+	std::vector<std::size_t> order(_heap);
+	std::sort(order.begin(), order.end(), [this](std::size_t lhs, std::size_t rhs) { return _slots[lhs].arrival < _slots[rhs].arrival; });
+
+	std::vector<TroubleTicket const *> tickets;
+	tickets.reserve(order.size());
+	for (auto slot : order) {
+		tickets.push_back(&_slots[slot].ticket);
+	}
+	return tickets;
+}
+
+// true if the ticket in one slot is worked before the ticket in another: higher priority first, then the older one
+bool TicketStore::before(std::size_t lhs, std::size_t rhs) const {
+	const Slot & left = _slots[lhs];
+	const Slot & right = _slots[rhs];
+	if (left.ticket.priority() != right.ticket.priority()) {
+		return left.ticket.priority() > right.ticket.priority();
+	}
+	return left.arrival < right.arrival;
+}
+
+// put a slot at a position in the heap, keeping the slot's note of where it is
+void TicketStore::place(std::size_t position, std::size_t slot) {
+	_heap[position] = slot;
+	_slots[slot].position = position;
+}
+
+// move the entry at a position up past every parent it should be worked before
+void TicketStore::siftUp(std::size_t position) {
+	const std::size_t slot = _heap[position];
+	while (position > 0) {
+		const std::size_t parent = (position - 1) / 2;
+		if (!before(slot, _heap[parent])) {
+			break;
+		}
+		place(position, _heap[parent]);
+		position = parent;
+	}
+	place(position, slot);
+}
+
+// move the entry at a position down past every child that should be worked before it
+void TicketStore::siftDown(std::size_t position) {
+	const std::size_t slot = _heap[position];
+	while (true) {
+		std::size_t child = 2 * position + 1;
+		if (child >= _heap.size()) {
+			break;
+		}
+		if (child + 1 < _heap.size() && before(_heap[child + 1], _heap[child])) {
+			++child;
+		}
+		if (!before(_heap[child], slot)) {
+			break;
+		}
+		place(position, _heap[child]);
+		position = child;
+	}
+	place(position, slot);
+}
+
+// take a slot out of the heap and the indexes and free it. The last entry of the heap fills the hole and is sifted from
+// there, up or down
+void TicketStore::remove(std::size_t slot) {
+	const std::size_t position = _slots[slot].position;
+	const std::size_t last = _heap.back();
+	_heap.pop_back();
+	if (last != slot) {
+		place(position, last);
+		if (position > 0 && before(last, _heap[(position - 1) / 2])) {
+			siftUp(position);
+		}
+		else {
+			siftDown(position);
+		}
+	}
+
+	TroubleTicket & ticket = _slots[slot].ticket;
+	_byId.erase(ticket.ticketNumber());
+	_byStatus[ticket.status()].erase(ticket.ticketNumber());
+
+	// the text isn't needed until the slot is reused
+	ticket.description(std::string());
+	ticket.resolution(std::string());
+	_free.push_back(slot);
+}
@@ -0,0 +1,99 @@
+/**
+* File:		TicketStore.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains a ticket container that, unlike std::queue, std::priority_queue and std::stack, can find a
+*			ticket by its number and escalate, update or cancel it where it is. Tickets sit in slots that never move; a binary
+*			heap of slot numbers orders them by priority, oldest first among equals, and each slot remembers where it is in
+*			the heap, so changing one ticket only sifts that one entry. Hash indexes map ticket numbers to slots and each
+*			status to the tickets that have it.
+*
+*			It has the push/top/pop/size interface of std::priority_queue, so it drops into simulateSession<T>.
+*
+*			Usage:
+*				TicketStore store;
+*				store.push(TroubleTicket("server down", TroubleTicket::Priority::LOW));
+*				store.reprioritize(id, TroubleTicket::Priority::CRITICAL);		// O(log n)
+*				store.cancel(id);												// O(log n)
+*				store.count_by_status(TroubleTicket::Status::NEW);				// O(1)
+*/
+
+#ifndef TICKET_STORE_HPP
+#define TICKET_STORE_HPP
+
+// includes
+#include <array>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "TroubleTicket.hpp"
+
+class TicketStore {
+public:
+	using Id = unsigned long;
+
+	static constexpr std::size_t StatusCount = TroubleTicket::Status::HOLD + 1;
+
+	// add a ticket, returning false (and leaving the store as it was) if a ticket with its number is already held. O(log n)
+	bool push(TroubleTicket ticket);
+
+	// the ticket with the highest priority, the oldest of them if several share it. The store must not be empty
+	TroubleTicket const & top() const;
+	void pop();
+
+	std::size_t size() const { return _heap.size(); }
+	bool empty() const { return _heap.empty(); }
+
+	// the held ticket with a number, or null if there isn't one. O(1)
+	TroubleTicket const * find(Id id) const;
+
+	// change a held ticket's priority, moving it up or down the queue. Returns false if the ticket isn't held. O(log n)
+	bool reprioritize(Id id, TroubleTicket::Priority::Type priority);
+
+	// change a held ticket's status. Returns false if the ticket isn't held. O(1)
+	bool update_status(Id id, TroubleTicket::Status::Type status);
+
+	// change a held ticket's resolution. Returns false if the ticket isn't held. O(1)
+	bool update_resolution(Id id, std::string const & resolution);
+
+	// take a ticket out of the queue wherever it is. Returns false if the ticket isn't held. O(log n)
+	bool cancel(Id id);
+
+	// the number of held tickets with a status, and their numbers in no particular order
+	std::size_t count_by_status(TroubleTicket::Status::Type status) const;
+	std::vector<Id> with_status(TroubleTicket::Status::Type status) const;
+
+	// every held ticket, in the order they would be popped. Pushing them in this order into an empty store gives the
+	// same order back, with each push O(1). O(n log n)
+	std::vector<TroubleTicket const *> in_work_order() const;
+
+	// every held ticket, oldest first. Pushing them in this order into an empty store gives the same order back, and
+	// keeps it after any later change, since tickets of a priority stay in the order they came in. Each push is O(1) on
+	// average. O(n log n)
+	std::vector<TroubleTicket const *> in_arrival_order() const;
+
+private:
+	struct Slot {
+		TroubleTicket		ticket;
+		std::size_t			position;		// where the slot is in the heap
+		unsigned long long	arrival;		// order pushed in, so tickets of the same priority are worked first in, first out
+	};
+
+	bool before(std::size_t lhs, std::size_t rhs) const;
+	void place(std::size_t position, std::size_t slot);
+	void siftUp(std::size_t position);
+	void siftDown(std::size_t position);
+	void remove(std::size_t slot);
+
+	std::vector<Slot>				_slots;
+	std::vector<std::size_t>		_free;				// slots of tickets taken out, to be reused
+	std::vector<std::size_t>		_heap;				// slot numbers, highest priority first
+	std::unordered_map<Id, std::size_t>	_byId;			// slot of each held ticket
+	std::array<std::unordered_set<Id>, StatusCount>	_byStatus;	// held tickets with each status
+	unsigned long long				_arrivals = 0;
+};
+
+#endif
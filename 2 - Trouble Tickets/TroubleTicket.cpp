@@ -13,27 +13,102 @@
 ******************************************************************************/
 
 
-#include <iostream>
-#include <sstream>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
 #include <string>
 
 #include "TroubleTicket.hpp"
 
+namespace
+{
+  //Output iterator that counts the characters written through it and stores none of them
+  struct Counter
+  {
+    using iterator_category = std::output_iterator_tag;
+    using value_type        = void;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = void;
+    using reference         = void;
+
+    std::size_t count = 0;
+
+    Counter & operator*  ()     {return *this;}
+    Counter & operator++ ()     {return *this;}
+    Counter   operator++ (int)  {return *this;}
+    Counter & operator=  (char) {++count; return *this;}
+  };
+}
+
+
 //Class attribute storage
-unsigned long TroubleTicket::ticketIDs = 0UL;
+std::atomic<unsigned long> TroubleTicket::ticketIDs{ 0UL };
+
+namespace
+{
+  //The block of ticket numbers this thread is handing out: next up to, but not including, end
+  thread_local unsigned long nextNumber = 0;
+  thread_local unsigned long endNumber  = 0;
+}
+
+
+//Ticket numbers are handed to each thread a block at a time, so threads creating tickets at the same time only meet at
+// the shared counter once per block. A program creating tickets on one thread still numbers them 1, 2, 3, ...
+unsigned long TroubleTicket::nextTicketNumber()
+{
+  static constexpr unsigned long block = 64;
+
+  if( nextNumber == endNumber )
+  {
+    nextNumber = ticketIDs.fetch_add( block, std::memory_order_relaxed ) + 1;
+    endNumber  = nextNumber + block;
+  }
+  return nextNumber++;
+}
+
+
+TroubleTicket TroubleTicket::restored( unsigned long ticketNumber, std::string_view description, Priority::Type priority,
+                                       Status::Type status, std::string_view resolution )
+{
+  TroubleTicket ticket( Restoring(), ticketNumber );
+  ticket._description.assign( description.data(), description.size() );
+  ticket._resolution.assign( resolution.data(), resolution.size() );
+  ticket._priority = priority;
+  ticket._status   = status;
+  return ticket;
+}
+
+
+//Raises the shared counter past the number, and lets go of this thread's block if it could hand out the number or one
+// below it. Blocks other threads already hold are theirs to use up, so this belongs before they create tickets.
+void TroubleTicket::continueAfter( unsigned long ticketNumber )
+{
+  unsigned long last = ticketIDs.load();
+  while( last < ticketNumber && ! ticketIDs.compare_exchange_weak( last, ticketNumber ) )
+  {}
+
+  if( nextNumber <= ticketNumber )
+  {
+    nextNumber = endNumber = 0;
+  }
+}
 
 
 //Member function definitions
 std::string  TroubleTicket::toString() const
 {
-  std::ostringstream temp;
+  std::string temp( formatted_size(), '\0' );
+  format_to( temp.data() );
+  return temp;
+}
+
 
-  temp  << "ID=" << _ticketNumber << ", Priority=" << _priority << ", Status=" << _status << '\n'
-        << "Description:\n" << _description << '\n';
 
-  if( ! _resolution.empty() )  temp  << "Resolution:\n" << _resolution << '\n';
 
-  return temp.str();
+
+std::size_t  TroubleTicket::formatted_size() const
+{
+  return format_to( Counter() ).count;
 }
 
 
@@ -42,14 +117,7 @@ std::string  TroubleTicket::toString() const
 
 std::string TroubleTicket::Priority::toString(Type p)
 {
-  //The problem with this implementation is keeping the names of the enumerated types in sync with the
-  // order and number of enumeration values.  There are better ways to do this.
-  static char const * names[] = 
-  {
-    "None", "Low", "Normal", "High", "Critical", nullptr
-  };
-
-  return names[p];
+  return std::string( name( p ) );
 }
 
 
@@ -58,11 +126,5 @@ std::string TroubleTicket::Priority::toString(Type p)
 
 std::string TroubleTicket::Status::toString(Type s)
 {
-  static char const * names[] = 
-  {
-    "New", "Open", "In Work", "Resolved", "Verified", "Closed", "Rejected", "Hold", nullptr
-  };
-
-  return names[s];
+  return std::string( name( s ) );
 }
-
@@ -16,8 +16,14 @@
 #ifndef TROUBLE_TICKET_HPP
 #define TROUBLE_TICKET_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
 #include <string>
+#include <string_view>
 
 class TroubleTicket
 {
@@ -26,6 +32,10 @@ class TroubleTicket
     struct Priority  // Scoped enumeration with functions
     {
       enum Type{ NONE, LOW, NORMAL, HIGH, CRITICAL };
+      static constexpr std::string_view names[] = { "None", "Low", "Normal", "High", "Critical" };
+      static_assert( std::size(names) == CRITICAL + 1, "a name for each priority" );
+
+      static constexpr std::string_view name(Type priority) {return names[priority];}
       static std::string toString(Type priority);
       
       Priority()                              = delete;
@@ -38,6 +48,10 @@ class TroubleTicket
     struct Status // Scoped enumeration with functions
     {
       enum Type{ NEW, OPEN, IN_WORK, RESOLVED, VERIFIED, CLOSED, REJECTED, HOLD };
+      static constexpr std::string_view names[] = { "New", "Open", "In Work", "Resolved", "Verified", "Closed", "Rejected", "Hold" };
+      static_assert( std::size(names) == HOLD + 1, "a name for each status" );
+
+      static constexpr std::string_view name(Type status) {return names[status];}
       static std::string toString(Type status);
 
       Status()                            = delete;
@@ -63,10 +77,23 @@ class TroubleTicket
       : _description  ( description ), 
         _priority     ( priority ), 
         _status       ( status ), 
-        _ticketNumber ( ++ticketIDs )
+        _ticketNumber ( nextTicketNumber() )
     {}
 
 
+    // A ticket brought back from storage keeps the number it was given and uses up no new one.  Once every stored
+    // ticket is back, continueAfter(the highest number ever given) makes sure new tickets are numbered after them all.
+    static TroubleTicket restored
+    (
+      unsigned long                 ticketNumber,
+      std::string_view              description,
+      Priority::Type                priority,
+      Status::Type                  status,
+      std::string_view              resolution
+    );
+    static void continueAfter( unsigned long ticketNumber );
+
+
 
 
     // Logical operators
@@ -80,8 +107,8 @@ class TroubleTicket
 
 
     // Queries/getters
-    std::string     description() const {return _description;}
-    std::string     resolution()  const {return _resolution;}
+    std::string_view description() const {return _description;}
+    std::string_view resolution()  const {return _resolution;}
     Priority::Type  priority()    const {return _priority;}
     Status::Type    status()      const {return _status;}
     unsigned long   ticketNumber()const {return _ticketNumber;}
@@ -98,7 +125,24 @@ class TroubleTicket
     // misc
     std::string  toString() const;
 
+    // The text of toString written through an output iterator without allocating anything.  A char pointer into a
+    // buffer at least formatted_size() long is the fastest, as each piece is copied in one go.  Returns the iterator
+    // past the last character written.
+    template<class OutputIterator>
+    OutputIterator  format_to( OutputIterator out ) const;
+    std::size_t     formatted_size() const;
+
   private:
+    struct Restoring {};
+    TroubleTicket( Restoring, unsigned long ticketNumber )
+      : _priority( Priority::NORMAL ), _status( Status::NEW ), _ticketNumber( ticketNumber )
+    {}
+
+    template<class OutputIterator>
+    static OutputIterator write( OutputIterator out, std::string_view text );
+    template<class OutputIterator>
+    static OutputIterator write( OutputIterator out, unsigned long number );
+
     // Instance attributes
     std::string     _description; // description of the problem
     std::string     _resolution;  // description of the resolution to the problem
@@ -107,16 +151,61 @@ class TroubleTicket
     unsigned long   _ticketNumber;
 
     // Class attributes
-    static unsigned long ticketIDs;
+    static std::atomic<unsigned long> ticketIDs;     // last ticket number reserved by any thread
+    static unsigned long nextTicketNumber();
 };
 
 
 
 
+template<class OutputIterator>
+OutputIterator TroubleTicket::format_to( OutputIterator out ) const
+{
+  out = write( out, "ID=" );
+  out = write( out, _ticketNumber );
+  out = write( out, ", Priority=" );
+  out = write( out, Priority::name( _priority ) );
+  out = write( out, ", Status=" );
+  out = write( out, Status::name( _status ) );
+  out = write( out, "\nDescription:\n" );
+  out = write( out, _description );
+  *out = '\n';
+  ++out;
+
+  if( ! _resolution.empty() )
+  {
+    out = write( out, "Resolution:\n" );
+    out = write( out, _resolution );
+    *out = '\n';
+    ++out;
+  }
+
+  return out;
+}
+
+
+template<class OutputIterator>
+OutputIterator TroubleTicket::write( OutputIterator out, std::string_view text )
+{
+  return std::copy( text.begin(), text.end(), out );
+}
+
+
+template<class OutputIterator>
+OutputIterator TroubleTicket::write( OutputIterator out, unsigned long number )
+{
+  char digits[20];  // enough for a 64 bit number
+  auto const result = std::to_chars( digits, digits + sizeof( digits ), number );
+  return std::copy( digits, result.ptr, out );
+}
+
+
+
+
 inline
 std::ostream & operator << (std::ostream & stream, TroubleTicket const & theTicket)
 {
-  stream << theTicket.toString();
+  theTicket.format_to( std::ostreambuf_iterator<char>( stream ) );
   return stream;
 }
 
@@ -124,7 +213,7 @@ std::ostream & operator << (std::ostream & stream, TroubleTicket const & theTick
 inline
 std::ostream & operator << (std::ostream & stream, TroubleTicket::Priority::Type const & priority)
 {
-  stream << TroubleTicket::Priority::toString(priority);
+  stream << TroubleTicket::Priority::name(priority);
   return stream;
 }
 
@@ -132,7 +221,7 @@ std::ostream & operator << (std::ostream & stream, TroubleTicket::Priority::Type
 inline
 std::ostream & operator << (std::ostream & stream, TroubleTicket::Status::Type const & status)
 {
-  stream << TroubleTicket::Status::toString(status);
+  stream << TroubleTicket::Status::name(status);
   return stream;
 }
 
@@ -0,0 +1,163 @@
+/**
+* File:		Workload.cpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	Member function definitions for Workload, the ticket queue load described in Workload.hpp.
+*/
+
+#include "Workload.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// the defaults, with another seed
+Workload Workload::fromSeed(unsigned long seed) {
+	Workload workload;
+	workload.seed = seed;
+	return workload;
+}
+
+// one line at a time: blank lines and comments are skipped, lines with an = set a parameter, anything else is a trace
+// line
+Workload Workload::read(std::istream & stream) {
+	Workload workload;
+	std::size_t number = 0;
+	for (std::string line; std::getline(stream, line); ) {
+		++number;
+		line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+
+		try {
+			const std::size_t equals = line.find('=');
+			if (equals != std::string::npos) {
+				std::istringstream name(line.substr(0, equals));
+				std::istringstream values(line.substr(equals + 1));
+				std::string word;
+				name >> word;
+				workload.set(word, values);
+				continue;
+			}
+
+			std::istringstream fields(line);
+			Operation operation{ Operation::WORK, TroubleTicket::Priority::NONE, 0, 0 };
+			std::string kind;
+			if (!(fields >> operation.time)) {
+				if (fields.eof()) {
+					continue;	// nothing but spaces
+				}
+				throw std::invalid_argument("expected a time");
+			}
+			fields >> kind;
+			if (kind == "create") {
+				int priority = -1;
+				if (!(fields >> priority >> operation.length) || priority < 0 || priority >= static_cast<int>(Priorities)) {
+					throw std::invalid_argument("expected a priority from 0 to 4 and a description length");
+				}
+				operation.kind = Operation::CREATE;
+				operation.priority = static_cast<TroubleTicket::Priority::Type>(priority);
+			}
+			else if (kind != "work") {
+				throw std::invalid_argument("expected create or work");
+			}
+			workload.trace.push_back(operation);
+		}
+		catch (std::invalid_argument const & error) {
+			throw std::invalid_argument("workload line " + std::to_string(number) + ": " + error.what());
+		}
+	}
+
+	workload.check();
+	return workload;
+}
+
+// the trace, or a Poisson process: creates arrive at arrivalRate, so all operations arrive at arrivalRate / createRatio
+std::vector<Workload::Operation> Workload::operations() const {
+	if (!trace.empty()) {
+		return trace;
+	}
+
+	std::mt19937_64 random(seed);
+	std::exponential_distribution<double> gap(arrivalRate / createRatio);
+	std::bernoulli_distribution create(createRatio);
+	std::discrete_distribution<int> priority(priorityMix.begin(), priorityMix.end());
+	std::uniform_int_distribution<std::size_t> length(minLength, maxLength);
+
+	std::vector<Operation> operations;
+	operations.reserve(count);
+	double time = 0;
+	for (std::size_t i = 0; i < count; ++i) {
+		time += gap(random);
+		if (create(random)) {
+			operations.push_back(Operation{ Operation::CREATE, static_cast<TroubleTicket::Priority::Type>(priority(random)), length(random), time });
+		}
+		else {
+			operations.push_back(Operation{ Operation::WORK, TroubleTicket::Priority::NONE, 0, time });
+		}
+	}
+	return operations;
+}
+
+// the bound, or the longest the trace has
+std::size_t Workload::longestDescription() const {
+	if (trace.empty()) {
+		return maxLength;
+	}
+	std::size_t longest = 0;
+	for (auto const & operation : trace) {
+		longest = std::max(longest, operation.length);
+	}
+	return longest;
+}
+
+// read the values of one parameter
+void Workload::set(std::string const & name, std::istream & values) {
+	if (name == "seed") {
+		values >> seed;
+	}
+	else if (name == "operations") {
+		values >> count;
+	}
+	else if (name == "arrival_rate") {
+		values >> arrivalRate;
+	}
+	else if (name == "create_ratio") {
+		values >> createRatio;
+	}
+	else if (name == "priority_mix") {
+		for (auto & weight : priorityMix) {
+			values >> weight;
+		}
+	}
+	else if (name == "description_length") {
+		values >> minLength >> maxLength;
+	}
+	else {
+		throw std::invalid_argument("unknown parameter " + name);
+	}
+
+	std::string extra;
+	if (values.fail() || values >> extra) {
+		throw std::invalid_argument("bad value for " + name);
+	}
+}
+
+// parameters that can't make a workload
+void Workload::check() const {
+	if (!(arrivalRate > 0)) {
+		throw std::invalid_argument("arrival_rate must be more than 0");
+	}
+	if (!(createRatio > 0 && createRatio <= 1)) {
+		throw std::invalid_argument("create_ratio must be more than 0 and at most 1");
+	}
+	if (std::any_of(priorityMix.begin(), priorityMix.end(), [](double weight) { return weight < 0; })
+		|| std::accumulate(priorityMix.begin(), priorityMix.end(), 0.0) <= 0) {
+		throw std::invalid_argument("priority_mix weights must not be negative, and not all 0");
+	}
+	if (minLength > maxLength) {
+		throw std::invalid_argument("description_length must be the shortest, then the longest");
+	}
+}
@@ -0,0 +1,76 @@
+/**
+* File:		Workload.hpp
+* Author:	Ryan Johnson
+* Email:	johnsonrw82@cs.fullerton.edu
+* Purpose:	This file contains the description of a load on the ticket queues, and the sequence of operations it makes.
+*			A workload is read from a file of "name = value" lines, or made from defaults and a seed:
+*				seed = 42
+*				operations = 1000000			# creates and works together
+*				arrival_rate = 50				# tickets created per second
+*				create_ratio = 0.55				# fraction of operations that create a ticket; the rest work one
+*				priority_mix = 10 30 40 15 5	# relative weights of None, Low, Normal, High, Critical
+*				description_length = 20 200		# shortest and longest description, uniformly between
+*			Operations arrive at random, as a Poisson process, so each gets a time in seconds from the start.
+*
+*			A file can instead hold a recorded trace to replay exactly, one operation a line:
+*				0.013 create 3 57				# time, priority number, description length
+*				0.020 work
+*			Lines starting with # are comments.
+*
+*			Usage:
+*				Workload workload = Workload::fromSeed(7);
+*				std::vector<Workload::Operation> operations = workload.operations();
+*/
+
+#ifndef WORKLOAD_HPP
+#define WORKLOAD_HPP
+
+// includes
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "TroubleTicket.hpp"
+
+class Workload {
+public:
+	static constexpr std::size_t Priorities = TroubleTicket::Priority::CRITICAL + 1;
+
+	struct Operation {
+		enum Kind { CREATE, WORK };
+
+		Kind							kind;
+		TroubleTicket::Priority::Type	priority;		// of a ticket created
+		std::size_t						length;			// of its description
+		double							time;			// seconds from the start
+	};
+
+	// the defaults above, generated from a seed
+	static Workload fromSeed(unsigned long seed);
+
+	// parameters, a trace, or both (the trace wins). Throws std::invalid_argument naming the line of anything it can't read
+	static Workload read(std::istream & stream);
+
+	// the trace, or else the operations the parameters generate. The same workload always gives the same operations
+	std::vector<Operation> operations() const;
+
+	// longest description any operation asks for
+	std::size_t longestDescription() const;
+
+	unsigned long						seed = 42;
+	std::size_t							count = 1000000;		// operations generated
+	double								arrivalRate = 50;
+	double								createRatio = 0.55;
+	std::array<double, Priorities>		priorityMix = { { 10, 30, 40, 15, 5 } };
+	std::size_t							minLength = 20;		// of descriptions
+	std::size_t							maxLength = 200;
+	std::vector<Operation>				trace;
+
+private:
+	void set(std::string const & name, std::istream & values);
+	void check() const;
+};
+
+#endif
@@ -5,12 +5,24 @@
 * Purpose:	
 */
 
+#include "BucketQueue.hpp"
+#include "DurableStore.hpp"
+#include "LoadDriver.hpp"
+#include "TicketIndex.hpp"
+#include "TicketLog.hpp"
+#include "TicketStore.hpp"
 #include "TroubleTicket.hpp"
+#include "Workload.hpp"
 
+#include <fstream>
+#include <optional>
 #include <queue>
 #include <stack>
+#include <stdexcept>
 #include <string>
 #include <typeinfo>
+#include <utility>
+#include <vector>
 
 // anonymous namespace
 namespace {
@@ -41,7 +53,7 @@ namespace {
 
 	// template function to create a ticket and insert it into the container
 	template<typename T>
-	void createTicket(T & container) {
+	void createTicket(T & container, TicketLog & log, TicketIndex & index) {
 		std::string response;
 		TroubleTicket::Priority::Type priority;
 
@@ -91,8 +103,9 @@ namespace {
 		if ( std::cin ) {
 			TroubleTicket t(desc, priority);
 			container.push(t);
+			index.add(t);
 			// log the ticket
-			std::clog << "Inserted: " << t << '\n';
+			log.record("Inserted", t);
 		}
 		else {
 			std::cerr << "Bad input, try again!\n";
@@ -101,15 +114,48 @@ namespace {
 
 	// template function to pull a ticket from the container and work it
 	template<typename T>
-	void workTicket(T & container) {
+	void workTicket(T & container, TicketLog & log, TicketIndex & index) {
 		// if a ticket is in the container
 		if (container.size() > 0) {
 			// peek at it
 			const TroubleTicket t = peek(container);
 			// pop it off
 			container.pop();
+			// it stays searchable, as a closed ticket
+			index.update_status(t.ticketNumber(), TroubleTicket::Status::CLOSED);
 			// log the removal
-			std::clog << "Removed: " << t << '\n';
+			log.record("Removed", t);
+		}
+	}
+
+	// ask the user for words and list the tickets, open or worked, whose text has them in that order
+	void searchTickets(TicketIndex const & index) {
+		std::string words;
+		std::cout << "Enter words to search for:\n";
+
+		// ignore any newlines in the stream
+		std::cin.ignore();
+		std::getline(std::cin, words);
+		if (std::cin) {
+			const std::vector<TicketIndex::Id> found = index.with_phrase(words);
+			std::cout << found.size() << " tickets found:";
+			for (auto id : found) {
+				std::cout << ' ' << id;
+			}
+			std::cout << "\n\n";
+		}
+		else {
+			std::cerr << "Bad input, try again!\n";
+		}
+	}
+
+	// index the tickets a container starts with. Only a store kept on storage has any: what it recovered, as they are now
+	template<typename T>
+	void indexHeld(T const &, TicketIndex &) {}
+
+	void indexHeld(DurableStore const & store, TicketIndex & index) {
+		for (auto ticket : store.in_work_order()) {
+			index.add(*ticket);
 		}
 	}
 
@@ -119,15 +165,19 @@ namespace {
 		std::cout << "1. Enter a Ticket\n";
 		std::cout << "2. Work a Ticket\n";
 		std::cout << "3. Quit\n";
+		std::cout << "4. Search Tickets\n";
 		std::cout << "Your choice: ";
 	}
 
-	// template function to simulate a work session
-	template<typename T>
-	void simulateSession() {
+	// template function to simulate a work session. Any arguments are passed to the container's constructor
+	template<typename T, typename... Args>
+	void simulateSession(Args &&... args) {
 		std::clog << "Simulating ticket session using: " << typeid(T).name() << "\n\n";
 
-		T container;
+		T container(std::forward<Args>(args)...);
+		TicketLog log(std::clog);
+		TicketIndex index;
+		indexHeld(container, index);
 		std::string response;
 		while (response != "3") {
 			std::cout << "Container contains " << container.size() << " tickets.\n\n";
@@ -137,7 +187,7 @@ namespace {
 
 			// create
 			if (response == "1") {
-				createTicket(container);
+				createTicket(container, log, index);
 			}
 			// work
 			else if (response == "2") {
@@ -145,9 +195,13 @@ namespace {
 					std::cerr << "No tickets remain!\n";
 				}
 				else {
-					workTicket(container);
+					workTicket(container, log, index);
 				}
 			}
+			// search
+			else if (response == "4") {
+				searchTickets(index);
+			}
 			// finish
 			else if (response != "3") {
 				std::cerr << "Invalid option!\n";
@@ -156,13 +210,77 @@ namespace {
 
 		std::cout << "Done!\n\n";
 	}
+
+	// scripted mode: play a workload against every container and report on it. Options, each followed by a value:
+	//	--workload file		parameters or a trace, as described in Workload.hpp
+	//	--seed n			generate the default workload from a seed
+	//	--operations n		number of operations to generate
+	// The seed and number of operations override a workload file's, in whichever order they're given
+	int replay(int argc, char * argv[]) {
+		try {
+			// a file gives the whole workload, so the seed and count given are applied after it, wherever they came
+			Workload workload;
+			std::optional<unsigned long> seed;
+			std::optional<std::size_t> count;
+			for (int i = 1; i < argc; ++i) {
+				const std::string option = argv[i];
+				if (i + 1 >= argc) {
+					throw std::invalid_argument("missing value for " + option);
+				}
+				const std::string value = argv[++i];
+
+				if (option == "--workload") {
+					std::ifstream file(value);
+					if (!file) {
+						throw std::invalid_argument("can't open " + value);
+					}
+					workload = Workload::read(file);
+				}
+				else if (option == "--seed") {
+					seed = std::stoul(value);
+				}
+				else if (option == "--operations") {
+					count = std::stoul(value);
+				}
+				else {
+					throw std::invalid_argument("unknown option " + option);
+				}
+			}
+			if (seed) {
+				workload.seed = *seed;
+			}
+			if (count) {
+				workload.count = *count;
+			}
+
+			LoadDriver driver(workload);
+			driver.run<std::queue<TroubleTicket>>("queue");
+			driver.run<std::priority_queue<TroubleTicket>>("priority_queue");
+			driver.run<TicketStore>("ticket_store");
+			driver.run<BucketQueue>("bucket_queue");
+			driver.run<std::stack<TroubleTicket>>("stack");
+			driver.report(std::cout);
+		}
+		catch (std::exception const & error) {
+			std::cerr << error.what() << '\n';
+			return 1;
+		}
+		return 0;
+	}
 }
 
-// main function
-int main() {
+// main function. With options it runs a workload instead of asking for one; see replay
+int main(int argc, char * argv[]) {
+	if (argc > 1) {
+		return replay(argc, argv);
+	}
+
 	// simulate sessions
 	simulateSession<std::queue<TroubleTicket>>();
 	simulateSession<std::priority_queue<TroubleTicket>>();
+	simulateSession<TicketStore>();
+	simulateSession<BucketQueue>();
+	simulateSession<DurableStore>("tickets");
 	simulateSession<std::stack<TroubleTicket>>();
 
 	return 0;